@@ -0,0 +1,63 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <chrono>
+#include "World.h"
+#include "System.h"
+
+///==== Benchmark Fixture ====
+
+///What most benchmarks have in common: the Position and Velocity components every one of them moves entities with, a system over both,
+///a world of such entities, and the timers the rows are measured with. Benchmarks with components of their own declare them next to their main().
+
+struct Position : EntitySystem::Component<Position>
+{
+    Position(float x, float y) : x(x), y(y) {}
+    float x, y;
+};
+
+struct Velocity : EntitySystem::Component<Velocity>
+{
+    Velocity(float x, float y) : x(x), y(y) {}
+    float x, y;
+};
+
+//Registers every entity with a Position and a Velocity, so that adding, removing and destroying them costs what it would with a real movement system.
+class MovementSystem : public EntitySystem::System
+{
+public:
+    MovementSystem()
+    {
+        signature.AddComponent<Position>();
+        signature.AddComponent<Velocity>();
+    }
+};
+
+inline double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline double NanosecondsPerEntity(std::chrono::steady_clock::time_point start, unsigned int entityCount)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / entityCount;
+}
+
+//Creates "entityCount" entities, spread along the x axis, all moving with the same velocity.
+inline std::vector<EntitySystem::Entity> Populate(EntitySystem::World& world, unsigned int entityCount)
+{
+    std::vector<EntitySystem::Entity> entities = world.CreateEntities(entityCount);
+    for (unsigned int i = 0; i < entityCount; i++)
+    {
+        world.AddComponent(entities[i], Position(float(i), 0.0f));
+        world.AddComponent(entities[i], Velocity(1.0f, 1.0f));
+    }
+    return entities;
+}
+
+//A world with a MovementSystem, not initialized yet, so that callers can register more before Initialize().
+inline std::unique_ptr<EntitySystem::World> MakeWorld()
+{
+    std::unique_ptr<EntitySystem::World> world = std::make_unique<EntitySystem::World>(std::make_unique<EntitySystem::EntityManager>());
+    world->AddSystem(std::make_unique<MovementSystem>());
+    return world;
+}
@@ -0,0 +1,360 @@
+#include "ECSPrecompiledHeader.h"
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include "EntityHandle.h"
+#include "BenchmarkFixture.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+///==== Benchmark Suite ====
+
+///Runs every core operation of the engine at several scales, for tracking regressions over time:
+///create_destroy / create_destroy_bulk: creating N entities and destroying them again, one at a time or through CreateEntities() / DestroyEntities().
+///add_remove_component: adding a component to N entities and removing it again.
+///unpack: Unpack() of two components for each of N entities.
+///iterate_single / iterate_multi: a view over one component, and over two components where one entity in four lacks the second one.
+///update_K_systems: World::Update() with K systems that all read the components of every entity.
+
+///Output is CSV on stdout, one row per benchmark, storage mode and entity count:
+///benchmark,storage,entities,operations,ns_per_op,ops_per_sec,peak_rss_kb
+///An operation is one entity (or one entity for one system, for updates). Short benchmarks are repeated until they have run for at least --min-time-ms.
+///peak_rss_kb is the peak resident memory while the benchmark ran, setup included. Only Linux can reset the peak between benchmarks, elsewhere it is the peak of the run so far.
+
+///Options:
+///--entities=1000,10000,100000,1000000   Entity counts to run every benchmark with.
+///--storage=pools|archetypes|all         Storage modes to run (pools by default).
+///--filter=text                          Only runs the benchmarks whose name contains the text.
+///--min-time-ms=200
+
+using namespace EntitySystem;
+
+//Only reads, so that the systems of update_K_systems can be scheduled in parallel, and the benchmark measures the scheduler rather than write conflicts.
+class ReaderSystem : public System
+{
+public:
+    ReaderSystem()
+    {
+        signature.AddComponent<Position>();
+        signature.AddComponent<Velocity>();
+        Reads<Position>();
+        Reads<Velocity>();
+    }
+
+    void Update(int deltaTime) override
+    {
+        float total = 0.0f;
+        Each<const Position, const Velocity>([&total](const Position& position, const Velocity& velocity) { total += position.x * velocity.x; });
+        sum += total;
+    }
+
+    float sum = 0.0f;
+};
+
+struct Measurement
+{
+    uint64_t operations = 0;
+    double nanoseconds = 0.0;
+};
+
+struct Options
+{
+    std::vector<unsigned int> entityCounts = { 1000, 10000, 100000, 1000000 };
+    std::vector<StorageMode> storageModes = { StorageMode::ComponentPools };
+    std::string filter;
+    double minimumMilliseconds = 200.0;
+};
+
+static Options options;
+
+//Runs "body" (which returns the number of operations it did) until it has run for long enough for the clock to be accurate, but at least once.
+static Measurement Repeat(const std::function<uint64_t()>& body)
+{
+    Measurement measurement;
+    auto start = std::chrono::steady_clock::now();
+    do
+    {
+        measurement.operations += body();
+        measurement.nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    } while (measurement.nanoseconds < options.minimumMilliseconds * 1e6);
+    return measurement;
+}
+
+static std::vector<Entity> Populate(World& world, unsigned int entityCount, bool withVelocity)
+{
+    std::vector<Entity> entities = world.CreateEntities(entityCount);
+    for (unsigned int i = 0; i < entityCount; i++)
+    {
+        world.AddComponent(entities[i], Position(float(i), 0.0f));
+        if (withVelocity && i % 4 != 0)
+        {
+            world.AddComponent(entities[i], Velocity(1.0f, 1.0f));
+        }
+    }
+    return entities;
+}
+
+static Measurement CreateDestroy(StorageMode storageMode, unsigned int entityCount)
+{
+    World world(std::make_unique<EntityManager>(), storageMode);
+    std::vector<Entity> entities(entityCount);
+    return Repeat([&]()
+    {
+        for (unsigned int i = 0; i < entityCount; i++)
+        {
+            entities[i] = world.CreateEntity().entity;
+        }
+        for (unsigned int i = 0; i < entityCount; i++)
+        {
+            world.DestroyEntity(entities[i]);
+        }
+        return uint64_t(entityCount) * 2;
+    });
+}
+
+static Measurement CreateDestroyBulk(StorageMode storageMode, unsigned int entityCount)
+{
+    World world(std::make_unique<EntityManager>(), storageMode);
+    return Repeat([&]()
+    {
+        std::vector<Entity> entities = world.CreateEntities(entityCount);
+        world.DestroyEntities(entities);
+        return uint64_t(entityCount) * 2;
+    });
+}
+
+static Measurement AddRemoveComponent(StorageMode storageMode, unsigned int entityCount)
+{
+    World world(std::make_unique<EntityManager>(), storageMode);
+    std::vector<Entity> entities = Populate(world, entityCount, false);
+    return Repeat([&]()
+    {
+        for (Entity entity : entities)
+        {
+            world.AddComponent(entity, Velocity(1.0f, 1.0f));
+        }
+        for (Entity entity : entities)
+        {
+            world.RemoveComponent<Velocity>(entity);
+        }
+        return uint64_t(entityCount) * 2;
+    });
+}
+
+static Measurement Unpack(StorageMode storageMode, unsigned int entityCount)
+{
+    World world(std::make_unique<EntityManager>(), storageMode);
+    std::vector<Entity> entities = world.CreateEntities(entityCount);
+    for (Entity entity : entities)
+    {
+        world.AddComponent(entity, Position(1.0f, 0.0f));
+        world.AddComponent(entity, Velocity(1.0f, 1.0f));
+    }
+
+    float sum = 0.0f;
+    Measurement measurement = Repeat([&]()
+    {
+        for (Entity entity : entities)
+        {
+            ComponentHandle<const Position> position;
+            ComponentHandle<const Velocity> velocity;
+            world.Unpack(entity, position, velocity);
+            sum += position->x * velocity->x;
+        }
+        return uint64_t(entityCount);
+    });
+
+    if (sum == 0.0f)
+    {
+        std::cerr << "unpack: nothing was read." << std::endl;
+    }
+    return measurement;
+}
+
+static Measurement IterateSingle(StorageMode storageMode, unsigned int entityCount)
+{
+    World world(std::make_unique<EntityManager>(), storageMode);
+    Populate(world, entityCount, false);
+    return Repeat([&]()
+    {
+        world.View<Position>().Each([](Position& position) { position.x += 1.0f; });
+        return uint64_t(entityCount);
+    });
+}
+
+static Measurement IterateMulti(StorageMode storageMode, unsigned int entityCount)
+{
+    World world(std::make_unique<EntityManager>(), storageMode);
+    Populate(world, entityCount, true);
+    return Repeat([&]()
+    {
+        world.View<Position, const Velocity>().Each([](Position& position, const Velocity& velocity)
+        {
+            position.x += velocity.x;
+            position.y += velocity.y;
+        });
+        return uint64_t(entityCount);
+    });
+}
+
+static Measurement UpdateSystems(StorageMode storageMode, unsigned int entityCount, unsigned int systemCount)
+{
+    World world(std::make_unique<EntityManager>(), storageMode);
+    world.SetSchedulerMode(SchedulerMode::Parallel);
+    for (unsigned int i = 0; i < systemCount; i++)
+    {
+        world.AddSystem(std::make_unique<ReaderSystem>());
+    }
+    world.Initialize();
+
+    std::vector<Entity> entities = world.CreateEntities(entityCount);
+    for (Entity entity : entities)
+    {
+        world.AddComponent(entity, Position(1.0f, 0.0f));
+        world.AddComponent(entity, Velocity(1.0f, 1.0f));
+    }
+
+    return Repeat([&]()
+    {
+        world.Update(16);
+        return uint64_t(entityCount) * systemCount;
+    });
+}
+
+//Lets the next benchmark report its own peak, rather than the largest of every benchmark run before it.
+static void ResetPeakMemory()
+{
+#ifdef __linux__
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+static uint64_t GetPeakMemoryKilobytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize / 1024;
+#else
+#ifdef __linux__
+    //VmHWM is the peak that /proc/self/clear_refs resets, ru_maxrss is not.
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            return std::stoull(line.substr(6));
+        }
+    }
+#endif
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#endif
+}
+
+static std::vector<unsigned int> ParseCounts(const std::string& text)
+{
+    std::vector<unsigned int> counts;
+    std::stringstream stream(text);
+    std::string count;
+    while (std::getline(stream, count, ','))
+    {
+        counts.push_back(static_cast<unsigned int>(std::stoul(count)));
+    }
+    return counts;
+}
+
+static bool ParseOptions(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        size_t equals = argument.find('=');
+        std::string name = argument.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : argument.substr(equals + 1);
+
+        if (name == "--entities")
+        {
+            options.entityCounts = ParseCounts(value);
+        }
+        else if (name == "--storage" && (value == "pools" || value == "archetypes" || value == "all"))
+        {
+            options.storageModes.clear();
+            if (value != "archetypes")
+            {
+                options.storageModes.push_back(StorageMode::ComponentPools);
+            }
+            if (value != "pools")
+            {
+                options.storageModes.push_back(StorageMode::Archetypes);
+            }
+        }
+        else if (name == "--filter")
+        {
+            options.filter = value;
+        }
+        else if (name == "--min-time-ms")
+        {
+            options.minimumMilliseconds = std::stod(value);
+        }
+        else
+        {
+            std::cerr << "Unknown option " << argument << ". Options: --entities=1000,10000 --storage=pools|archetypes|all --filter=text --min-time-ms=200" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (!ParseOptions(argc, argv))
+    {
+        return 1;
+    }
+
+    using Benchmark = std::function<Measurement(StorageMode, unsigned int)>;
+    const std::vector<std::pair<std::string, Benchmark>> benchmarks =
+    {
+        { "create_destroy", CreateDestroy },
+        { "create_destroy_bulk", CreateDestroyBulk },
+        { "add_remove_component", AddRemoveComponent },
+        { "unpack", Unpack },
+        { "iterate_single", IterateSingle },
+        { "iterate_multi", IterateMulti },
+        { "update_1_systems", [](StorageMode storageMode, unsigned int entityCount) { return UpdateSystems(storageMode, entityCount, 1); } },
+        { "update_8_systems", [](StorageMode storageMode, unsigned int entityCount) { return UpdateSystems(storageMode, entityCount, 8); } },
+    };
+
+    std::cout << "benchmark,storage,entities,operations,ns_per_op,ops_per_sec,peak_rss_kb" << std::endl;
+    for (const auto& [name, benchmark] : benchmarks)
+    {
+        if (name.find(options.filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        for (StorageMode storageMode : options.storageModes)
+        {
+            for (unsigned int entityCount : options.entityCounts)
+            {
+                ResetPeakMemory();
+                Measurement measurement = benchmark(storageMode, entityCount);
+                double nanosecondsPerOperation = measurement.nanoseconds / double(measurement.operations);
+
+                std::cout << name << "," << (storageMode == StorageMode::ComponentPools ? "pools" : "archetypes") << "," << entityCount << "," << measurement.operations << ","
+                    << nanosecondsPerOperation << "," << 1e9 / nanosecondsPerOperation << "," << GetPeakMemoryKilobytes() << std::endl;
+            }
+        }
+    }
+}
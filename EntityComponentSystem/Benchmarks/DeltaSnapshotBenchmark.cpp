@@ -0,0 +1,142 @@
+#include "ECSPrecompiledHeader.h"
+#include <random>
+#include "EntityHandle.h"
+#include "BenchmarkFixture.h"
+
+///==== Delta Snapshot Benchmark ====
+
+///Streams a world of 100k entities to a replica for 60 ticks. One entity in ten has a Velocity and moves every tick, the others are static.
+///On top of that, a few hundred entities are destroyed and as many are spawned every tick.
+///Each row is one tick: the size of the delta, and the time it took to encode it on the server and to apply it to the replica.
+///The first tick is a full copy of the world, every later tick only holds what changed.
+///After every tick, the replica is checked against the server (outside of the timings): the benchmark fails if any entity, mask or component differs.
+
+using namespace EntitySystem;
+
+static void Register(World& world)
+{
+    world.RegisterSnapshotComponent<Position>("Position");
+    world.RegisterSnapshotComponent<Velocity>("Velocity");
+}
+
+//Two entities with the same index and generation are the same entity in both worlds, as the delta carries the generations.
+template <typename ComponentType>
+static bool SameComponent(World& server, World& replica, Entity entity)
+{
+    bool present = server.HasComponent<ComponentType>(entity);
+    if (present != replica.HasComponent<ComponentType>(entity))
+    {
+        return false;
+    }
+    if (!present)
+    {
+        return true;
+    }
+
+    ComponentHandle<const ComponentType> original;
+    ComponentHandle<const ComponentType> copy;
+    server.Unpack(entity, original);
+    replica.Unpack(entity, copy);
+    return original->x == copy->x && original->y == copy->y;
+}
+
+//Every entity has a Position, so the Position views list every live entity of either world.
+static bool Matches(World& server, World& replica)
+{
+    bool matches = true;
+    unsigned int serverCount = 0;
+    server.View<const Position>().Each([&](Entity entity, const Position&)
+    {
+        serverCount++;
+        matches = matches && replica.IsAlive(entity) && SameComponent<Position>(server, replica, entity) && SameComponent<Velocity>(server, replica, entity);
+    });
+
+    unsigned int replicaCount = 0;
+    replica.View<const Position>().Each([&](Entity entity, const Position&)
+    {
+        replicaCount++;
+        matches = matches && server.IsAlive(entity);
+    });
+    return matches && serverCount == replicaCount;
+}
+
+int main()
+{
+    const unsigned int entityCount = 100000;
+    const unsigned int tickCount = 60;
+    const unsigned int churnPerTick = 200;
+    const unsigned int movingOneIn = 10;
+    std::mt19937 random(1234);
+
+    auto spawn = [&random, movingOneIn](World& world, Entity entity, float x, float y)
+    {
+        world.AddComponent(entity, Position(x, y));
+        if (random() % movingOneIn == 0)
+        {
+            world.AddComponent(entity, Velocity(0.5f, 0.25f));
+        }
+    };
+
+    World server(std::make_unique<EntityManager>());
+    World replica(std::make_unique<EntityManager>());
+    Register(server);
+    Register(replica);
+
+    std::vector<Entity> entities = server.CreateEntities(entityCount);
+    for (unsigned int i = 0; i < entityCount; i++)
+    {
+        spawn(server, entities[i], float(i), 0.0f);
+    }
+
+    DeltaEncoder encoder;
+    DeltaDecoder decoder;
+    std::vector<unsigned char> stream;
+    uint64_t totalBytes = 0;
+
+    std::cout << "tick,bytes,encode_ms,decode_ms" << std::endl;
+    for (unsigned int tick = 0; tick < tickCount; tick++)
+    {
+        if (tick > 0)
+        {
+            //The view is driven by the Velocity pool, so only the positions of moving entities are stamped as changed. Static entities cost nothing to encode.
+            server.View<Position, const Velocity>().Each([](Position& position, const Velocity& velocity)
+            {
+                position.x += velocity.x;
+                position.y += velocity.y;
+            });
+
+            for (unsigned int i = 0; i < churnPerTick; i++)
+            {
+                size_t victim = random() % entities.size();
+                server.DestroyEntity(entities[victim]);
+                entities[victim] = server.CreateEntity().entity;
+                spawn(server, entities[victim], float(i), float(tick));
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        server.EncodeDelta(encoder, stream);
+        double encodeTime = MillisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        if (!replica.ApplyDelta(decoder, stream.data(), stream.size()))
+        {
+            return 1;
+        }
+        double decodeTime = MillisecondsSince(start);
+
+        if (!Matches(server, replica))
+        {
+            std::cerr << "The replica does not match the server after tick " << tick << "." << std::endl;
+            return 1;
+        }
+
+        if (tick > 0)
+        {
+            totalBytes += stream.size();
+        }
+        std::cout << tick << "," << stream.size() << "," << encodeTime << "," << decodeTime << std::endl;
+    }
+
+    std::cout << "average_bytes_per_tick," << totalBytes / (tickCount - 1) << std::endl;
+}
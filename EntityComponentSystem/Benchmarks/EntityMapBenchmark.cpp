@@ -0,0 +1,97 @@
+#include "ECSPrecompiledHeader.h"
+#include <chrono>
+#include <map>
+#include <random>
+#include <algorithm>
+#include "EntityMap.h"
+
+///==== EntityMap Microbenchmark ====
+
+///Compares the sparse-set EntityMap against the std::map based map it replaced.
+///Every pass is timed separately: filling the map, looking up every entity in random order and removing every entity in random order.
+
+using namespace EntitySystem;
+
+//The previous implementation, kept here as a baseline.
+struct LegacyEntityMap
+{
+    Entity GetEntity(ComponentInstance instance) { return instanceToEntity.at(instance); }
+    ComponentInstance GetInstance(Entity entity) { return entityToInstance.at(entity); }
+
+    void Add(Entity entity, ComponentInstance instance)
+    {
+        entityToInstance.insert({ entity, instance });
+        if (instance >= instanceToEntity.size())
+        {
+            instanceToEntity.resize(instance + 1);
+        }
+        instanceToEntity[instance] = entity;
+    }
+
+    void Remove(Entity entity) { entityToInstance.erase(entity); }
+
+    std::map<Entity, ComponentInstance> entityToInstance;
+    std::vector<Entity> instanceToEntity;
+};
+
+template <typename Function>
+static double MeasureNanosecondsPerOperation(unsigned int operations, Function&& function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / operations;
+}
+
+template <typename MapType>
+static void RunBenchmark(const char* name, unsigned int entityCount)
+{
+    std::vector<Entity> entities(entityCount);
+    for (unsigned int i = 0; i < entityCount; i++)
+    {
+        entities[i] = { i + 1 };
+    }
+
+    std::vector<Entity> shuffled = entities;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1337));
+
+    MapType map;
+    double add = MeasureNanosecondsPerOperation(entityCount, [&]()
+    {
+        for (unsigned int i = 0; i < entityCount; i++)
+        {
+            map.Add(entities[i], i + 1);
+        }
+    });
+
+    volatile ComponentInstance sink = 0;
+    double lookup = MeasureNanosecondsPerOperation(entityCount, [&]()
+    {
+        ComponentInstance sum = 0;
+        for (Entity entity : shuffled)
+        {
+            sum += map.GetInstance(entity);
+        }
+        sink = sum;
+    });
+
+    double remove = MeasureNanosecondsPerOperation(entityCount, [&]()
+    {
+        for (Entity entity : shuffled)
+        {
+            map.Remove(entity);
+        }
+    });
+
+    std::cout << name << "," << entityCount << "," << add << "," << lookup << "," << remove << std::endl;
+}
+
+int main()
+{
+    std::cout << "map,entities,add_ns,lookup_ns,remove_ns" << std::endl;
+    for (unsigned int entityCount : { 1000u, 100000u, 1000000u })
+    {
+        RunBenchmark<LegacyEntityMap>("std::map", entityCount);
+        RunBenchmark<EntityMap>("sparse_set", entityCount);
+    }
+}
@@ -0,0 +1,96 @@
+#include "ECSPrecompiledHeader.h"
+#include <random>
+#include "EntityHandle.h"
+#include "BenchmarkFixture.h"
+
+///==== Group Benchmark ====
+
+///Integrates Position += Velocity * dt over 1M entities, of which only one out of two has a Velocity, added in a random order so that the two pools do not line up:
+///unpack: Unpack() of both components for every entity of a list, which is how systems iterated before views.
+///view: a view over both components, which walks one pool and looks every entity up in the other.
+///group: an owning group over both components (see ComponentGroup.h), which walks the front part of both pools side by side.
+///The "add" rows are the cost of adding the Velocity components, with and without a group to keep in order.
+
+using namespace EntitySystem;
+
+//Returns the entities that were given a Velocity.
+static std::vector<Entity> Populate(World& world, unsigned int entityCount, bool grouped)
+{
+    std::vector<Entity> entities = world.CreateEntities(entityCount);
+    for (Entity entity : entities)
+    {
+        world.AddComponent(entity, Position(0.0f, 0.0f));
+    }
+
+    if (grouped)
+    {
+        world.Group<Position, const Velocity>();
+    }
+
+    std::shuffle(entities.begin(), entities.end(), std::mt19937(42));
+    entities.resize(entityCount / 2);
+
+    auto start = std::chrono::steady_clock::now();
+    for (Entity entity : entities)
+    {
+        world.AddComponent(entity, Velocity(1.0f, 0.5f));
+    }
+    std::cout << (grouped ? "add_grouped," : "add,") << entities.size() << "," << NanosecondsPerEntity(start, static_cast<unsigned int>(entities.size())) << std::endl;
+    return entities;
+}
+
+int main()
+{
+    const unsigned int entityCount = 1000000;
+    const int frames = 20;
+    const float seconds = 0.016f;
+
+    std::cout << "operation,entities,ns_per_entity" << std::endl;
+
+    {
+        World world(std::make_unique<EntityManager>());
+        std::vector<Entity> moving = Populate(world, entityCount, false);
+        unsigned int count = static_cast<unsigned int>(moving.size());
+
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (Entity entity : moving)
+            {
+                ComponentHandle<Position> position;
+                ComponentHandle<const Velocity> velocity;
+                world.Unpack(entity, position, velocity);
+                position->x += velocity->x * seconds;
+                position->y += velocity->y * seconds;
+            }
+        }
+        std::cout << "unpack," << count << "," << NanosecondsPerEntity(start, count * frames) << std::endl;
+
+        start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            world.View<Position, const Velocity>().Each([seconds](Position& position, const Velocity& velocity)
+            {
+                position.x += velocity.x * seconds;
+                position.y += velocity.y * seconds;
+            });
+        }
+        std::cout << "view," << count << "," << NanosecondsPerEntity(start, count * frames) << std::endl;
+    }
+
+    {
+        World world(std::make_unique<EntityManager>());
+        unsigned int count = static_cast<unsigned int>(Populate(world, entityCount, true).size());
+
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            world.Group<Position, const Velocity>().Each([seconds](Position& position, const Velocity& velocity)
+            {
+                position.x += velocity.x * seconds;
+                position.y += velocity.y * seconds;
+            });
+        }
+        std::cout << "group," << count << "," << NanosecondsPerEntity(start, count * frames) << std::endl;
+    }
+}
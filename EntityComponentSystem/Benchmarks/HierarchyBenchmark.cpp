@@ -0,0 +1,128 @@
+#include "ECSPrecompiledHeader.h"
+#include <chrono>
+#include <random>
+#include "World.h"
+#include "System.h"
+#include "EntityHandle.h"
+#include "TransformSystem.h"
+
+///==== Hierarchy Benchmark ====
+
+///100k entities in 1k trees of random shape (up to 12 levels deep), each with a local and a world transform:
+///chase: composing every world transform by walking up the parent links and unpacking the local transform of every ancestor, which is what an external scene graph did.
+///sort: the first TransformSystem update after reparenting entities, which sorts the group by depth and recomputes everything.
+///full: a TransformSystem update where every local transform changed, a single pass over the sorted pools.
+///dirty: a TransformSystem update where 1% of the local transforms changed, which only recomputes their subtrees.
+///destroy: destroying the 1k roots, which takes their whole trees down with them in one batch.
+
+using namespace EntitySystem;
+
+struct Transform2D
+{
+    float x = 0.0f, y = 0.0f, rotation = 0.0f;
+
+    Transform2D operator*(const Transform2D& local) const
+    {
+        float cosine = std::cos(rotation);
+        float sine = std::sin(rotation);
+        return { x + local.x * cosine - local.y * sine, y + local.x * sine + local.y * cosine, rotation + local.rotation };
+    }
+};
+
+using Local = LocalTransform<Transform2D>;
+using Global = WorldTransform<Transform2D>;
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    const unsigned int entityCount = 100000;
+    const unsigned int rootCount = 1000;
+    const unsigned int maximumDepth = 12;
+    const int frames = 20;
+
+    World world(std::make_unique<EntityManager>());
+    world.AddSystem(std::make_unique<TransformSystem<Transform2D>>());
+    world.Initialize();
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    std::vector<Entity> entities = world.CreateEntities(entityCount);
+    std::vector<unsigned int> depths(entityCount, 0);
+    for (unsigned int i = 0; i < entityCount; i++)
+    {
+        world.AddComponent(entities[i], Local(Transform2D{ offset(random), offset(random), offset(random) }));
+        world.AddComponent(entities[i], Global());
+        world.AddComponent(entities[i], Hierarchy());
+    }
+    for (unsigned int i = rootCount; i < entityCount; i++)
+    {
+        unsigned int parent;
+        do
+        {
+            parent = random() % i;
+        } while (depths[parent] + 1 >= maximumDepth);
+        depths[i] = depths[parent] + 1;
+        world.SetParent(entities[i], entities[parent]);
+    }
+
+    std::cout << "operation,entities,ms" << std::endl;
+
+    float sum = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (Entity entity : entities)
+        {
+            ComponentHandle<const Local> local;
+            world.Unpack(entity, local);
+            Transform2D transform = local->value;
+            for (Entity parent = world.GetParent(entity); parent != Entity(); parent = world.GetParent(parent))
+            {
+                ComponentHandle<const Local> parentLocal;
+                world.Unpack(parent, parentLocal);
+                transform = parentLocal->value * transform;
+            }
+            sum += transform.x;
+        }
+    }
+    std::cout << "chase," << entityCount << "," << MillisecondsSince(start) / frames << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    world.Update(16);
+    std::cout << "sort," << entityCount << "," << MillisecondsSince(start) << std::endl;
+
+    double fullTime = 0.0;
+    double dirtyTime = 0.0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        world.View<Local>().Each([](Local& local) { local.value.rotation += 0.01f; });
+        start = std::chrono::steady_clock::now();
+        world.Update(16);
+        fullTime += MillisecondsSince(start);
+
+        for (unsigned int i = 0; i < entityCount / 100; i++)
+        {
+            ComponentHandle<Local> local;
+            world.Unpack(entities[random() % entityCount], local);
+            local->value.rotation += 0.01f;
+        }
+        start = std::chrono::steady_clock::now();
+        world.Update(16);
+        dirtyTime += MillisecondsSince(start);
+    }
+    std::cout << "full," << entityCount << "," << fullTime / frames << std::endl;
+    std::cout << "dirty," << entityCount << "," << dirtyTime / frames << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    world.DestroyEntities(std::vector<Entity>(entities.begin(), entities.begin() + rootCount));
+    std::cout << "destroy," << entityCount << "," << MillisecondsSince(start) << std::endl;
+
+    if (sum == 0.0f || world.IsAlive(entities.back()))
+    {
+        std::cerr << "Hierarchy benchmark: the hierarchy was not built or destroyed as expected." << std::endl;
+    }
+}
@@ -0,0 +1,99 @@
+#include "ECSPrecompiledHeader.h"
+#include <chrono>
+#include "World.h"
+#include "System.h"
+#include "EntityHandle.h"
+
+///==== Prefab Benchmark ====
+
+///Spawns waves of 10k enemies with 6 components each into a world of 8 systems, 100 times over, destroying every wave before the next one:
+///add: CreateEntity() and then AddComponent() for every component, which tests the mask of the entity against every system once per component.
+///instantiate: World::Instantiate() of a prefab captured from one enemy (see Prefab.h), which copies every component in blocks and registers the wave with each system at once.
+///The columns are the average and fastest time per wave.
+
+using namespace EntitySystem;
+
+struct Position : Component<Position> { Position() = default; Position(float x, float y) : x(x), y(y) {} float x = 0.0f, y = 0.0f; };
+struct Velocity : Component<Velocity> { Velocity() = default; Velocity(float x, float y) : x(x), y(y) {} float x = 0.0f, y = 0.0f; };
+struct Health : Component<Health> { Health() = default; Health(int points) : points(points) {} int points = 0; };
+struct Weapon : Component<Weapon> { Weapon() = default; Weapon(float damage, float range) : damage(damage), range(range) {} float damage = 0.0f, range = 0.0f; };
+struct Target : Component<Target> { Entity entity = {}; };
+struct Sprite : Component<Sprite> { Sprite() = default; Sprite(int id) : id(id) {} int id = 0; float tint[4] = { 1.0f, 1.0f, 1.0f, 1.0f }; };
+
+template <typename... ComponentTypes>
+class SignatureSystem : public System
+{
+public:
+    SignatureSystem() { (signature.AddComponent<ComponentTypes>(), ...); }
+};
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    const unsigned int waveSize = 10000;
+    const int waves = 100;
+
+    World world(std::make_unique<EntityManager>());
+    world.AddSystem(std::make_unique<SignatureSystem<Position, Velocity>>());
+    world.AddSystem(std::make_unique<SignatureSystem<Health>>());
+    world.AddSystem(std::make_unique<SignatureSystem<Weapon, Target, Position>>());
+    world.AddSystem(std::make_unique<SignatureSystem<Sprite, Position>>());
+    world.AddSystem(std::make_unique<SignatureSystem<Position>>());
+    world.AddSystem(std::make_unique<SignatureSystem<Velocity, Health>>());
+    world.AddSystem(std::make_unique<SignatureSystem<Target>>());
+    world.AddSystem(std::make_unique<SignatureSystem<Sprite, Velocity, Weapon>>());
+    world.Initialize();
+
+    auto spawn = [&world]()
+    {
+        EntityHandle enemy = world.CreateEntity();
+        enemy.AddComponent(Position(10.0f, 20.0f));
+        enemy.AddComponent(Velocity(1.0f, 0.0f));
+        enemy.AddComponent(Health(100));
+        enemy.AddComponent(Weapon(5.0f, 30.0f));
+        enemy.AddComponent(Target());
+        enemy.AddComponent(Sprite(3));
+        return enemy.entity;
+    };
+
+    std::cout << "operation,entities,components,average_ms,best_ms" << std::endl;
+
+    double total = 0.0;
+    double best = 1e9;
+    std::vector<Entity> wave;
+    for (int i = 0; i < waves; i++)
+    {
+        wave.clear();
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int entity = 0; entity < waveSize; entity++)
+        {
+            wave.push_back(spawn());
+        }
+        double time = MillisecondsSince(start);
+        total += time;
+        best = std::min(best, time);
+        world.DestroyEntities(wave);
+    }
+    std::cout << "add," << waveSize << ",6," << total / waves << "," << best << std::endl;
+
+    Entity original = spawn();
+    Prefab prefab = world.CreatePrefab(original);
+    world.DestroyEntity(original);
+
+    total = 0.0;
+    best = 1e9;
+    for (int i = 0; i < waves; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        wave = world.Instantiate(prefab, waveSize);
+        double time = MillisecondsSince(start);
+        total += time;
+        best = std::min(best, time);
+        world.DestroyEntities(wave);
+    }
+    std::cout << "instantiate," << waveSize << ",6," << total / waves << "," << best << std::endl;
+}
@@ -0,0 +1,76 @@
+#include "ECSPrecompiledHeader.h"
+#include "BenchmarkFixture.h"
+#include "Profiler.h"
+
+///==== Profiler Benchmark ====
+
+///Measures what the profiler (see Profiler.h) adds to a frame. First times 1M calls to Profiler::Record() on their own, which is the whole cost of an event:
+///its two timestamp reads come from the caller, so they are part of the timed loop too. Then updates worlds of 1k and 100k entities with 8 systems moving them,
+///1000 frames each, single threaded, and estimates the share of the frame spent profiling: 10 events per frame (the frame, the flush and the 8 systems) times the cost of one.
+///The columns are the events per frame, the cost of one event, the average frame time, and that estimate.
+///Building with ECS_ENABLE_PROFILER=0 and comparing the frame times gives the same answer, with far more noise.
+
+using namespace EntitySystem;
+
+class Mover : public MovementSystem
+{
+public:
+    void Update(int deltaTime) override
+    {
+        float seconds = deltaTime / 1000.0f;
+        Each<Position, const Velocity>([seconds](Position& position, const Velocity& velocity)
+        {
+            position.x += velocity.x * seconds;
+            position.y += velocity.y * seconds;
+        });
+    }
+};
+
+static double NanosecondsPerEvent()
+{
+    const unsigned int events = 1000000;
+
+    Profiler profiler;
+    profiler.BeginFrame();
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < events; i++)
+    {
+        uint64_t timestamp = Profiler::GetTimestamp();
+        profiler.Record(ProfileEventType::SystemUpdate, i & 7, timestamp, Profiler::GetTimestamp(), i, 0);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / events;
+}
+
+static void Run(unsigned int entityCount, double eventTime)
+{
+    const int systemCount = 8;
+    const int frames = 1000;
+
+    World world(std::make_unique<EntityManager>());
+    world.SetSchedulerMode(SchedulerMode::SingleThreaded);
+    for (int i = 0; i < systemCount; i++)
+    {
+        world.AddSystem(std::make_unique<Mover>());
+    }
+    world.Initialize();
+    Populate(world, entityCount);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        world.Update(16);
+    }
+    double frameTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+
+    const int eventsPerFrame = systemCount + 2;
+    std::cout << entityCount << "," << eventsPerFrame << "," << eventTime << "," << frameTime / 1000.0 << "," << 100.0 * eventsPerFrame * eventTime / frameTime << std::endl;
+}
+
+int main()
+{
+    double eventTime = NanosecondsPerEvent();
+
+    std::cout << "entities,events_per_frame,event_ns,frame_us,profiler_percent" << std::endl;
+    Run(1000, eventTime);
+    Run(100000, eventTime);
+}
@@ -0,0 +1,58 @@
+#include "ECSPrecompiledHeader.h"
+#include <cstdio>
+#include "EntityHandle.h"
+#include "BenchmarkFixture.h"
+
+///==== Snapshot Benchmark ====
+
+///Builds a world of 1M entities with Position and Velocity components, saves it, and loads it back into a fresh world.
+///The "rebuild" row is the cost of recreating the same world through CreateEntities() and AddComponent(), which is what loading would cost without adopting the mapped pages.
+///The "first_pass" row is the first iteration over the loaded components, which is where the pages of the file are actually faulted in.
+
+using namespace EntitySystem;
+
+static std::unique_ptr<World> MakeSnapshotWorld()
+{
+    std::unique_ptr<World> world = MakeWorld();
+    world->RegisterSnapshotComponent<Position>("Position");
+    world->RegisterSnapshotComponent<Velocity>("Velocity");
+    return world;
+}
+
+int main()
+{
+    const unsigned int entityCount = 1000000;
+    const char* path = "SnapshotBenchmark.snapshot";
+
+    std::cout << "operation,entities,ms" << std::endl;
+
+    {
+        std::unique_ptr<World> world = MakeSnapshotWorld();
+        auto start = std::chrono::steady_clock::now();
+        Populate(*world, entityCount);
+        std::cout << "rebuild," << entityCount << "," << MillisecondsSince(start) << std::endl;
+
+        start = std::chrono::steady_clock::now();
+        world->SaveSnapshot(path);
+        std::cout << "save," << entityCount << "," << MillisecondsSince(start) << std::endl;
+    }
+
+    {
+        std::unique_ptr<World> world = MakeSnapshotWorld();
+        auto start = std::chrono::steady_clock::now();
+        world->LoadSnapshot(path);
+        std::cout << "load," << entityCount << "," << MillisecondsSince(start) << std::endl;
+
+        float sum = 0.0f;
+        start = std::chrono::steady_clock::now();
+        world->View<const Position, const Velocity>().Each([&sum](const Position& position, const Velocity& velocity) { sum += position.x + velocity.x; });
+        std::cout << "first_pass," << entityCount << "," << MillisecondsSince(start) << std::endl;
+
+        if (sum == 0.0f)
+        {
+            std::cerr << "Snapshot benchmark: the loaded world is empty." << std::endl;
+        }
+    }
+
+    std::remove(path);
+}
@@ -0,0 +1,123 @@
+#include "ECSPrecompiledHeader.h"
+#include <random>
+#include "SpatialGrid.h"
+#include "BenchmarkFixture.h"
+
+///==== Spatial Grid Benchmark ====
+
+///100k entities wander over a 2000 x 2000 area, and every frame 1k radius queries of 20 units look for their neighbours:
+///grid_update: the SpatialGridSystem refiling the entities that moved, which is every one of them here.
+///grid_query: the queries answered by the grid (see SpatialGrid.h).
+///scan_query: the same queries answered by a view over every position, which is what systems did without a spatial index.
+///Timings are per frame; the "found" column is the total number of entities found, which should be the same for both kinds of queries.
+
+using namespace EntitySystem;
+
+class Movement : public System
+{
+public:
+    Movement()
+    {
+        signature.AddComponent<Position>();
+        signature.AddComponent<Velocity>();
+        Writes<Position>();
+        Reads<Velocity>();
+    }
+
+    void Update(int deltaTime) override
+    {
+        float seconds = deltaTime / 1000.0f;
+        Each<Position, const Velocity>([seconds](Position& position, const Velocity& velocity)
+        {
+            position.x += velocity.x * seconds;
+            position.y += velocity.y * seconds;
+        });
+    }
+};
+
+int main()
+{
+    const unsigned int entityCount = 100000;
+    const unsigned int queryCount = 1000;
+    const int frames = 20;
+    const float area = 2000.0f;
+    const float radius = 20.0f;
+
+    World world(std::make_unique<EntityManager>());
+    System* movement = world.AddSystem(std::make_unique<Movement>());
+    auto* grid = static_cast<SpatialGridSystem<Position>*>(world.AddSystem(std::make_unique<SpatialGridSystem<Position>>(radius, 16384)));
+    grid->RunAfter(movement);
+    world.Initialize();
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> coordinate(0.0f, area);
+    std::uniform_real_distribution<float> speed(-50.0f, 50.0f);
+    for (Entity entity : world.CreateEntities(entityCount))
+    {
+        world.AddComponent(entity, Position(coordinate(random), coordinate(random)));
+        world.AddComponent(entity, Velocity(speed(random), speed(random)));
+    }
+    world.Update(16);
+    world.ClearProfile();
+
+    std::cout << "operation,entities,queries,found,ms_per_frame" << std::endl;
+
+    double gridTime = 0.0;
+    double scanTime = 0.0;
+    size_t gridFound = 0;
+    size_t scanFound = 0;
+    std::vector<Entity> results;
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        world.Update(16);
+
+        std::vector<std::pair<float, float>> centers(queryCount);
+        for (auto& center : centers)
+        {
+            center = { coordinate(random), coordinate(random) };
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& center : centers)
+        {
+            results.clear();
+            grid->QueryRadius(center.first, center.second, radius, results);
+            gridFound += results.size();
+        }
+        gridTime += MillisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (const auto& center : centers)
+        {
+            results.clear();
+            world.View<const Position>().Each([&](Entity entity, const Position& position)
+            {
+                float dx = position.x - center.first;
+                float dy = position.y - center.second;
+                if (dx * dx + dy * dy <= radius * radius)
+                {
+                    results.push_back(entity);
+                }
+            });
+            scanFound += results.size();
+        }
+        scanTime += MillisecondsSince(start);
+    }
+
+    //The profiler times every system, in microseconds.
+    for (const ProfileStats& stats : world.GetProfileStats())
+    {
+        if (stats.name == grid->GetName())
+        {
+            std::cout << "grid_update," << entityCount << ",0,0," << stats.average / 1000.0 << std::endl;
+        }
+    }
+    std::cout << "grid_query," << entityCount << "," << queryCount << "," << gridFound << "," << gridTime / frames << std::endl;
+    std::cout << "scan_query," << entityCount << "," << queryCount << "," << scanFound << "," << scanTime / frames << std::endl;
+
+    if (gridFound != scanFound)
+    {
+        std::cerr << "Spatial grid benchmark: the grid and the scan disagree." << std::endl;
+    }
+}
@@ -0,0 +1,65 @@
+#include "ECSPrecompiledHeader.h"
+#include "StaticWorld.h"
+#include "EntityHandle.h"
+#include "BenchmarkFixture.h"
+
+///==== Static World Benchmark ====
+
+///Compares a World, which looks component managers up by family at runtime, with a StaticWorld over the same components, whose managers are members of a tuple (see StaticWorld.h).
+///add: AddComponent() of Position and Velocity for 1M entities.
+///unpack: Unpack() of both components of every entity, which is dominated by the manager lookup and the entity map.
+///view: one pass of a view over both components, where the managers are only looked up once and both worlds should be even.
+
+using namespace EntitySystem;
+
+ECS_COMPONENT_FAMILY(Position, 0)
+ECS_COMPONENT_FAMILY(Velocity, 1)
+
+template <typename WorldType>
+static void Run(const char* name, WorldType& world, unsigned int entityCount)
+{
+    std::vector<Entity> entities = world.CreateEntities(entityCount);
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < entityCount; i++)
+    {
+        world.AddComponent(entities[i], Position(float(i), 0.0f));
+        world.AddComponent(entities[i], Velocity(1.0f, 1.0f));
+    }
+    std::cout << name << ",add," << entityCount << "," << NanosecondsPerEntity(start, entityCount) << std::endl;
+
+    float sum = 0.0f;
+    start = std::chrono::steady_clock::now();
+    for (Entity entity : entities)
+    {
+        ComponentHandle<const Position> position;
+        ComponentHandle<const Velocity> velocity;
+        world.Unpack(entity, position, velocity);
+        sum += position->x + velocity->x;
+    }
+    std::cout << name << ",unpack," << entityCount << "," << NanosecondsPerEntity(start, entityCount) << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    world.template View<const Position, const Velocity>().Each([&sum](const Position& position, const Velocity& velocity) { sum += position.x + velocity.x; });
+    std::cout << name << ",view," << entityCount << "," << NanosecondsPerEntity(start, entityCount) << std::endl;
+
+    if (sum == 0.0f)
+    {
+        std::cerr << "Static world benchmark: the world is empty." << std::endl;
+    }
+}
+
+int main()
+{
+    const unsigned int entityCount = 1000000;
+
+    std::cout << "world,operation,entities,ns_per_entity" << std::endl;
+    {
+        World world(std::make_unique<EntityManager>());
+        Run("dynamic", world, entityCount);
+    }
+    {
+        StaticWorld<Position, Velocity> world(std::make_unique<EntityManager>());
+        Run("static", world, entityCount);
+    }
+}
@@ -0,0 +1,83 @@
+#include "ECSPrecompiledHeader.h"
+#include <cstring>
+#include "WorldStreaming.h"
+#include "BenchmarkFixture.h"
+
+///==== Streaming Benchmark ====
+
+///Brings a region of 100k entities with Position and Velocity components into a live world of 1M entities, as an open world does when the player gets close:
+///add: CreateEntities() and AddComponent() on the live world, which is what had to happen on the game thread before staging worlds.
+///merge: World::Merge() of a staging world populated beforehand (off the game thread in a real game), which appends the pools and registers the entities in bulk.
+///memcpy: copying the same number of component bytes, the floor for merging.
+///budgeted_setup: creating a WorldMerge, which creates the entities and grows the live world's arrays for the region in one go.
+///budgeted_step: the longest of the steps of that WorldMerge, given a 1 ms budget per frame, and the number of frames it took.
+///extract: World::Extract() of the region back into a staging world, for unloading.
+
+using namespace EntitySystem;
+
+static std::unique_ptr<World> MakeLiveWorld(unsigned int entityCount)
+{
+    std::unique_ptr<World> world = MakeWorld();
+    world->Initialize();
+    Populate(*world, entityCount);
+    return world;
+}
+
+int main()
+{
+    const unsigned int liveCount = 1000000;
+    const unsigned int regionCount = 100000;
+
+    std::cout << "operation,entities,ms,frames" << std::endl;
+
+    {
+        std::unique_ptr<World> live = MakeLiveWorld(liveCount);
+        auto start = std::chrono::steady_clock::now();
+        Populate(*live, regionCount);
+        std::cout << "add," << regionCount << "," << MillisecondsSince(start) << ",1" << std::endl;
+    }
+
+    {
+        std::unique_ptr<World> live = MakeLiveWorld(liveCount);
+        World staging(std::make_unique<EntityManager>());
+        Populate(staging, regionCount);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Entity> region = live->Merge(staging);
+        std::cout << "merge," << regionCount << "," << MillisecondsSince(start) << ",1" << std::endl;
+
+        size_t bytes = regionCount * (sizeof(Position) + sizeof(Velocity));
+        std::vector<unsigned char> source(bytes, 1);
+        std::vector<unsigned char> destination(bytes);
+        start = std::chrono::steady_clock::now();
+        std::memcpy(destination.data(), source.data(), bytes);
+        std::cout << "memcpy," << regionCount << "," << MillisecondsSince(start) << ",1" << std::endl;
+
+        World unloaded(std::make_unique<EntityManager>());
+        start = std::chrono::steady_clock::now();
+        live->Extract(region, unloaded);
+        std::cout << "extract," << regionCount << "," << MillisecondsSince(start) << ",1" << std::endl;
+    }
+
+    {
+        std::unique_ptr<World> live = MakeLiveWorld(liveCount);
+        World staging(std::make_unique<EntityManager>());
+        Populate(staging, regionCount);
+
+        auto start = std::chrono::steady_clock::now();
+        WorldMerge merge(*live, staging);
+        std::cout << "budgeted_setup," << regionCount << "," << MillisecondsSince(start) << ",1" << std::endl;
+
+        double longest = 0.0;
+        int frames = 0;
+        bool done = false;
+        while (!done)
+        {
+            start = std::chrono::steady_clock::now();
+            done = merge.Step(1.0);
+            longest = std::max(longest, MillisecondsSince(start));
+            frames++;
+        }
+        std::cout << "budgeted_step," << regionCount << "," << longest << "," << frames << std::endl;
+    }
+}
@@ -0,0 +1,164 @@
+#include "ECSPrecompiledHeader.h"
+#include <random>
+#include "EntityHandle.h"
+#include "BenchmarkFixture.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ECS_BENCHMARK_SSE 1
+#endif
+
+///==== Structure of Arrays Benchmark ====
+
+///Integrates Position += Velocity * dt for 100k entities, with the components stored whole (array of structs) and split into field arrays (structure of arrays, see StructOfArrays.h):
+///aos_each: the usual view over whole components.
+///soa_each: the same view over structure of arrays components, which are gathered into a copy for every entity. This is the price of not using spans.
+///soa_span: EachSpan() with a plain loop over the field arrays, which the compiler vectorizes (at -O3, as in the CMake Release build).
+///soa_span_sse: EachSpan() with an explicit SSE loop, four entities per instruction.
+///The "shuffled" rows give the entities their velocities in a random order, so that the instances of the two pools no longer line up and EachSpan() has to gather and scatter.
+
+using namespace EntitySystem;
+
+struct FieldPosition : Component<FieldPosition>
+{
+    FieldPosition(float x, float y) : x(x), y(y) {}
+    float x, y;
+};
+
+struct FieldVelocity : Component<FieldVelocity>
+{
+    FieldVelocity(float x, float y) : x(x), y(y) {}
+    float x, y;
+};
+
+ECS_STRUCT_OF_ARRAYS(FieldPosition, &FieldPosition::x, &FieldPosition::y)
+ECS_STRUCT_OF_ARRAYS(FieldVelocity, &FieldVelocity::x, &FieldVelocity::y)
+
+class EachIntegrator : public System
+{
+public:
+    void Update(int deltaTime) override
+    {
+        float seconds = deltaTime / 1000.0f;
+        Each<Position, const Velocity>([seconds](Position& position, const Velocity& velocity)
+        {
+            position.x += velocity.x * seconds;
+            position.y += velocity.y * seconds;
+        });
+    }
+};
+
+class FieldEachIntegrator : public System
+{
+public:
+    void Update(int deltaTime) override
+    {
+        float seconds = deltaTime / 1000.0f;
+        Each<FieldPosition, const FieldVelocity>([seconds](FieldPosition& position, const FieldVelocity& velocity)
+        {
+            position.x += velocity.x * seconds;
+            position.y += velocity.y * seconds;
+        });
+    }
+};
+
+class SpanIntegrator : public System
+{
+public:
+    void Update(int deltaTime) override
+    {
+        float seconds = deltaTime / 1000.0f;
+        EachSpan<FieldPosition, const FieldVelocity>([seconds](unsigned int count, FieldSpans<FieldPosition> position, FieldSpans<const FieldVelocity> velocity)
+        {
+            Integrate(position.Get<&FieldPosition::x>(), velocity.Get<&FieldVelocity::x>(), count, seconds);
+            Integrate(position.Get<&FieldPosition::y>(), velocity.Get<&FieldVelocity::y>(), count, seconds);
+        });
+    }
+
+    static void Integrate(float* __restrict position, const float* __restrict velocity, unsigned int count, float seconds)
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            position[i] += velocity[i] * seconds;
+        }
+    }
+};
+
+#ifdef ECS_BENCHMARK_SSE
+class SimdSpanIntegrator : public System
+{
+public:
+    void Update(int deltaTime) override
+    {
+        float seconds = deltaTime / 1000.0f;
+        EachSpan<FieldPosition, const FieldVelocity>([seconds](unsigned int count, FieldSpans<FieldPosition> position, FieldSpans<const FieldVelocity> velocity)
+        {
+            Integrate(position.Get<&FieldPosition::x>(), velocity.Get<&FieldVelocity::x>(), count, seconds);
+            Integrate(position.Get<&FieldPosition::y>(), velocity.Get<&FieldVelocity::y>(), count, seconds);
+        });
+    }
+
+    static void Integrate(float* position, const float* velocity, unsigned int count, float seconds)
+    {
+        __m128 step = _mm_set1_ps(seconds);
+        unsigned int i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps(position + i, _mm_add_ps(_mm_loadu_ps(position + i), _mm_mul_ps(_mm_loadu_ps(velocity + i), step)));
+        }
+        for (; i < count; i++)
+        {
+            position[i] += velocity[i] * seconds;
+        }
+    }
+};
+#endif
+
+template <typename SystemType, typename PositionType, typename VelocityType>
+static double Run(unsigned int entityCount, int frames, bool shuffled)
+{
+    World world(std::make_unique<EntityManager>());
+    world.AddSystem(std::make_unique<SystemType>());
+    world.Initialize();
+
+    std::vector<Entity> entities = world.CreateEntities(entityCount);
+    for (Entity entity : entities)
+    {
+        world.AddComponent(entity, PositionType(0.0f, 0.0f));
+    }
+
+    if (shuffled)
+    {
+        std::shuffle(entities.begin(), entities.end(), std::mt19937(42));
+    }
+    for (Entity entity : entities)
+    {
+        world.AddComponent(entity, VelocityType(1.0f, 0.5f));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        world.Update(16);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (double(frames) * entityCount);
+}
+
+int main()
+{
+    const unsigned int entityCount = 100000;
+    const int frames = 200;
+
+    std::cout << "iteration,order,entities,ns_per_entity" << std::endl;
+    for (bool shuffled : { false, true })
+    {
+        const char* order = shuffled ? "shuffled" : "aligned";
+        std::cout << "aos_each," << order << "," << entityCount << "," << Run<EachIntegrator, Position, Velocity>(entityCount, frames, shuffled) << std::endl;
+        std::cout << "soa_each," << order << "," << entityCount << "," << Run<FieldEachIntegrator, FieldPosition, FieldVelocity>(entityCount, frames, shuffled) << std::endl;
+        std::cout << "soa_span," << order << "," << entityCount << "," << Run<SpanIntegrator, FieldPosition, FieldVelocity>(entityCount, frames, shuffled) << std::endl;
+#ifdef ECS_BENCHMARK_SSE
+        std::cout << "soa_span_sse," << order << "," << entityCount << "," << Run<SimdSpanIntegrator, FieldPosition, FieldVelocity>(entityCount, frames, shuffled) << std::endl;
+#endif
+    }
+}
@@ -0,0 +1,129 @@
+#include "ECSPrecompiledHeader.h"
+#include <chrono>
+#include "World.h"
+#include "EntityHandle.h"
+#include "SharedComponent.h"
+
+///==== Tag Benchmark ====
+
+///Gives 100k entities a position, marks one in two of them as enemies, and compares the ways of storing the mark:
+///flag: a 1 byte component, which takes a pool, pages and an entity map like any other.
+///tag: an empty component (see Component.h), which only sets a bit of the entity's mask.
+///Then gives all of them one of 16 materials of 64 bytes:
+///material: a copy of the material per entity.
+///shared: a Shared<Material> (see SharedComponent.h), pointing to one interned copy per distinct material.
+///The columns are the bytes of component pages taken, the distinct values kept, the time to add the components,
+///and the average time of a view over the positions and the components, over 100 iterations.
+
+using namespace EntitySystem;
+
+struct Position : Component<Position> { Position() = default; Position(float x, float y) : x(x), y(y) {} float x = 0.0f, y = 0.0f; };
+struct EnemyFlag : Component<EnemyFlag> { bool value = true; };
+struct EnemyTag : Component<EnemyTag> {};
+
+struct Material
+{
+    int id = 0;
+    float color[4] = {};
+    float roughness = 0.0f;
+    float metallic = 0.0f;
+    float padding[9] = {};
+
+    bool operator==(const Material& other) const { return id == other.id; }
+};
+
+namespace std
+{
+    template <>
+    struct hash<Material>
+    {
+        size_t operator()(const Material& material) const { return std::hash<int>()(material.id); }
+    };
+}
+
+struct MaterialComponent : Component<MaterialComponent>
+{
+    MaterialComponent() = default;
+    MaterialComponent(const Material& value) : value(value) {}
+    Material value;
+};
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static Material MakeMaterial(int id)
+{
+    Material material;
+    material.id = id;
+    material.color[0] = id / 16.0f;
+    material.roughness = 0.5f;
+    return material;
+}
+
+//Adds "make(i)" to every entity for which "marked(i)" holds, then iterates the positions of those, reading "read" off the component.
+//"countValues" tells how many distinct values the components keep, once they are all added.
+template <typename ComponentType, typename Make, typename Read, typename Marked, typename CountValues>
+static void Run(const char* name, unsigned int entityCount, Make make, Read read, Marked marked, CountValues countValues)
+{
+    const int iterations = 100;
+
+    World world(std::make_unique<EntityManager>());
+    std::vector<Entity> entities;
+    for (unsigned int i = 0; i < entityCount; i++)
+    {
+        EntityHandle entity = world.CreateEntity();
+        entity.AddComponent(Position(float(i), 0.0f));
+        entities.push_back(entity.entity);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < entityCount; i++)
+    {
+        if (marked(i))
+        {
+            world.AddComponent(entities[i], make(i));
+        }
+    }
+    double addTime = MillisecondsSince(start);
+
+    size_t values = countValues();
+    size_t bytes = 0;
+    if constexpr (!IsTagComponent<ComponentType>)
+    {
+        bytes = world.GetComponentMemory<ComponentType>();
+    }
+
+    float sum = 0.0f;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        world.View<const Position, const ComponentType>().Each([&sum, &read](Entity, const Position& position, const ComponentType& component) { sum += position.x * read(component); });
+    }
+    double iterateTime = MillisecondsSince(start) / iterations;
+
+    std::cout << name << "," << entityCount << "," << bytes << "," << values << "," << addTime << "," << iterateTime << std::endl;
+    if (sum == 1.0f)
+    {
+        std::cout << sum << std::endl;  //Keeps the loop from being optimized away.
+    }
+}
+
+int main()
+{
+    const unsigned int entityCount = 100000;
+    auto half = [](unsigned int i) { return i % 2 == 0; };
+    auto all = [](unsigned int) { return true; };
+    auto none = []() { return size_t(0); };
+
+    std::cout << "case,entities,component_bytes,values,add_ms,iterate_ms" << std::endl;
+
+    Run<EnemyFlag>("flag", entityCount, [](unsigned int) { return EnemyFlag(); }, [](const EnemyFlag& flag) { return flag.value ? 1.0f : 0.0f; }, half, none);
+    Run<EnemyTag>("tag", entityCount, [](unsigned int) { return EnemyTag(); }, [](const EnemyTag&) { return 1.0f; }, half, none);
+
+    Run<MaterialComponent>("material", entityCount, [](unsigned int i) { return MaterialComponent(MakeMaterial(i % 16)); },
+        [](const MaterialComponent& material) { return material.value.roughness; }, all, [entityCount]() { return size_t(entityCount); });
+    Run<Shared<Material>>("shared", entityCount, [](unsigned int i) { return Shared<Material>(MakeMaterial(i % 16)); },
+        [](const Shared<Material>& material) { return material->roughness; }, all, []() { return SharedComponentStore<Material>::Get().GetValueCount(); });
+}
@@ -0,0 +1,132 @@
+#include "ECSPrecompiledHeader.h"
+#include "EntityHandle.h"
+#include "BenchmarkFixture.h"
+
+///==== View Benchmark ====
+
+///Integrates 100k entities with Position, Velocity and Acceleration components, once through the classic registeredEntities + Unpack() loop and once through System::Each().
+///A quarter of the entities only have a Position, so that the view has to skip non-matching entities as well.
+///The parallel rows spread the same view over the world's job system, which uses every hardware thread.
+
+using namespace EntitySystem;
+
+struct Acceleration : Component<Acceleration>
+{
+    Acceleration(float x, float y) : x(x), y(y) {}
+    float x, y;
+};
+
+class UnpackIntegrator : public System
+{
+public:
+    UnpackIntegrator()
+    {
+        signature.AddComponent<Position>();
+        signature.AddComponent<Velocity>();
+        signature.AddComponent<Acceleration>();
+    }
+
+    void Update(int deltaTime) override
+    {
+        float seconds = deltaTime / 1000.0f;
+        for (auto& entity : registeredEntities)
+        {
+            ComponentHandle<Position> position;
+            ComponentHandle<Velocity> velocity;
+            ComponentHandle<Acceleration> acceleration;
+            parentWorld->Unpack(entity, position, velocity, acceleration);
+
+            velocity->x += acceleration->x * seconds;
+            velocity->y += acceleration->y * seconds;
+            position->x += velocity->x * seconds;
+            position->y += velocity->y * seconds;
+        }
+    }
+};
+
+class ViewIntegrator : public System
+{
+public:
+    ViewIntegrator()
+    {
+        signature.AddComponent<Position>();
+        signature.AddComponent<Velocity>();
+        signature.AddComponent<Acceleration>();
+    }
+
+    void Update(int deltaTime) override
+    {
+        float seconds = deltaTime / 1000.0f;
+        Each<Position, Velocity, const Acceleration>([seconds](Position& position, Velocity& velocity, const Acceleration& acceleration)
+        {
+            velocity.x += acceleration.x * seconds;
+            velocity.y += acceleration.y * seconds;
+            position.x += velocity.x * seconds;
+            position.y += velocity.y * seconds;
+        });
+    }
+};
+
+class ParallelViewIntegrator : public System
+{
+public:
+    ParallelViewIntegrator()
+    {
+        signature.AddComponent<Position>();
+        signature.AddComponent<Velocity>();
+        signature.AddComponent<Acceleration>();
+    }
+
+    void Update(int deltaTime) override
+    {
+        float seconds = deltaTime / 1000.0f;
+        ParallelEach<Position, Velocity, const Acceleration>([seconds](Position& position, Velocity& velocity, const Acceleration& acceleration)
+        {
+            velocity.x += acceleration.x * seconds;
+            velocity.y += acceleration.y * seconds;
+            position.x += velocity.x * seconds;
+            position.y += velocity.y * seconds;
+        });
+    }
+};
+
+template <typename SystemType>
+static double Run(StorageMode storageMode, unsigned int entityCount, int frames)
+{
+    World world(std::make_unique<EntityManager>(), storageMode);
+    world.AddSystem(std::make_unique<SystemType>());
+    world.Initialize();
+
+    for (unsigned int i = 0; i < entityCount; i++)
+    {
+        EntityHandle entity = world.CreateEntity();
+        entity.AddComponent(Position(0.0f, 0.0f));
+        if (i % 4 != 0)
+        {
+            entity.AddComponent(Velocity(1.0f, 1.0f));
+            entity.AddComponent(Acceleration(0.5f, 0.25f));
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        world.Update(16);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (double(frames) * entityCount);
+}
+
+int main()
+{
+    const unsigned int entityCount = 100000;
+    const int frames = 50;
+
+    std::cout << "iteration,storage,entities,ns_per_entity" << std::endl;
+    std::cout << "unpack,pools," << entityCount << "," << Run<UnpackIntegrator>(StorageMode::ComponentPools, entityCount, frames) << std::endl;
+    std::cout << "view,pools," << entityCount << "," << Run<ViewIntegrator>(StorageMode::ComponentPools, entityCount, frames) << std::endl;
+    std::cout << "unpack,archetypes," << entityCount << "," << Run<UnpackIntegrator>(StorageMode::Archetypes, entityCount, frames) << std::endl;
+    std::cout << "view,archetypes," << entityCount << "," << Run<ViewIntegrator>(StorageMode::Archetypes, entityCount, frames) << std::endl;
+    std::cout << "parallel_view,pools," << entityCount << "," << Run<ParallelViewIntegrator>(StorageMode::ComponentPools, entityCount, frames) << std::endl;
+    std::cout << "parallel_view,archetypes," << entityCount << "," << Run<ParallelViewIntegrator>(StorageMode::Archetypes, entityCount, frames) << std::endl;
+}
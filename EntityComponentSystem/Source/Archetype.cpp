@@ -0,0 +1,345 @@
+#include "ECSPrecompiledHeader.h"
+#include "Archetype.h"
+#include <algorithm>
+
+namespace EntitySystem
+{
+	static size_t AlignUp(size_t offset, size_t alignment)
+	{
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	//Lays the columns out one after another, finding the largest entity count whose columns (each aligned for its type) still fit in a chunk.
+	static void BuildChunkLayout(Archetype& archetype)
+	{
+		size_t bytesPerEntity = sizeof(Entity);
+		for (const ComponentTypeInfo* column : archetype.columns)
+		{
+			bytesPerEntity += column->size + 2 * sizeof(uint32_t);
+			archetype.chunkAlignment = std::max(archetype.chunkAlignment, column->alignment);
+		}
+
+		size_t chunkVersionBytes = AlignUp(archetype.columns.size() * 2 * sizeof(uint32_t), alignof(Entity));
+		unsigned int capacity = static_cast<unsigned int>(std::max<size_t>((Archetype::ChunkSize - chunkVersionBytes) / bytesPerEntity, 1));
+		while (true)
+		{
+			size_t offset = 0;
+			archetype.chunkVersionOffset = offset;
+			offset += chunkVersionBytes;
+			archetype.entityOffset = offset;
+			offset += capacity * sizeof(Entity);
+
+			archetype.columnOffsets.clear();
+			for (const ComponentTypeInfo* column : archetype.columns)
+			{
+				offset = AlignUp(offset, column->alignment);
+				archetype.columnOffsets.push_back(offset);
+				offset += capacity * column->size;
+			}
+
+			archetype.addedOffsets.clear();
+			archetype.changedOffsets.clear();
+			offset = AlignUp(offset, alignof(uint32_t));
+			for (size_t column = 0; column < archetype.columns.size(); column++)
+			{
+				archetype.addedOffsets.push_back(offset);
+				offset += capacity * sizeof(uint32_t);
+				archetype.changedOffsets.push_back(offset);
+				offset += capacity * sizeof(uint32_t);
+			}
+
+			//Entities bigger than a chunk still get one entity per (oversized) chunk.
+			if (offset <= Archetype::ChunkSize || capacity == 1)
+			{
+				archetype.chunkBytes = std::max(offset, Archetype::ChunkSize);
+				archetype.chunkCapacity = capacity;
+				return;
+			}
+			capacity--;
+		}
+	}
+
+	ArchetypeStorage::~ArchetypeStorage()
+	{
+		for (auto& archetype : archetypes)
+		{
+			for (ArchetypeChunk& chunk : archetype->chunks)
+			{
+				for (size_t column = 0; column < archetype->columns.size(); column++)
+				{
+					for (unsigned int row = 0; row < chunk.count; row++)
+					{
+						archetype->columns[column]->destroy(archetype->GetComponent(chunk, static_cast<int>(column), row));
+					}
+				}
+				allocator->Free(ArchetypeChunkFamily, chunk.memory, archetype->chunkBytes, archetype->chunkAlignment);
+			}
+		}
+	}
+
+	void ArchetypeStorage::AddComponent(Entity entity, const ComponentTypeInfo* type, void* component)
+	{
+		Archetype* source = GetLocation(entity).archetype;
+		Archetype* destination = GetAddTransition(source, type);
+		EntityLocation location = MoveEntity(entity, destination);
+
+		//Adding a component the entity already has replaces it.
+		int column = destination->GetColumn(type->family);
+		ArchetypeChunk& chunk = destination->chunks[location.chunk];
+		void* slot = destination->GetComponent(chunk, column, location.row);
+		if (destination == source)
+		{
+			type->destroy(slot);
+		}
+		type->moveConstruct(slot, component);
+
+		uint32_t tick = GetChangeTick();
+		destination->SetVersions(chunk, column, location.row, tick, tick);
+	}
+
+	void ArchetypeStorage::RemoveComponent(Entity entity, int family)
+	{
+		EntityLocation& location = GetLocation(entity);
+		if (!location.archetype || location.archetype->GetColumn(family) < 0)
+		{
+			return;
+		}
+
+		MoveEntity(entity, GetRemoveTransition(location.archetype, family));
+	}
+
+	void ArchetypeStorage::DestroyEntity(Entity entity)
+	{
+		MoveEntity(entity, nullptr);
+	}
+
+	void* ArchetypeStorage::GetComponent(Entity entity, int family)
+	{
+		EntityLocation& location = GetLocation(entity);
+		if (!location.archetype)
+		{
+			return nullptr;
+		}
+
+		int column = location.archetype->GetColumn(family);
+		if (column < 0)
+		{
+			return nullptr;
+		}
+		return location.archetype->GetComponent(location.archetype->chunks[location.chunk], column, location.row);
+	}
+
+	void ArchetypeStorage::MarkChanged(Entity entity, int family)
+	{
+		GetComponentForWrite(entity, family);
+	}
+
+	void* ArchetypeStorage::GetComponentForWrite(Entity entity, int family)
+	{
+		EntityLocation& location = GetLocation(entity);
+		int column = location.archetype ? location.archetype->GetColumn(family) : -1;
+		if (column < 0)
+		{
+			return nullptr;
+		}
+
+		ArchetypeChunk& chunk = location.archetype->chunks[location.chunk];
+		location.archetype->MarkChanged(chunk, column, location.row, GetChangeTick());
+		return location.archetype->GetComponent(chunk, column, location.row);
+	}
+
+	Archetype* ArchetypeStorage::FindOrCreateArchetype(const std::vector<const ComponentTypeInfo*>& columns)
+	{
+		if (columns.empty())
+		{
+			return nullptr;
+		}
+
+		ComponentMask mask;
+		for (const ComponentTypeInfo* column : columns)
+		{
+			mask.AddFamily(column->family);
+		}
+
+		for (auto& archetype : archetypes)
+		{
+			if (archetype->mask == mask)
+			{
+				return archetype.get();
+			}
+		}
+
+		std::unique_ptr<Archetype> archetype = std::make_unique<Archetype>();
+		archetype->mask = mask;
+		archetype->columns = columns;
+		std::sort(archetype->columns.begin(), archetype->columns.end(), [](const ComponentTypeInfo* left, const ComponentTypeInfo* right) { return left->family < right->family; });
+
+		archetype->familyToColumn.assign(archetype->columns.back()->family + 1, -1);
+		for (size_t column = 0; column < archetype->columns.size(); column++)
+		{
+			archetype->familyToColumn[archetype->columns[column]->family] = static_cast<int>(column);
+		}
+
+		BuildChunkLayout(*archetype);
+		archetypes.push_back(std::move(archetype));
+		return archetypes.back().get();
+	}
+
+	Archetype* ArchetypeStorage::GetAddTransition(Archetype* source, const ComponentTypeInfo* type)
+	{
+		if (!source)
+		{
+			return FindOrCreateArchetype({ type });
+		}
+
+		if (type->family < static_cast<int>(source->addEdges.size()) && source->addEdges[type->family])
+		{
+			return source->addEdges[type->family];
+		}
+
+		std::vector<const ComponentTypeInfo*> columns = source->columns;
+		if (source->GetColumn(type->family) < 0)
+		{
+			columns.push_back(type);
+		}
+
+		Archetype* destination = FindOrCreateArchetype(columns);
+		if (type->family >= static_cast<int>(source->addEdges.size()))
+		{
+			source->addEdges.resize(type->family + 1, nullptr);
+		}
+		source->addEdges[type->family] = destination;
+		return destination;
+	}
+
+	Archetype* ArchetypeStorage::GetRemoveTransition(Archetype* source, int family)
+	{
+		if (family < static_cast<int>(source->removeEdges.size()) && source->removeEdges[family])
+		{
+			return source->removeEdges[family];
+		}
+
+		std::vector<const ComponentTypeInfo*> columns;
+		for (const ComponentTypeInfo* column : source->columns)
+		{
+			if (column->family != family)
+			{
+				columns.push_back(column);
+			}
+		}
+
+		//Removing the last component leaves the entity without an archetype, which is not cached as it is already a single call.
+		Archetype* destination = FindOrCreateArchetype(columns);
+		if (destination)
+		{
+			if (family >= static_cast<int>(source->removeEdges.size()))
+			{
+				source->removeEdges.resize(family + 1, nullptr);
+			}
+			source->removeEdges[family] = destination;
+		}
+		return destination;
+	}
+
+	EntityLocation ArchetypeStorage::MoveEntity(Entity entity, Archetype* destination)
+	{
+		EntityLocation source = GetLocation(entity);
+		EntityLocation target;
+
+		if (destination == source.archetype)
+		{
+			return source;
+		}
+
+		if (destination)
+		{
+			target = AllocateRow(destination, entity);
+		}
+
+		if (source.archetype)
+		{
+			ArchetypeChunk& sourceChunk = source.archetype->chunks[source.chunk];
+			for (size_t column = 0; column < source.archetype->columns.size(); column++)
+			{
+				const ComponentTypeInfo* type = source.archetype->columns[column];
+				void* component = source.archetype->GetComponent(sourceChunk, static_cast<int>(column), source.row);
+
+				int targetColumn = destination ? destination->GetColumn(type->family) : -1;
+				if (targetColumn >= 0)
+				{
+					ArchetypeChunk& targetChunk = destination->chunks[target.chunk];
+					type->moveConstruct(destination->GetComponent(targetChunk, targetColumn, target.row), component);
+					destination->SetVersions(targetChunk, targetColumn, target.row, source.archetype->GetAddedVersions(sourceChunk, static_cast<int>(column))[source.row],
+						source.archetype->GetChangedVersions(sourceChunk, static_cast<int>(column))[source.row]);
+				}
+				type->destroy(component);
+			}
+			RemoveRow(source);
+		}
+
+		GetLocation(entity) = target;
+		return target;
+	}
+
+	EntityLocation ArchetypeStorage::AllocateRow(Archetype* archetype, Entity entity)
+	{
+		if (archetype->chunks.empty() || archetype->chunks.back().count == archetype->chunkCapacity)
+		{
+			ArchetypeChunk chunk;
+			chunk.memory = static_cast<unsigned char*>(allocator->Allocate(ArchetypeChunkFamily, archetype->chunkBytes, archetype->chunkAlignment));
+			std::fill_n(&archetype->GetChunkAddedVersion(chunk, 0), archetype->columns.size() * 2, 0u);
+			archetype->chunks.push_back(chunk);
+		}
+
+		EntityLocation location;
+		location.archetype = archetype;
+		location.chunk = static_cast<unsigned int>(archetype->chunks.size() - 1);
+
+		ArchetypeChunk& chunk = archetype->chunks.back();
+		location.row = chunk.count++;
+		archetype->GetEntities(chunk)[location.row] = entity;
+		return location;
+	}
+
+	void ArchetypeStorage::RemoveRow(const EntityLocation& location)
+	{
+		Archetype* archetype = location.archetype;
+		ArchetypeChunk& lastChunk = archetype->chunks.back();
+		unsigned int lastRow = lastChunk.count - 1;
+		unsigned int lastChunkIndex = static_cast<unsigned int>(archetype->chunks.size() - 1);
+
+		//Just like the component managers, we keep the chunks tightly packed by moving the very last row of the archetype into the hole.
+		if (location.chunk != lastChunkIndex || location.row != lastRow)
+		{
+			ArchetypeChunk& chunk = archetype->chunks[location.chunk];
+			for (size_t column = 0; column < archetype->columns.size(); column++)
+			{
+				void* last = archetype->GetComponent(lastChunk, static_cast<int>(column), lastRow);
+				archetype->columns[column]->moveConstruct(archetype->GetComponent(chunk, static_cast<int>(column), location.row), last);
+				archetype->columns[column]->destroy(last);
+				archetype->SetVersions(chunk, static_cast<int>(column), location.row, archetype->GetAddedVersions(lastChunk, static_cast<int>(column))[lastRow],
+					archetype->GetChangedVersions(lastChunk, static_cast<int>(column))[lastRow]);
+			}
+
+			Entity movedEntity = archetype->GetEntities(lastChunk)[lastRow];
+			archetype->GetEntities(chunk)[location.row] = movedEntity;
+			GetLocation(movedEntity) = location;
+		}
+
+		lastChunk.count--;
+		if (lastChunk.count == 0)
+		{
+			allocator->Free(ArchetypeChunkFamily, lastChunk.memory, archetype->chunkBytes, archetype->chunkAlignment);
+			archetype->chunks.pop_back();
+		}
+	}
+
+	EntityLocation& ArchetypeStorage::GetLocation(Entity entity)
+	{
+		if (entity.Index() >= entityLocations.size())
+		{
+			entityLocations.resize(entity.Index() + 1);
+		}
+		return entityLocations[entity.Index()];
+	}
+}
@@ -0,0 +1,193 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <new>
+#include <algorithm>
+#include <atomic>
+#include "Entity.h"
+#include "ComponentMask.h"
+#include "PageAllocator.h"
+
+///==== Archetypes ====
+
+///Component managers store each component type in its own array. This is great when a system only cares about one component, but a system that touches three components
+///has to look the entity up in three unrelated arrays, which means three lookups and three cache misses per entity.
+///An archetype is the set of all entities that share exactly the same ComponentMask. Entities of one archetype live together in fixed-size chunks,
+///and inside a chunk every component type gets its own column. A system iterating a signature then only has to walk the chunks of matching archetypes linearly.
+
+///The price is paid when the mask of an entity changes: adding or removing a component moves the entity (and all of its components) into another archetype.
+///To make that cheap, every archetype caches the archetype reached by adding or removing each family, so that a transition is a single vector lookup after the first time.
+
+///For change tracking, every column of a chunk is paired with the added and changed version of each row, and the chunk keeps the highest version of each column,
+///so that a query filtered on changes skips untouched chunks with one comparison per chunk.
+
+namespace EntitySystem
+{
+    //Type-erased description of a component type, so that chunks can move and destroy components without knowing their type at compile time.
+    struct ComponentTypeInfo
+    {
+        int family;
+        size_t size;
+        size_t alignment;
+        void (*moveConstruct)(void* destination, void* source);
+        void (*destroy)(void* component);
+
+        template <typename ComponentType>
+        static const ComponentTypeInfo* Get()
+        {
+            static const ComponentTypeInfo info =
+            {
+                //Tags (see Component.h) take no bytes in their column, as there is nothing to store.
+                GetComponentFamily<ComponentType>(), IsTagComponent<ComponentType> ? 0 : sizeof(ComponentType), alignof(ComponentType),
+                [](void* destination, void* source)
+                {
+                    if constexpr (!IsTagComponent<ComponentType>)
+                    {
+                        new (destination) ComponentType(std::move(*static_cast<ComponentType*>(source)));
+                    }
+                },
+                [](void* component)
+                {
+                    if constexpr (!IsTagComponent<ComponentType>)
+                    {
+                        static_cast<ComponentType*>(component)->~ComponentType();
+                    }
+                }
+            };
+            return &info;
+        }
+    };
+
+    struct ArchetypeChunk
+    {
+        unsigned char* memory = nullptr;
+        unsigned int count = 0;
+    };
+
+    struct Archetype
+    {
+        static constexpr size_t ChunkSize = 16 * 1024;
+
+        ComponentMask mask;
+        std::vector<const ComponentTypeInfo*> columns;  //Sorted by family.
+        std::vector<size_t> columnOffsets;
+        std::vector<size_t> addedOffsets;               //Per column, the offset of the added version of every row.
+        std::vector<size_t> changedOffsets;             //Per column, the offset of the changed version of every row.
+        size_t chunkVersionOffset = 0;                  //Per column, the highest added and changed version of the chunk.
+        std::vector<int> familyToColumn;                //-1 if the family is not part of this archetype.
+        size_t entityOffset = 0;
+        size_t chunkBytes = ChunkSize;
+        size_t chunkAlignment = 64;
+        unsigned int chunkCapacity = 0;
+        std::vector<ArchetypeChunk> chunks;
+
+        //Cached transitions, indexed by the family that is added or removed.
+        std::vector<Archetype*> addEdges;
+        std::vector<Archetype*> removeEdges;
+
+        int GetColumn(int family) const { return family < static_cast<int>(familyToColumn.size()) ? familyToColumn[family] : -1; }
+        Entity* GetEntities(const ArchetypeChunk& chunk) const { return reinterpret_cast<Entity*>(chunk.memory + entityOffset); }
+        void* GetColumnData(const ArchetypeChunk& chunk, int column) const { return chunk.memory + columnOffsets[column]; }
+        void* GetComponent(const ArchetypeChunk& chunk, int column, unsigned int row) const { return chunk.memory + columnOffsets[column] + row * columns[column]->size; }
+
+        uint32_t* GetAddedVersions(const ArchetypeChunk& chunk, int column) const { return reinterpret_cast<uint32_t*>(chunk.memory + addedOffsets[column]); }
+        uint32_t* GetChangedVersions(const ArchetypeChunk& chunk, int column) const { return reinterpret_cast<uint32_t*>(chunk.memory + changedOffsets[column]); }
+        uint32_t& GetChunkAddedVersion(const ArchetypeChunk& chunk, int column) const { return reinterpret_cast<uint32_t*>(chunk.memory + chunkVersionOffset)[column * 2]; }
+        uint32_t& GetChunkChangedVersion(const ArchetypeChunk& chunk, int column) const { return reinterpret_cast<uint32_t*>(chunk.memory + chunkVersionOffset)[column * 2 + 1]; }
+
+        //Sets the versions of a row, raising the chunk versions if needed.
+        void SetVersions(const ArchetypeChunk& chunk, int column, unsigned int row, uint32_t added, uint32_t changed) const
+        {
+            GetAddedVersions(chunk, column)[row] = added;
+            GetChangedVersions(chunk, column)[row] = changed;
+            GetChunkAddedVersion(chunk, column) = std::max(GetChunkAddedVersion(chunk, column), added);
+            GetChunkChangedVersion(chunk, column) = std::max(GetChunkChangedVersion(chunk, column), changed);
+        }
+
+        void MarkChanged(const ArchetypeChunk& chunk, int column, unsigned int row, uint32_t tick) const
+        {
+            GetChangedVersions(chunk, column)[row] = tick;
+            GetChunkChangedVersion(chunk, column) = tick;
+        }
+    };
+
+    struct EntityLocation
+    {
+        Archetype* archetype = nullptr;
+        unsigned int chunk = 0;
+        unsigned int row = 0;
+    };
+
+    class ArchetypeStorage
+    {
+    public:
+        //Chunks come from the given allocator, under ArchetypeChunkFamily (see PageAllocator.h).
+        explicit ArchetypeStorage(PageAllocator& allocator = HeapPageAllocator::Get()) : allocator(&allocator) {}
+        ~ArchetypeStorage();
+        ArchetypeStorage(const ArchetypeStorage&) = delete;
+        ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+
+        //Moves the entity into the archetype that also holds "type", move-constructing the new component from "component".
+        void AddComponent(Entity entity, const ComponentTypeInfo* type, void* component);
+
+        //Moves the entity into the archetype without "family", destroying the removed component.
+        void RemoveComponent(Entity entity, int family);
+
+        //Destroys every component of the entity and removes it from its archetype.
+        void DestroyEntity(Entity entity);
+
+        //Returns nullptr if the entity does not have a component of that family.
+        void* GetComponent(Entity entity, int family);
+
+        //Records that the component of the entity has been handed out for writing at the current tick.
+        void MarkChanged(Entity entity, int family);
+
+        //GetComponent() followed by MarkChanged(), with a single lookup.
+        void* GetComponentForWrite(Entity entity, int family);
+
+        //See BaseComponentManager::SetChangeTickSource().
+        void SetChangeTickSource(const std::atomic<uint32_t>* source) { changeTickSource = source; }
+        uint32_t GetChangeTick() const { return changeTickSource ? changeTickSource->load(std::memory_order_relaxed) : 1; }
+
+        //Calls function(archetype, chunk) for every non-empty chunk whose archetype contains all components of the signature.
+        template <typename Function>
+        void ForEachMatchingChunk(const ComponentMask& signature, Function&& function)
+        {
+            for (auto& archetype : archetypes)
+            {
+                if (!archetype->mask.Matches(signature))
+                {
+                    continue;
+                }
+
+                for (ArchetypeChunk& chunk : archetype->chunks)
+                {
+                    if (chunk.count > 0)
+                    {
+                        function(*archetype, chunk);
+                    }
+                }
+            }
+        }
+
+    private:
+        Archetype* FindOrCreateArchetype(const std::vector<const ComponentTypeInfo*>& columns);
+        Archetype* GetAddTransition(Archetype* source, const ComponentTypeInfo* type);
+        Archetype* GetRemoveTransition(Archetype* source, int family);
+
+        //Moves the entity from its current archetype into "destination". Components not present in the destination are destroyed.
+        //Returns the row of the entity in the destination, with the columns missing from the source left unconstructed.
+        EntityLocation MoveEntity(Entity entity, Archetype* destination);
+
+        EntityLocation AllocateRow(Archetype* archetype, Entity entity);
+
+        //Fills the hole left at "location" (whose components have already been moved out or destroyed) with the last row of the archetype.
+        void RemoveRow(const EntityLocation& location);
+
+        EntityLocation& GetLocation(Entity entity);
+
+        std::vector<std::unique_ptr<Archetype>> archetypes;
+        std::vector<EntityLocation> entityLocations;
+        const std::atomic<uint32_t>* changeTickSource = nullptr;
+        PageAllocator* allocator;
+    };
+}
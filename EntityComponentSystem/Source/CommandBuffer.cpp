@@ -0,0 +1,70 @@
+#include "ECSPrecompiledHeader.h"
+#include "CommandBuffer.h"
+
+namespace EntitySystem
+{
+	CommandBuffer::~CommandBuffer()
+	{
+		Clear();
+		for (Block& block : blocks)
+		{
+			::operator delete(block.memory, std::align_val_t(CacheLineSize));
+		}
+	}
+
+	Entity CommandBuffer::CreateEntity()
+	{
+		//Index 0 is never handed out by the EntityManager, so a placeholder can never be mistaken for a real entity.
+		Entity placeholder = Entity::Make(0, ++placeholderCount);
+		commands.push_back({ EntityCommandType::CreateEntity, -1, placeholder, nullptr, nullptr, nullptr });
+		return placeholder;
+	}
+
+	void CommandBuffer::DestroyEntity(Entity entity)
+	{
+		commands.push_back({ EntityCommandType::DestroyEntity, -1, entity, nullptr, nullptr, nullptr });
+	}
+
+	void* CommandBuffer::AllocateComponent(size_t size, size_t alignment)
+	{
+		while (true)
+		{
+			if (currentBlock < blocks.size())
+			{
+				Block& block = blocks[currentBlock];
+				uintptr_t start = reinterpret_cast<uintptr_t>(block.memory);
+				size_t offset = static_cast<size_t>(((start + blockOffset + alignment - 1) & ~(alignment - 1)) - start);
+				if (offset + size <= block.size)
+				{
+					blockOffset = offset + size;
+					return block.memory + offset;
+				}
+
+				currentBlock++;
+				blockOffset = 0;
+				continue;
+			}
+
+			//Components larger than a block (or over-aligned ones) get a block of their own.
+			size_t blockSize = size + alignment > BlockSize ? size + alignment : BlockSize;
+			unsigned char* memory = static_cast<unsigned char*>(::operator new(blockSize, std::align_val_t(CacheLineSize)));
+			blocks.push_back({ memory, blockSize });
+		}
+	}
+
+	void CommandBuffer::Clear()
+	{
+		for (EntityCommand& command : commands)
+		{
+			if (command.component)
+			{
+				command.typeInfo->destroy(command.component);
+			}
+		}
+
+		commands.clear();
+		currentBlock = 0;
+		blockOffset = 0;
+		placeholderCount = 0;
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <new>
+#include "Entity.h"
+#include "Component.h"
+#include "ComponentManager.h"
+#include "Archetype.h"
+
+///==== Command Buffers ====
+
+///Adding or removing a component changes which systems an entity is registered with, and moves component data around in the component managers (or archetype chunks).
+///Doing that from inside System::Update() would pull the rug from under any system that is iterating the same data, and makes it impossible to update systems in parallel.
+///Instead, systems record their structural changes into a command buffer, and the world plays every buffer back at a sync point, once no system is running.
+
+///Every thread gets a buffer of its own (see World::GetCommandBuffer()), so recording a command is a plain append without any locking.
+///During playback, the commands of all buffers are sorted by component family, so each component manager is visited once per flush,
+///and the systems are only notified once per entity, with the mask the entity ends up with.
+
+///Entities created through a command buffer do not exist until the buffer is played back. CreateEntity() hands out a placeholder that can be used
+///in further commands of the same buffer, and is replaced by the real entity during playback.
+
+namespace EntitySystem
+{
+    class World;
+    struct EntityCommand;
+
+    //Plays back every command of one component family, in the order they were recorded.
+    using CommandPlayback = void (*)(World& world, EntityCommand* commands, size_t count);
+
+    enum class EntityCommandType : unsigned char
+    {
+        CreateEntity,
+        DestroyEntity,
+        AddComponent,
+        RemoveComponent
+    };
+
+    struct EntityCommand
+    {
+        EntityCommandType type;
+        int family;                         //-1 for commands that are not about a component.
+        Entity entity;
+        void* component;                    //The component to move into the world, for AddComponent.
+        const ComponentTypeInfo* typeInfo;  //Used to destroy the component if the buffer is never played back.
+        CommandPlayback playback;
+    };
+
+    class CommandBuffer
+    {
+    public:
+        CommandBuffer() = default;
+        ~CommandBuffer();
+        CommandBuffer(const CommandBuffer&) = delete;
+        CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+        //Returns a placeholder for the entity that will be created on playback. It is only meaningful to commands recorded into this same buffer.
+        Entity CreateEntity();
+        void DestroyEntity(Entity entity);
+
+        //Adding a component the entity already has replaces it, and removing a component it does not have does nothing.
+        template <typename ComponentType>
+        void AddComponent(Entity entity, ComponentType&& component)
+        {
+            using StoredType = std::decay_t<ComponentType>;
+            void* storage = AllocateComponent(sizeof(StoredType), alignof(StoredType));
+            new (storage) StoredType(std::forward<ComponentType>(component));
+            commands.push_back({ EntityCommandType::AddComponent, GetComponentFamily<StoredType>(), entity, storage, ComponentTypeInfo::Get<StoredType>(), &PlayBack<StoredType> });
+        }
+
+        template <typename ComponentType>
+        void RemoveComponent(Entity entity)
+        {
+            commands.push_back({ EntityCommandType::RemoveComponent, GetComponentFamily<ComponentType>(), entity, nullptr, nullptr, &PlayBack<ComponentType> });
+        }
+
+        bool IsEmpty() const { return commands.empty(); }
+        size_t GetCommandCount() const { return commands.size(); }
+
+        //Returns true if the entity is a placeholder returned by CreateEntity().
+        static bool IsPlaceholder(Entity entity) { return entity.Index() == 0 && entity.Generation() != 0; }
+
+    private:
+        friend class World;
+
+        //Defined in World.h, as it needs the full World definition.
+        template <typename ComponentType>
+        static void PlayBack(World& world, EntityCommand* commands, size_t count);
+
+        //Component payloads live in fixed-size blocks that never move, so recording a command never relocates previously recorded components.
+        static constexpr size_t BlockSize = 16 * 1024;
+
+        struct Block
+        {
+            unsigned char* memory;
+            size_t size;
+        };
+
+        void* AllocateComponent(size_t size, size_t alignment);
+
+        //Destroys every component that has not been moved into the world, and forgets all commands. Blocks are kept for the next frame.
+        void Clear();
+
+        std::vector<EntityCommand> commands;
+        std::vector<Block> blocks;
+        size_t currentBlock = 0;
+        size_t blockOffset = 0;
+        unsigned int placeholderCount = 0;
+    };
+}
@@ -1,7 +1,21 @@
 #include "ECSPrecompiledHeader.h"
 #include "Component.h"
+#include <cstdlib>
+#include <iostream>
+#include "ComponentMask.h"
 
 namespace EntitySystem
 {
-	int ComponentCounter::familyCounter = 0;
+	std::atomic<int> ComponentCounter::familyCounter{ ECS_STATIC_COMPONENT_FAMILIES };
+
+	int ComponentCounter::NextFamily()
+	{
+		int family = familyCounter++;
+		if (family >= ECS_MAX_COMPONENT_FAMILIES)
+		{
+			std::cerr << "ComponentCounter: more than " << ECS_MAX_COMPONENT_FAMILIES - ECS_STATIC_COMPONENT_FAMILIES << " dynamically numbered component types, raise ECS_MAX_COMPONENT_FAMILIES." << std::endl;
+			std::abort();
+		}
+		return family;
+	}
 }
\ No newline at end of file
@@ -1,25 +1,60 @@
 #pragma once
 #include "ECSPrecompiledHeader.h"
+#include <atomic>
 
 //This is the base implementation of a component. Simply inherit from this to create your own custom components. 
+
+//Families below this number are reserved for components given a fixed family with ECS_COMPONENT_FAMILY, every other component is numbered from here on in the order it is first used.
+//Can be changed at compile time (for example -DECS_STATIC_COMPONENT_FAMILIES=64), and must stay below ECS_MAX_COMPONENT_FAMILIES.
+//The reserved families count against the width of the masks: with the defaults, 32 of the 256 families are reserved, which leaves 224 for dynamically numbered components.
+//Programs with more component types raise ECS_MAX_COMPONENT_FAMILIES, or lower this when they use fewer fixed families.
+#ifndef ECS_STATIC_COMPONENT_FAMILIES
+#define ECS_STATIC_COMPONENT_FAMILIES 32
+#endif
+
 namespace EntitySystem
 {
 	//Each component stores a unique family ID that corresponds to its component type. 
 	//All components now inherit from a class which has a static member that is shared across all components. That counter counts up from 0 and each ID belongs to a unique component family.
 	//As each new component is called, they are assigned a family by a static line (this will only get run once).
 
+	//Families handed out that way depend on the order components are first used in, which can change from one run (or one build) to the next.
+	//Components that need the same family in every run, or a family known at compile time (see StaticWorld.h), declare it at global scope, after the component:
+	//struct Position : Component<Position> { float x, y; };
+	//ECS_COMPONENT_FAMILY(Position, 0)
+
 	struct ComponentCounter 
 	{
-		static int familyCounter;
+		//Hands out the next dynamic family, and aborts once there is none left below ECS_MAX_COMPONENT_FAMILIES, as masks could not hold it.
+		static int NextFamily();
+
+		static std::atomic<int> familyCounter;  //Atomic, as two threads may use two new component types at the same time.
 	};
 
+	//Specialized (through ECS_COMPONENT_FAMILY) for the components with a fixed family.
+	template <typename ComponentType>
+	struct ComponentFamilyTraits
+	{
+		static constexpr int Family = -1;
+	};
+
+	template <typename ComponentType>
+	constexpr bool HasStaticFamily = ComponentFamilyTraits<std::remove_const_t<ComponentType>>::Family >= 0;
+
 	template <typename ComponentType>
 	struct Component
 	{
 		static inline int ComponentFamily()   //Stores the family ID for this component in here. Since its static, it will only be initialized once. 
 		{
-			static int family = ComponentCounter::familyCounter++;
-			return family;
+			if constexpr (HasStaticFamily<ComponentType>)
+			{
+				return ComponentFamilyTraits<ComponentType>::Family;   //No static, and thus no initialization guard to check on every call.
+			}
+			else
+			{
+				static int family = ComponentCounter::NextFamily();
+				return family;
+			}
 		}
 	};
 
@@ -29,4 +64,28 @@ namespace EntitySystem
 	{
 		return Component<typename std::remove_const<ComponentFamily>::type>::ComponentFamily();
 	}
-}
\ No newline at end of file
+
+	//Components without any data (struct Enemy : Component<Enemy> {};) are tags. They only exist as the bit of their family in the mask of the entity:
+	//with StorageMode::ComponentPools, they get no component manager, pages or entity map, and with StorageMode::Archetypes, their columns take no bytes.
+	//Systems, views and Unpack() still see them, and all hand out the same instance. Tags cannot be grouped, filtered on with Changed<> or Added<>, or saved in snapshots.
+	template <typename ComponentType>
+	constexpr bool IsTagComponent = std::is_empty_v<std::remove_const_t<ComponentType>>;
+
+	template <typename ComponentType>
+	ComponentType& GetTagInstance()
+	{
+		static std::remove_const_t<ComponentType> instance;
+		return instance;
+	}
+}
+
+#define ECS_COMPONENT_FAMILY(ComponentType, FamilyID) \
+	namespace EntitySystem \
+	{ \
+		template <> \
+		struct ComponentFamilyTraits<ComponentType> \
+		{ \
+			static_assert((FamilyID) >= 0 && (FamilyID) < ECS_STATIC_COMPONENT_FAMILIES, "Fixed component families have to be below ECS_STATIC_COMPONENT_FAMILIES."); \
+			static constexpr int Family = (FamilyID); \
+		}; \
+	}
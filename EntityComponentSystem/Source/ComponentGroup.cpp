@@ -0,0 +1,105 @@
+#include "ECSPrecompiledHeader.h"
+#include "ComponentGroup.h"
+#include "ComponentManager.h"
+
+namespace EntitySystem
+{
+	ComponentGroup::ComponentGroup(std::vector<BaseComponentManager*> managers) : managers(std::move(managers))
+	{
+		for (BaseComponentManager* manager : this->managers)
+		{
+			assert(!manager->GetGroup() && "A component pool can only be owned by a single group.");
+			manager->SetGroup(this);
+		}
+		Rebuild();
+	}
+
+	bool ComponentGroup::Contains(Entity entity) const
+	{
+		//Members are in the front part of every pool, so the first one is enough to tell.
+		ComponentInstance instance = managers[0]->FindInstance(entity);
+		return instance != 0 && instance <= size;
+	}
+
+	bool ComponentGroup::Owns(const BaseComponentManager* manager) const
+	{
+		return std::find(managers.begin(), managers.end(), manager) != managers.end();
+	}
+
+	void ComponentGroup::OnComponentAdded(Entity entity)
+	{
+		if (Contains(entity))
+		{
+			return;
+		}
+
+		for (BaseComponentManager* manager : managers)
+		{
+			if (manager->FindInstance(entity) == 0)
+			{
+				return;
+			}
+		}
+
+		MoveTo(entity, size + 1);
+		size++;
+		version++;
+	}
+
+	void ComponentGroup::OnComponentRemoving(Entity entity)
+	{
+		if (!Contains(entity))
+		{
+			return;
+		}
+
+		//The last member takes the place of the leaving one, which then sits right after the front part and is removed from there as usual.
+		MoveTo(entity, size);
+		size--;
+		version++;
+	}
+
+	void ComponentGroup::Rebuild()
+	{
+		size = 0;
+		version++;
+		BaseComponentManager* first = managers[0];
+		for (ComponentInstance instance = 1; instance <= first->GetComponentCount(); instance++)
+		{
+			Entity entity = first->FindEntity(instance);
+			bool member = true;
+			for (size_t other = 1; other < managers.size() && member; other++)
+			{
+				member = managers[other]->FindInstance(entity) != 0;
+			}
+
+			//Only instances already looked at are swapped with this one, so the walk over the first pool goes on undisturbed.
+			if (member)
+			{
+				MoveTo(entity, size + 1);
+				size++;
+			}
+		}
+	}
+
+	void ComponentGroup::Reorder(const std::vector<Entity>& members)
+	{
+		assert(members.size() == size);
+
+		//The entity displaced by every move sits after the ones already placed, so it gets its turn later.
+		for (unsigned int position = 1; position <= size; position++)
+		{
+			assert(Contains(members[position - 1]));
+			MoveTo(members[position - 1], position);
+		}
+		version++;
+	}
+
+	void ComponentGroup::MoveTo(Entity entity, unsigned int position)
+	{
+		for (BaseComponentManager* manager : managers)
+		{
+			manager->SwapInstances(manager->FindInstance(entity), position);
+		}
+	}
+}
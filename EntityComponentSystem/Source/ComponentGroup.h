@@ -0,0 +1,57 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include "Entity.h"
+
+///==== Owning Groups ====
+
+///A view over Transform and Velocity walks one of the two pools, and looks every entity up in the other one through its sparse map.
+///An owning group does away with the lookup by taking over the order of several pools: the entities that have every component of the group
+///are kept at the front of each of the pools (instances 1 to GetSize()), in the same order. Iterating the group is then a linear walk over parallel arrays (see GroupView.h).
+
+///The order is maintained as components come and go: an entity that completes the group is swapped to the end of the front part of every pool,
+///and one about to lose a component is swapped out of it first. That is a handful of swaps per structural change, in exchange for iteration without any lookup,
+///so groups are meant for the few component combinations that are iterated every frame. A pool can only be owned by a single group.
+
+namespace EntitySystem
+{
+    class BaseComponentManager;
+
+    class ComponentGroup
+    {
+    public:
+        //Takes over the order of the pools, sorting them right away. A group lives as long as the world that owns it, and never gives its pools back.
+        explicit ComponentGroup(std::vector<BaseComponentManager*> managers);
+        ComponentGroup(const ComponentGroup&) = delete;
+        ComponentGroup& operator=(const ComponentGroup&) = delete;
+
+        //Number of entities that have every component of the group.
+        unsigned int GetSize() const { return size; }
+        bool Contains(Entity entity) const;
+        bool Owns(const BaseComponentManager* manager) const;
+        size_t GetPoolCount() const { return managers.size(); }
+
+        //Called by the owned managers after an entity gets a component, and before it loses one.
+        void OnComponentAdded(Entity entity);
+        void OnComponentRemoving(Entity entity);
+
+        //Sorts the pools again from scratch, after they have been filled without going through their AddComponent() (for example when loading a snapshot).
+        void Rebuild();
+
+        //Forgets every member, once the pools have been cleared.
+        void Clear() { size = 0; version++; }
+
+        //Moves the members to the front of the pools in the given order, which has to list every member once. Lets a user of the group sort it by a key of its own.
+        void Reorder(const std::vector<Entity>& members);
+
+        //Advances every time the members or their order change, so that code relying on an order it sorted can tell when to sort again.
+        uint32_t GetVersion() const { return version; }
+
+    private:
+        //Swaps the entity with the instance at "position" in every pool.
+        void MoveTo(Entity entity, unsigned int position);
+
+        std::vector<BaseComponentManager*> managers;
+        unsigned int size = 0;
+        uint32_t version = 0;
+    };
+}
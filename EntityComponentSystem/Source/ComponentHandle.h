@@ -6,29 +6,32 @@
 
 namespace EntitySystem
 {
+    class World;
+
     template<typename ComponentType>
     struct ComponentHandle
     {
-        using ExposedComponentType = typename ComponentManager<ComponentType>::LookupType;
+        //ComponentHandle<const T> only gives read access, and does not mark the component as changed when unpacked.
+        using ExposedComponentType = std::conditional_t<std::is_const_v<ComponentType>, const typename ComponentManager<std::remove_const_t<ComponentType>>::LookupType, typename ComponentManager<ComponentType>::LookupType>;
 
         Entity owner;
         ExposedComponentType* component;
-        ComponentManager<ComponentType>* manager;
+        World* world;
 
         //Empty Constructor used for World::Unpack().
         ComponentHandle() {};
-        ComponentHandle(Entity owner, ExposedComponentType* component, ComponentManager<ComponentType>* manager)
+        ComponentHandle(Entity owner, ExposedComponentType* component, World* world)
         {
             this->owner = owner;
             this->component = component;
-            this->manager = manager;
+            this->world = world;
         }
 
         //Handle->Member is the same as handle.component->member.
         ExposedComponentType* operator->() const { return component; }
-        void Destroy() 
-        {
-            manager->DestroyComponent(owner); 
-        }
+
+        //Removal goes through the world (rather than straight to the component manager) so that the entity mask and systems stay in sync, whichever storage backend the world uses.
+        //Defined in World.h, as it needs the full World definition.
+        void Destroy();
     };
 }
\ No newline at end of file
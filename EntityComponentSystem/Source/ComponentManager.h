@@ -1,7 +1,17 @@
 #pragma once
 #include "ECSPrecompiledHeader.h"
+#include <new>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
 #include "Entity.h"
 #include "EntityMap.h"
+#include "DeltaSnapshot.h"
+#include "StructOfArrays.h"
+#include "PageAllocator.h"
+#include "Component.h"
+#include "ComponentGroup.h"
 
 /// ==== Component Managers ====
 
@@ -9,9 +19,10 @@
 ///Rather than having entities hold their own components, all components of the same type are handled by a component manager for that type.
 ///All interactions with the component data thus goes through the component manager.
 ///In this way, when we run update methods on all components of a type, they are held in contiguous memory.
-///Thus, this can lead to a big performance increase on CPU-intensive game components. One important thing to note is that we are going to preallocate this data.
-///This means that this contigous array won't change size through the games running, as changing sizes would be an expensive operation that would involve copying a ton of data.
-///Thus, if we initialize the array at 1024 spots, it will remain at 1024 forever. This means that we will need to keep track of the current size of the array, since we can't just poll array->size().
+///Thus, this can lead to a big performance increase on CPU-intensive game components. One important thing to note is that we never grow the data by reallocating it.
+///Growing a single contigous array would be an expensive operation that would involve copying a ton of data, and would invalidate every pointer handed out to a component.
+///Instead, the data is split into fixed-size pages that are allocated on demand. A full page never moves, so addresses within a page stay stable, and growth only ever costs one new page.
+///We still need to keep track of the current size of the data ourselves, since the pages are raw memory and only the first "size" slots hold live components.
 
 ///We will also be making these component managers "generic".
 ///Held within each component manager is an array of data that holds a bunch of structs - the components.
@@ -26,20 +37,324 @@
 
 namespace EntitySystem
 {
-    //This is our contigous array that will hold all related components.
+    //This is our paged array that will hold all related components. Each page is a contigous block of PageSize components.
     //Setting the initial size to 1 will allow us to catch errors more easily, as anything that tries to access data at Index 0 will automatically be a red alert.
     //In this way, Index 0 becomes the equivalant of Index -1 (if we were using ints instead of unsigned ints) - if were trying to access it or return it, something probably doesnt exist or went wrong.
     //We are using arrays instead of lists/vectors here because:
     //std::list is a linked list, and doesnt really fit our requirements due to both how deletions work (similar to std::vector), and its not built for random access by index.
     //Because we have a map on top of the array (referencing indices in the array), we need the map to remain mostly valid through a removal from the array. If we use std::vector and then need to remove our first component (vec.erase(vec.begin())), all our indices shift (vec[2] becomes vec[1], etc.). This invalidates our entire map and would require a full update of the map.
 
+    //Pages start on a cache line, so that batches of components split on cache line boundaries never share a line (see EntityView::ParallelEach).
+    constexpr size_t CacheLineSize = 64;
+
+    //The page size can be configured per component type by specializing this trait. It must be a power of two so that instance to page lookups are a shift and a mask.
+    //Large, rarely created components may want smaller pages, while tiny components that are iterated every frame benefit from larger ones.
+    template <typename ComponentType>
+    struct ComponentStorageTraits
+    {
+        static constexpr unsigned int PageSize = 1024;
+    };
+
     template <typename ComponentType>
     struct ComponentData
     {
+        static constexpr unsigned int PageSize = ComponentStorageTraits<ComponentType>::PageSize;
+        static_assert(PageSize > 0 && (PageSize & (PageSize - 1)) == 0, "Component page size must be a power of two.");
+
+        ComponentData() = default;
+        ComponentData(const ComponentData&) = delete;
+        ComponentData& operator=(const ComponentData&) = delete;
+
+        ~ComponentData()
+        {
+            Clear();
+        }
+
+        //Destroys every component and releases every page, leaving the storage as it was when created.
+        void Clear()
+        {
+            for (ComponentInstance instance = 1; instance < size; instance++)
+            {
+                (*this)[instance].~ComponentType();
+            }
+
+            for (size_t page = borrowedPages; page < pages.size(); page++)
+            {
+                FreePage(pages[page]);
+            }
+            pages.clear();
+            borrowedPages = 0;
+            borrowedMemoryOwner.reset();
+            size = 1;
+        }
+
+        //Where pages come from, and the family they are accounted under (see PageAllocator.h). Only valid while no page is allocated.
+        void SetAllocator(PageAllocator& pageAllocator, int componentFamily)
+        {
+            assert(pages.empty());
+            allocator = &pageAllocator;
+            family = componentFamily;
+        }
+
+        ComponentType& operator[](ComponentInstance instance) { return pages[instance / PageSize][instance % PageSize]; }
+        unsigned int Capacity() const { return static_cast<unsigned int>(pages.size()) * PageSize; }
+
+        //Makes sure that at least "count" slots (including the reserved slot at Index 0) are backed by pages.
+        void Reserve(unsigned int count)
+        {
+            while (Capacity() < count)
+            {
+                pages.push_back(AllocatePage());
+            }
+        }
+
+        //Releases every page that no longer holds a live component.
+        void ShrinkToFit()
+        {
+            unsigned int pagesInUse = (size + PageSize - 1) / PageSize;
+            while (pages.size() > pagesInUse)
+            {
+                if (pages.size() > borrowedPages)
+                {
+                    FreePage(pages.back());
+                }
+                else
+                {
+                    borrowedPages--;
+                }
+                pages.pop_back();
+            }
+        }
+
+        //Replaces the (empty) storage with pages that live in memory owned by someone else, typically a mapped snapshot (see Snapshot.h).
+        //"owner" is kept alive for as long as the pages are in use. Pages added later on are allocated as usual.
+        void AdoptPages(unsigned char* memory, unsigned int pageCount, std::shared_ptr<void> owner)
+        {
+            for (size_t page = borrowedPages; page < pages.size(); page++)
+            {
+                FreePage(pages[page]);
+            }
+
+            pages.clear();
+            for (unsigned int page = 0; page < pageCount; page++)
+            {
+                pages.push_back(reinterpret_cast<ComponentType*>(memory + static_cast<size_t>(page) * PageSize * sizeof(ComponentType)));
+            }
+            borrowedPages = pageCount;
+            borrowedMemoryOwner = std::move(owner);
+        }
+
         unsigned int size = 1;
-        std::array<ComponentType, MAX_NUMBER_OF_COMPONENTS>* data;
+        std::vector<ComponentType*> pages;
+
+        static constexpr size_t PageAlignment = alignof(ComponentType) > CacheLineSize ? alignof(ComponentType) : CacheLineSize;
+
+    private:
+        //The first borrowedPages pages are not ours to free.
+        unsigned int borrowedPages = 0;
+        std::shared_ptr<void> borrowedMemoryOwner;
+
+        PageAllocator* allocator = &HeapPageAllocator::Get();
+        int family = 0;
+
+        ComponentType* AllocatePage()
+        {
+            return static_cast<ComponentType*>(allocator->Allocate(family, sizeof(ComponentType) * PageSize, PageAlignment));
+        }
+
+        void FreePage(ComponentType* page)
+        {
+            allocator->Free(family, page, sizeof(ComponentType) * PageSize, PageAlignment);
+        }
     };
 
+    //The storage of components declared with ECS_STRUCT_OF_ARRAYS (see StructOfArrays.h). A page holds one array of PageSize values per field, back to back, every array starting on a cache line.
+    //A page is exactly as large as a page of whole components would be, so snapshots write and adopt pages the same way for both layouts.
+    template <typename ComponentType>
+    struct StructOfArraysComponentData
+    {
+        using Fields = FieldList<ComponentType>;
+        static constexpr unsigned int PageSize = ComponentStorageTraits<ComponentType>::PageSize;
+        static constexpr auto FieldOffsets = GetFieldArrayOffsets(Fields::Sizes, PageSize);
+        static constexpr size_t PageAlignment = CacheLineSize;
+
+        static_assert(PageSize > 0 && (PageSize & (PageSize - 1)) == 0, "Component page size must be a power of two.");
+        static_assert(PageSize % CacheLineSize == 0, "Structure of arrays pages need at least a cache line worth of values, so that every field array starts on a cache line.");
+        static_assert(std::is_trivially_copyable_v<ComponentType> && alignof(ComponentType) <= CacheLineSize, "Structure of arrays components have to be trivially copyable.");
+        static_assert(!HasComponentSerializer<ComponentType>::value, "Structure of arrays components are always snapshotted as raw field pages, and cannot have a ComponentSerializer.");
+        static_assert(FieldOffsets[Fields::Count] == PageSize * sizeof(ComponentType), "The fields of a structure of arrays component have to cover all of its bytes: declare every member, and avoid padding.");
+
+        StructOfArraysComponentData() = default;
+        StructOfArraysComponentData(const StructOfArraysComponentData&) = delete;
+        StructOfArraysComponentData& operator=(const StructOfArraysComponentData&) = delete;
+
+        ~StructOfArraysComponentData()
+        {
+            Clear();
+        }
+
+        //Same as ComponentData. The fields are trivially copyable, so there is nothing to destroy.
+        void Clear()
+        {
+            for (size_t page = borrowedPages; page < pages.size(); page++)
+            {
+                FreePage(pages[page]);
+            }
+            pages.clear();
+            borrowedPages = 0;
+            borrowedMemoryOwner.reset();
+            size = 1;
+        }
+
+        //Same as ComponentData.
+        void SetAllocator(PageAllocator& pageAllocator, int componentFamily)
+        {
+            assert(pages.empty());
+            allocator = &pageAllocator;
+            family = componentFamily;
+        }
+
+        unsigned int Capacity() const { return static_cast<unsigned int>(pages.size()) * PageSize; }
+
+        template <size_t Field>
+        typename Fields::template FieldType<Field>* GetFieldArray(unsigned int page) { return reinterpret_cast<typename Fields::template FieldType<Field>*>(pages[page] + FieldOffsets[Field]); }
+        unsigned char* GetFieldBytes(unsigned int page, size_t field) { return pages[page] + FieldOffsets[field]; }
+
+        //Gathers the fields of a component into a whole one.
+        ComponentType Load(ComponentInstance instance)
+        {
+            alignas(ComponentType) unsigned char bytes[sizeof(ComponentType)];
+            ComponentType* component = std::launder(reinterpret_cast<ComponentType*>(bytes));
+            Fields::ForEach([this, component, instance](auto field)
+            {
+                (*component).*Fields::template Member<decltype(field)::value> = GetFieldArray<decltype(field)::value>(instance / PageSize)[instance % PageSize];
+            });
+            return *component;
+        }
+
+        //Scatters a whole component into its fields.
+        void Store(ComponentInstance instance, const ComponentType& component)
+        {
+            Fields::ForEach([this, &component, instance](auto field)
+            {
+                GetFieldArray<decltype(field)::value>(instance / PageSize)[instance % PageSize] = component.*Fields::template Member<decltype(field)::value>;
+            });
+        }
+
+        void Move(ComponentInstance from, ComponentInstance to)
+        {
+            Fields::ForEach([this, from, to](auto field)
+            {
+                GetFieldArray<decltype(field)::value>(to / PageSize)[to % PageSize] = GetFieldArray<decltype(field)::value>(from / PageSize)[from % PageSize];
+            });
+        }
+
+        //Same as ComponentData.
+        void Reserve(unsigned int count)
+        {
+            while (Capacity() < count)
+            {
+                pages.push_back(AllocatePage());
+            }
+        }
+
+        void ShrinkToFit()
+        {
+            unsigned int pagesInUse = (size + PageSize - 1) / PageSize;
+            while (pages.size() > pagesInUse)
+            {
+                if (pages.size() > borrowedPages)
+                {
+                    FreePage(pages.back());
+                }
+                else
+                {
+                    borrowedPages--;
+                }
+                pages.pop_back();
+            }
+        }
+
+        void AdoptPages(unsigned char* memory, unsigned int pageCount, std::shared_ptr<void> owner)
+        {
+            for (size_t page = borrowedPages; page < pages.size(); page++)
+            {
+                FreePage(pages[page]);
+            }
+
+            pages.clear();
+            for (unsigned int page = 0; page < pageCount; page++)
+            {
+                pages.push_back(memory + static_cast<size_t>(page) * FieldOffsets[Fields::Count]);
+            }
+            borrowedPages = pageCount;
+            borrowedMemoryOwner = std::move(owner);
+        }
+
+        unsigned int size = 1;
+        std::vector<unsigned char*> pages;
+
+    private:
+        unsigned int borrowedPages = 0;
+        std::shared_ptr<void> borrowedMemoryOwner;
+
+        PageAllocator* allocator = &HeapPageAllocator::Get();
+        int family = 0;
+
+        unsigned char* AllocatePage()
+        {
+            return static_cast<unsigned char*>(allocator->Allocate(family, FieldOffsets[Fields::Count], PageAlignment));
+        }
+
+        void FreePage(unsigned char* page)
+        {
+            allocator->Free(family, page, FieldOffsets[Fields::Count], PageAlignment);
+        }
+    };
+
+    //The storage a component type uses in its pool.
+    template <typename ComponentType>
+    using ComponentStorage = std::conditional_t<IsStructOfArrays<ComponentType>, StructOfArraysComponentData<ComponentType>, ComponentData<ComponentType>>;
+
+    //Turns the entities of one world into those of another, for components moving between worlds (see WorldStreaming.h). Entities it was not told about become Entity().
+    class EntityRemap
+    {
+    public:
+        void Add(Entity from, Entity to)
+        {
+            if (from.Index() >= sources.size())
+            {
+                sources.resize(from.Index() + 1);
+                targets.resize(from.Index() + 1);
+            }
+            sources[from.Index()] = from;
+            targets[from.Index()] = to;
+        }
+
+        Entity operator()(Entity entity) const
+        {
+            return entity.Index() < sources.size() && sources[entity.Index()] == entity && entity != Entity() ? targets[entity.Index()] : Entity();
+        }
+
+    private:
+        std::vector<Entity> sources;
+        std::vector<Entity> targets;
+    };
+
+    //Components that hold entities of their own world (links to other entities, for example) specialize this, so that the entities follow them into another world:
+    //static void Remap(ComponentType& component, const EntityRemap& remap);
+    template <typename ComponentType>
+    struct ComponentEntityRemapper
+    {
+        static constexpr bool IsDefault = true;
+    };
+
+    template <typename ComponentType, typename = void>
+    struct HasEntityRemapper : std::true_type {};
+
+    template <typename ComponentType>
+    struct HasEntityRemapper<ComponentType, std::void_t<decltype(ComponentEntityRemapper<ComponentType>::IsDefault)>> : std::false_type {};
+
     class BaseComponentManager
     {
     public:
@@ -49,27 +364,105 @@ namespace EntitySystem
         BaseComponentManager& operator=(const BaseComponentManager&) = default;
         BaseComponentManager(BaseComponentManager&&) = default;
         BaseComponentManager& operator=(BaseComponentManager&&) = default;
+
+        //Lets the world tear down the components of a destroyed entity without knowing their types.
+        virtual void DestroyComponent(Entity entity) = 0;
+
+        //Destroys every component and releases every page (see World::Reset()).
+        virtual void Clear() = 0;
+
+        //==== Groups ====
+        //What an owning group needs to keep the pool in order without knowing the component type (see ComponentGroup.h).
+        virtual ComponentInstance FindInstance(Entity entity) const = 0;
+        virtual Entity FindEntity(ComponentInstance instance) const = 0;
+        virtual unsigned int GetComponentCount() const = 0;
+        virtual void SwapInstances(ComponentInstance first, ComponentInstance second) = 0;
+
+        ComponentGroup* GetGroup() const { return group; }
+        void SetGroup(ComponentGroup* owner) { group = owner; }
+
+        //==== Streaming ====
+        //What moving components between worlds needs without knowing their types (see WorldStreaming.h).
+        //An empty manager of the same component type, allocating from the given allocator.
+        virtual std::unique_ptr<BaseComponentManager> MakeEmpty(PageAllocator& allocator) const = 0;
+
+        //The owner of every instance, instance 0 being the reserved invalid one.
+        virtual const Entity* GetEntities() const = 0;
+
+        //Makes room for "count" components, so that appending them later does not have to grow the pool.
+        virtual void Reserve(unsigned int count) = 0;
+
+        //Appends the components the listed entities have in "source", a manager of the same type in another world, under the entities "remap" turns them into.
+        //The source components are moved from, and left for the source world to destroy.
+        virtual void AppendFrom(BaseComponentManager& source, const Entity* entities, size_t count, const EntityRemap& remap) = 0;
+
+        //==== Prefabs ====
+        //Appends a copy of the component "prototype" has in "source", a manager of the same type elsewhere, for each of the listed entities (see Prefab.h).
+        virtual void AppendCopies(BaseComponentManager& source, Entity prototype, const Entity* entities, size_t count) = 0;
+
+        //False for component types that cannot be copy constructed, which prefabs cannot hold.
+        virtual bool IsCopyable() const = 0;
+
+        //==== Change Tracking ====
+        //Every component instance remembers the tick it was added at, and the last tick it was handed out for writing at (see World::GetChangeTick()).
+        //The tick is read from the world that owns the manager. A manager that does not belong to a world stamps everything with tick 1.
+        void SetChangeTickSource(const std::atomic<uint32_t>* source) { changeTickSource = source; }
+        uint32_t GetChangeTick() const { return changeTickSource ? changeTickSource->load(std::memory_order_relaxed) : 1; }
+
+    protected:
+        ComponentGroup* group = nullptr;
+
+    private:
+        const std::atomic<uint32_t>* changeTickSource = nullptr;
+    };
+
+    //The highest versions of any component in a page, so that a query only interested in changes can skip a whole page with a single comparison.
+    //Parallel iteration stamps the same page from several threads, hence the atomics.
+    struct PageVersions
+    {
+        std::atomic<uint32_t> added{ 0 };
+        std::atomic<uint32_t> changed{ 0 };
     };
 
     template <typename ComponentType>
     class ComponentManager : public BaseComponentManager {
     public:
         using LookupType = ComponentType;
+        static constexpr unsigned int PageSize = ComponentStorage<ComponentType>::PageSize;
+        static constexpr bool StructOfArrays = IsStructOfArrays<ComponentType>;
 
-        ComponentManager()
+        //Pages come from the given allocator. Managers created by a World use its arena (see World::GetComponentManager()), others go to the heap.
+        explicit ComponentManager(PageAllocator& allocator = HeapPageAllocator::Get())
         {
-            componentData.data = static_cast<std::array<ComponentType, 1024>*>(malloc(sizeof(ComponentType) * 1024));
+            componentData.SetAllocator(allocator, GetComponentFamily<ComponentType>());
         }
 
         //When adding a component, we just need to make sure that both our data structures are correctly updated.
         //We need to add the component to the end of our list, as well as adding a mapping from the Entity to the index in the list.
 
-        ComponentInstance AddComponent(Entity entity, ComponentType& component) 
+        ComponentInstance AddComponent(Entity entity, ComponentType&& component) 
         {
-            ComponentInstance newInstance = componentData.size;   //ComponentInstance maps to an unsigned integer. This creates a new integer that is essentially the size of the current list of components.
-            componentData.data->at(newInstance) = component;      //We set the data at the new index to our component.
-            entityMap.Add(entity, newInstance);                   //We create a new map that links our entity and the component's index in the list together.
-            componentData.size++;                                 //Finally, we increase the size of the component list.
+            ComponentInstance newInstance = componentData.size;                          //ComponentInstance maps to an unsigned integer. This creates a new integer that is essentially the size of the current list of components.
+            componentData.Reserve(newInstance + 1);                                      //Allocates a new page if the last one is full. Existing pages are never touched.
+            if constexpr (StructOfArrays)
+            {
+                componentData.Store(newInstance, component);                             //Structure of arrays components are split into their fields instead.
+            }
+            else
+            {
+                new (&componentData[newInstance]) ComponentType(std::move(component));   //We construct the component in place at the new index.
+            }
+            entityMap.Add(entity, newInstance);                                          //We create a new map that links our entity and the component's index in the list together.
+            componentData.size++;                                                        //Finally, we increase the size of the component list.
+
+            uint32_t tick = GetChangeTick();                                             //A new component counts as both added and changed.
+            SetVersions(newInstance, tick, tick);
+
+            if (group)
+            {
+                group->OnComponentAdded(entity);                                         //Moves the component to the front part of the pool if it completes its group.
+                return entityMap.GetInstance(entity);
+            }
             return newInstance;
         }
 
@@ -80,19 +473,50 @@ namespace EntitySystem
         //We solve this by taking the last item in the list and moving it to fill whichever item's spot that was removed.
         //In this way, we're guarenteed to always have tightly packed data, at the cost of the slight overhead of copying a component and updating its index in the hashmap.
 
-        void DestroyComponent(Entity entity)
+        void DestroyComponent(Entity entity) override
         {
-            //Gets the instance number of the entity in question. 
+            //Instance 0 is the reserved slot every entity without the component maps to. Swapping the last component into it would corrupt the pool.
+            if (entityMap.GetInstance(entity) == 0)
+            {
+                assert(false && "The entity does not have the component.");
+                return;
+            }
+
+            //An entity leaving a group is first moved out of the front part of the pools, which the swap below would otherwise break.
+            if (group)
+            {
+                group->OnComponentRemoving(entity);
+            }
+
+            //Gets the instance number of the entity in question (the group may have moved it). 
             ComponentInstance instance = entityMap.GetInstance(entity);
 
             //Move the last component to the deleted position to maintain data coherence.
             ComponentInstance lastComponent = componentData.size - 1;
-            componentData.data[instance] = componentData.data[lastComponent];
-            Entity lastEntity = entityMap.GetEntity(lastComponent);
-
-            //Update our map with the changes.
             entityMap.Remove(entity);
-            entityMap.Update(lastEntity, instance);
+
+            if (instance != lastComponent)
+            {
+                if constexpr (StructOfArrays)
+                {
+                    componentData.Move(lastComponent, instance);
+                }
+                else
+                {
+                    componentData[instance] = std::move(componentData[lastComponent]);
+                }
+                Entity lastEntity = entityMap.GetEntity(lastComponent);
+
+                //Update our map with the changes.
+                entityMap.Update(lastEntity, instance);
+
+                //The versions travel with the component, so moving it does not count as a change.
+                SetVersions(instance, addedVersions[lastComponent], changedVersions[lastComponent]);
+            }
+            if constexpr (!StructOfArrays)
+            {
+                componentData[lastComponent].~ComponentType();
+            }
 
             //Reduces the size of the list now that we have destroyed a component and moved the last item to its position.
             componentData.size--;
@@ -100,15 +524,742 @@ namespace EntitySystem
 
         //To access a component from an entity, we first lookup the entity in the hashmap to find where in the array the component is held.
         //Once we have the index, we simply return the component at the index in the array. 
+        //Entities without the component get nullptr: their instance is 0, the reserved slot, which holds no component.
 
         LookupType* LookupComponent(Entity entity) 
         {
+            static_assert(!StructOfArrays, "Structure of arrays components are never stored whole, so they cannot be looked up by reference. Use a view (see StructOfArrays.h).");
             ComponentInstance instance = entityMap.GetInstance(entity);
-            return &componentData.data->at(instance);
+            assert(instance != 0 && "The entity does not have the component.");
+            return instance != 0 ? &componentData[instance] : nullptr;
+        }
+
+        //Same as LookupComponent(), but also marks the component as changed.
+        LookupType* LookupComponentForWrite(Entity entity)
+        {
+            static_assert(!StructOfArrays, "Structure of arrays components are never stored whole, so they cannot be looked up by reference. Use a view (see StructOfArrays.h).");
+            ComponentInstance instance = entityMap.GetInstance(entity);
+            assert(instance != 0 && "The entity does not have the component.");
+            if (instance == 0)
+            {
+                return nullptr;
+            }
+            MarkChanged(instance, GetChangeTick());
+            return &componentData[instance];
+        }
+
+        //Raw access to the two sides of the entity map, used by views to iterate without going through LookupComponent().
+        ComponentInstance GetInstance(Entity entity) const { return entityMap.GetInstance(entity); }
+        Entity GetEntity(ComponentInstance instance) { return entityMap.GetEntity(instance); }
+        const Entity* GetEntities() const override { return entityMap.instanceToEntity.data(); }
+        ComponentType& GetComponent(ComponentInstance instance) { return componentData[instance]; }
+
+        //Whole copies of structure of arrays components, gathered from and scattered to their fields.
+        ComponentType LoadComponent(ComponentInstance instance) { return componentData.Load(instance); }
+        void StoreComponent(ComponentInstance instance, const ComponentType& component) { componentData.Store(instance, component); }
+
+        //Number of live components held by this manager.
+        unsigned int GetSize() const { return componentData.size - 1; }
+        unsigned int GetCapacity() const { return componentData.Capacity(); }
+
+        //Preallocates enough pages to hold "count" components without any further allocations.
+        //The arrays beside the pages at least double when they have to grow, so that reserving a little more every time (see WorldMerge) stays amortized.
+        void Reserve(unsigned int count) override
+        {
+            componentData.Reserve(count + 1);
+            entityMap.Reserve(count + 1);
+            if (count + 1 > addedVersions.capacity())
+            {
+                addedVersions.reserve(std::max<size_t>(count + 1, 2 * addedVersions.capacity()));
+                changedVersions.reserve(std::max<size_t>(count + 1, 2 * changedVersions.capacity()));
+            }
         }
 
+        //Frees the pages left empty after components have been destroyed.
+        void ShrinkToFit()
+        {
+            componentData.ShrinkToFit();
+            addedVersions.resize(componentData.size);
+            changedVersions.resize(componentData.size);
+            addedVersions.shrink_to_fit();
+            changedVersions.shrink_to_fit();
+        }
+
+        //Unlike destroying the components one by one, nothing is moved around and the entity map is dropped at once.
+        void Clear() override
+        {
+            if (group)
+            {
+                group->Clear();
+            }
+            componentData.Clear();
+            entityMap.Clear();
+            addedVersions.clear();
+            changedVersions.clear();
+            pageVersions.reset();
+            pageVersionCount = 0;
+        }
+
+        ComponentInstance FindInstance(Entity entity) const override { return entityMap.GetInstance(entity); }
+        Entity FindEntity(ComponentInstance instance) const override { return entityMap.instanceToEntity[instance]; }
+        unsigned int GetComponentCount() const override { return GetSize(); }
+
+        //Swapping does not count as a change: the versions travel with the components.
+        void SwapInstances(ComponentInstance first, ComponentInstance second) override
+        {
+            if (first == second)
+            {
+                return;
+            }
+
+            if constexpr (StructOfArrays)
+            {
+                ComponentType component = componentData.Load(first);
+                componentData.Move(second, first);
+                componentData.Store(second, component);
+            }
+            else
+            {
+                std::swap(componentData[first], componentData[second]);
+            }
+
+            Entity firstEntity = entityMap.GetEntity(first);
+            Entity secondEntity = entityMap.GetEntity(second);
+            entityMap.Update(firstEntity, second);
+            entityMap.Update(secondEntity, first);
+
+            uint32_t firstAdded = addedVersions[first];
+            uint32_t firstChanged = changedVersions[first];
+            SetVersions(first, addedVersions[second], changedVersions[second]);
+            SetVersions(second, firstAdded, firstChanged);
+        }
+
+        //Records that the component has been handed out for writing at the given tick. Safe to call from several threads, as long as they stamp different instances.
+        void MarkChanged(ComponentInstance instance, uint32_t tick)
+        {
+            changedVersions[instance] = tick;
+            MarkPageChanged(instance / PageSize, tick);
+        }
+
+        //Lets a view stamp a whole run of instances through GetChangedVersions(), and then the page they are in once.
+        void MarkPageChanged(unsigned int page, uint32_t tick) { pageVersions[page].changed.store(tick, std::memory_order_relaxed); }
+        uint32_t* GetChangedVersions() { return changedVersions.data(); }
+
+        //==== Streaming ====
+        std::unique_ptr<BaseComponentManager> MakeEmpty(PageAllocator& allocator) const override { return std::make_unique<ComponentManager<ComponentType>>(allocator); }
+
+        void AppendFrom(BaseComponentManager& sourceManager, const Entity* entities, size_t count, const EntityRemap& remap) override
+        {
+            ComponentManager<ComponentType>& source = static_cast<ComponentManager<ComponentType>&>(sourceManager);
+            constexpr bool Copyable = !StructOfArrays && std::is_trivially_copyable_v<ComponentType>;
+            static_assert(!(StructOfArrays && HasEntityRemapper<ComponentType>::value), "Structure of arrays components are never stored whole, so they cannot have a ComponentEntityRemapper.");
+            Reserve(GetSize() + static_cast<unsigned int>(count));
+            uint32_t tick = GetChangeTick();
+
+            size_t index = 0;
+            while (index < count)
+            {
+                ComponentInstance from = source.entityMap.GetInstance(entities[index]);
+                ComponentInstance to = componentData.size;
+                assert(from != 0 && "Only entities that have the component can be appended.");
+
+                //Trivially copyable components go over in runs of consecutive source instances, as long as neither side crosses a page.
+                size_t run = 1;
+                if constexpr (Copyable)
+                {
+                    size_t limit = std::min<size_t>({ count - index, PageSize - from % PageSize, PageSize - to % PageSize });
+                    while (run < limit && source.entityMap.GetInstance(entities[index + run]) == from + run)
+                    {
+                        run++;
+                    }
+                    std::memcpy(static_cast<void*>(&componentData[to]), &source.componentData[from], run * sizeof(ComponentType));
+                }
+                else if constexpr (StructOfArrays)
+                {
+                    componentData.Store(to, source.componentData.Load(from));
+                }
+                else
+                {
+                    new (&componentData[to]) ComponentType(std::move(source.componentData[from]));
+                }
+
+                for (size_t offset = 0; offset < run; offset++)
+                {
+                    entityMap.Add(remap(entities[index + offset]), to + static_cast<ComponentInstance>(offset));
+                    SetVersions(to + static_cast<ComponentInstance>(offset), tick, tick);
+                    if constexpr (HasEntityRemapper<ComponentType>::value && !StructOfArrays)
+                    {
+                        ComponentEntityRemapper<ComponentType>::Remap(componentData[to + static_cast<ComponentInstance>(offset)], remap);
+                    }
+                }
+                componentData.size += static_cast<ComponentInstance>(run);
+                index += run;
+            }
+
+            //Joining a group swaps instances around, so the new components are found through their entities.
+            if (group)
+            {
+                for (size_t offset = 0; offset < count; offset++)
+                {
+                    group->OnComponentAdded(remap(entities[offset]));
+                }
+            }
+        }
+
+        //==== Prefabs ====
+        bool IsCopyable() const override { return std::is_copy_constructible_v<ComponentType>; }
+
+        void AppendCopies(BaseComponentManager& sourceManager, Entity prototype, const Entity* entities, size_t count) override
+        {
+            if constexpr (!std::is_copy_constructible_v<ComponentType>)
+            {
+                //Prefab::Set() and World::CreatePrefab() keep such components out of prefabs, so this is never reached.
+                std::abort();
+            }
+            else
+            {
+                ComponentManager<ComponentType>& source = static_cast<ComponentManager<ComponentType>&>(sourceManager);
+                ComponentInstance from = source.entityMap.GetInstance(prototype);
+                assert(from != 0 && "The prototype does not have the component.");
+                Reserve(GetSize() + static_cast<unsigned int>(count));
+                ComponentInstance first = componentData.size;
+
+                if constexpr (StructOfArrays)
+                {
+                    ComponentType component = source.componentData.Load(from);
+                    for (size_t offset = 0; offset < count; offset++)
+                    {
+                        componentData.Store(first + static_cast<ComponentInstance>(offset), component);
+                    }
+                }
+                else if constexpr (std::is_trivially_copyable_v<ComponentType>)
+                {
+                    //The prototype is copied once per page, and the run filled so far is then copied over the rest of the page, doubling it every time.
+                    size_t index = 0;
+                    while (index < count)
+                    {
+                        ComponentInstance to = first + static_cast<ComponentInstance>(index);
+                        size_t run = std::min<size_t>(count - index, PageSize - to % PageSize);
+                        ComponentType* destination = &componentData[to];
+                        std::memcpy(static_cast<void*>(destination), &source.componentData[from], sizeof(ComponentType));
+                        for (size_t filled = 1; filled < run; filled *= 2)
+                        {
+                            std::memcpy(static_cast<void*>(destination + filled), destination, std::min(filled, run - filled) * sizeof(ComponentType));
+                        }
+                        index += run;
+                    }
+                }
+                else
+                {
+                    const ComponentType& component = source.componentData[from];
+                    for (size_t offset = 0; offset < count; offset++)
+                    {
+                        new (&componentData[first + static_cast<ComponentInstance>(offset)]) ComponentType(component);
+                    }
+                }
+
+                uint32_t tick = GetChangeTick();
+                entityMap.AddRange(entities, first, count);
+                SetVersionRange(first, count, tick, tick);
+                componentData.size += static_cast<ComponentInstance>(count);
+
+                if (group)
+                {
+                    for (size_t offset = 0; offset < count; offset++)
+                    {
+                        group->OnComponentAdded(entities[offset]);
+                    }
+                }
+            }
+        }
+
+        //==== Snapshots ====
+        //Appends the components to a snapshot and fills in the block describing them (see Snapshot.h).
+        //Components with a ComponentSerializer are written through it, other ones have to be trivially copyable and are written as raw pages.
+        void SaveSnapshot(SnapshotWriter& writer, SnapshotBlock& block)
+        {
+            block.componentSize = sizeof(ComponentType);
+            block.pageSize = PageSize;
+            block.instanceCount = componentData.size;
+
+            writer.Align(CacheLineSize);
+            block.entitiesOffset = writer.GetOffset();
+            writer.Write(Entity{ 0 });
+            writer.Write(GetEntities() + 1, (componentData.size - 1) * sizeof(Entity));
+
+            if constexpr (HasComponentSerializer<ComponentType>::value)
+            {
+                block.encoding = SnapshotEncoding::Serialized;
+                block.dataOffset = writer.GetOffset();
+                for (ComponentInstance instance = 1; instance < componentData.size; instance++)
+                {
+                    ComponentSerializer<ComponentType>::Save(writer, componentData[instance]);
+                }
+            }
+            else
+            {
+                static_assert(std::is_trivially_copyable_v<ComponentType>, "Components that are not trivially copyable need a ComponentSerializer to be saved.");
+
+                //Whole pages are written, so that the last adopted page has room to grow into. The reserved slot and the unused tail are zeroed.
+                block.encoding = StructOfArrays ? SnapshotEncoding::FieldPages : SnapshotEncoding::RawPages;
+                writer.Align(SnapshotPageAlignment);
+                block.dataOffset = writer.GetOffset();
+                for (unsigned int page = 0; page < GetPageCount(); page++)
+                {
+                    ComponentInstance first = page == 0 ? 1 : page * PageSize;
+                    ComponentInstance last = std::min((page + 1) * PageSize, componentData.size);
+                    if constexpr (StructOfArrays)
+                    {
+                        //Same thing, field array by field array.
+                        for (size_t field = 0; field < FieldList<ComponentType>::Count; field++)
+                        {
+                            size_t fieldSize = FieldList<ComponentType>::Sizes[field];
+                            writer.WriteZeros((first - page * PageSize) * fieldSize);
+                            writer.Write(componentData.GetFieldBytes(page, field) + (first - page * PageSize) * fieldSize, (last - first) * fieldSize);
+                            writer.WriteZeros(((page + 1) * PageSize - last) * fieldSize);
+                        }
+                    }
+                    else
+                    {
+                        writer.WriteZeros((first - page * PageSize) * sizeof(ComponentType));
+                        writer.Write(&componentData[first], (last - first) * sizeof(ComponentType));
+                        writer.WriteZeros(((page + 1) * PageSize - last) * sizeof(ComponentType));
+                    }
+                }
+            }
+            block.dataSize = writer.GetOffset() - block.dataOffset;
+        }
+
+        //Loads the components of a snapshot block into this (empty) manager. Raw pages are adopted straight from the mapped file when they are suitably aligned, and copied otherwise.
+        //Returns false if the block does not match this component type.
+        bool LoadSnapshot(const std::shared_ptr<MemoryMappedFile>& file, const SnapshotBlock& block)
+        {
+            uint64_t entitiesSize = static_cast<uint64_t>(block.instanceCount) * sizeof(Entity);
+            if (GetSize() != 0 || block.instanceCount == 0 || block.entitiesOffset + entitiesSize > file->GetSize() || block.dataOffset + block.dataSize > file->GetSize())
+            {
+                return false;
+            }
+
+            const Entity* entities = reinterpret_cast<const Entity*>(file->GetData() + block.entitiesOffset);
+            unsigned char* data = file->GetData() + block.dataOffset;
+
+            if constexpr (HasComponentSerializer<ComponentType>::value)
+            {
+                if (block.encoding != SnapshotEncoding::Serialized)
+                {
+                    return false;
+                }
+
+                SnapshotReader reader(data, block.dataSize);
+                Reserve(block.instanceCount - 1);
+                for (ComponentInstance instance = 1; instance < block.instanceCount && !reader.Failed(); instance++)
+                {
+                    AddComponent(entities[instance], ComponentSerializer<ComponentType>::Load(reader));
+                }
+                return !reader.Failed();
+            }
+            else
+            {
+                unsigned int pageCount = (block.instanceCount + PageSize - 1) / PageSize;
+                size_t pageBytes = static_cast<size_t>(PageSize) * sizeof(ComponentType);
+                SnapshotEncoding encoding = StructOfArrays ? SnapshotEncoding::FieldPages : SnapshotEncoding::RawPages;
+                if (block.encoding != encoding || block.componentSize != sizeof(ComponentType) || block.pageSize != PageSize || block.dataSize < pageCount * pageBytes)
+                {
+                    return false;
+                }
+
+                if (reinterpret_cast<uintptr_t>(data) % ComponentStorage<ComponentType>::PageAlignment == 0)
+                {
+                    componentData.AdoptPages(data, pageCount, file);
+                }
+                else
+                {
+                    componentData.Reserve(block.instanceCount);
+                    for (unsigned int page = 0; page < pageCount; page++)
+                    {
+                        std::memcpy(componentData.pages[page], data + page * pageBytes, pageBytes);
+                    }
+                }
+
+                componentData.size = block.instanceCount;
+                entityMap.Assign(entities, block.instanceCount);
+
+                //Everything that comes out of a snapshot counts as newly added.
+                uint32_t tick = GetChangeTick();
+                addedVersions.assign(block.instanceCount, tick);
+                changedVersions.assign(block.instanceCount, tick);
+                for (unsigned int page = 0; page < pageCount; page++)
+                {
+                    SetVersions(page * PageSize, tick, tick);
+                }
+                return true;
+            }
+        }
+
+        //==== Delta Snapshots ====
+        //Appends the components added, removed or changed since "sinceTick" to a delta, and brings the baseline up to date (see DeltaSnapshot.h).
+        //"generations" are those of the entity manager, which tell which entity currently lives at every index.
+        void EncodeDelta(SnapshotWriter& writer, ComponentDeltaBaseline& baseline, uint32_t sinceTick, const std::vector<unsigned int>& generations, DeltaStats& stats)
+        {
+            constexpr bool Serialized = HasComponentSerializer<ComponentType>::value;
+            constexpr size_t ValueSize = Serialized ? 0 : sizeof(ComponentType);
+            baseline.present.resize(generations.size(), 0);
+            baseline.values.resize(generations.size() * ValueSize, 0);
+
+            //Pairs of entity index and instance. Components re-added since the previous delta count as added, as the replica lost the previous one along the way.
+            std::vector<std::pair<unsigned int, ComponentInstance>> added;
+            std::vector<std::pair<unsigned int, ComponentInstance>> changed;
+            unsigned int newlyPresent = 0;
+            const Entity* entities = GetEntities();
+
+            for (unsigned int page = 0; page < GetPageCount(); page++)
+            {
+                //Adding a component stamps it as changed too, so the changed version alone tells whether anything happened in the page.
+                if (GetPageChangedVersion(page) <= sinceTick)
+                {
+                    continue;
+                }
+
+                ComponentInstance last = std::min((page + 1) * PageSize, componentData.size);
+                for (ComponentInstance instance = page == 0 ? 1 : page * PageSize; instance < last; instance++)
+                {
+                    if (changedVersions[instance] <= sinceTick)
+                    {
+                        continue;
+                    }
+
+                    unsigned int index = entities[instance].Index();
+                    if (!baseline.present[index])
+                    {
+                        newlyPresent++;
+                        added.emplace_back(index, instance);
+                    }
+                    else if (addedVersions[instance] > sinceTick)
+                    {
+                        added.emplace_back(index, instance);
+                    }
+                    else
+                    {
+                        changed.emplace_back(index, instance);
+                    }
+                }
+            }
+
+            //Removed components leave no trace behind, but their number is known. The baseline is only searched for them when there are some.
+            std::vector<unsigned int> removed;
+            alignas(ComponentType) unsigned char scratch[sizeof(ComponentType)];
+            if (baseline.presentCount + newlyPresent > GetSize())
+            {
+                for (unsigned int index = 1; index < baseline.present.size(); index++)
+                {
+                    if (baseline.present[index] && !entityMap.Contains(Entity::Make(index, generations[index])))
+                    {
+                        removed.push_back(index);
+                        baseline.present[index] = 0;
+                    }
+                }
+            }
+            baseline.presentCount = GetSize();
+
+            //Indices are sorted, so that they can be written as the (small) gap from the previous one.
+            writer.WriteVarint(removed.size());
+            unsigned int previous = 0;
+            for (unsigned int index : removed)
+            {
+                writer.WriteVarint(index - previous);
+                previous = index;
+            }
+
+            std::sort(added.begin(), added.end());
+            writer.WriteVarint(added.size());
+            previous = 0;
+            for (const auto& [index, instance] : added)
+            {
+                writer.WriteVarint(index - previous);
+                previous = index;
+                baseline.present[index] = 1;
+                if constexpr (Serialized)
+                {
+                    ComponentSerializer<ComponentType>::Save(writer, componentData[instance]);
+                }
+                else
+                {
+                    const ComponentType& component = ReadComponent(instance, scratch);
+                    writer.Write(&component, sizeof(ComponentType));
+                    std::memcpy(&baseline.values[index * ValueSize], &component, sizeof(ComponentType));
+                }
+            }
+
+            std::sort(changed.begin(), changed.end());
+            if constexpr (Serialized)
+            {
+                writer.WriteVarint(changed.size());
+                previous = 0;
+                for (const auto& [index, instance] : changed)
+                {
+                    writer.WriteVarint(index - previous);
+                    previous = index;
+                    ComponentSerializer<ComponentType>::Save(writer, componentData[instance]);
+                }
+                stats.changedComponents += static_cast<unsigned int>(changed.size());
+            }
+            else
+            {
+                //The baseline is laid out by entity index, so the changed components are one XOR stream over all of it, the unchanged ones being skipped.
+                //Components that were handed out for writing but kept their value are skipped as well.
+                XorRleEncoder encoder(writer);
+                unsigned char xorBytes[sizeof(ComponentType)];
+                unsigned int changedCount = 0;
+                for (const auto& [index, instance] : changed)
+                {
+                    unsigned char* previousValue = &baseline.values[index * ValueSize];
+                    const unsigned char* value = reinterpret_cast<const unsigned char*>(&ReadComponent(instance, scratch));
+                    if (std::memcmp(previousValue, value, sizeof(ComponentType)) == 0)
+                    {
+                        continue;
+                    }
+
+                    changedCount++;
+                    for (size_t i = 0; i < sizeof(ComponentType); i++)
+                    {
+                        xorBytes[i] = previousValue[i] ^ value[i];
+                    }
+                    encoder.Skip(index * ValueSize - encoder.GetPosition());
+                    encoder.Push(xorBytes, sizeof(ComponentType));
+                    std::memcpy(previousValue, value, sizeof(ComponentType));
+                }
+                encoder.Finish();
+                stats.changedComponents += changedCount;
+            }
+
+            stats.addedComponents += static_cast<unsigned int>(added.size());
+            stats.removedComponents += static_cast<unsigned int>(removed.size());
+        }
+
+        //Applies the components of a delta written by EncodeDelta(). Entities that gain or lose a component are appended to "added" and "removed", for the world to update their masks.
+        //Returns false if the delta does not match the components of this manager, which means the replica is out of sync with the stream.
+        bool ApplyDelta(SnapshotReader& reader, const std::vector<unsigned int>& generations, std::vector<Entity>& added, std::vector<Entity>& removed, DeltaStats& stats)
+        {
+            auto entityAt = [&generations](uint64_t index) { return index != 0 && index < generations.size() ? Entity::Make(static_cast<unsigned int>(index), generations[index]) : Entity{ 0 }; };
+            uint32_t tick = GetChangeTick();
+
+            uint64_t count = reader.ReadVarint();
+            uint64_t index = 0;
+            for (uint64_t i = 0; i < count && !reader.Failed(); i++)
+            {
+                index += reader.ReadVarint();
+                Entity entity = entityAt(index);
+                if (entityMap.Contains(entity))
+                {
+                    DestroyComponent(entity);
+                    removed.push_back(entity);
+                    stats.removedComponents++;
+                }
+            }
+
+            count = reader.ReadVarint();
+            index = 0;
+            for (uint64_t i = 0; i < count && !reader.Failed(); i++)
+            {
+                index += reader.ReadVarint();
+                Entity entity = entityAt(index);
+                if (entity == Entity{ 0 })
+                {
+                    return false;
+                }
+
+                if constexpr (HasComponentSerializer<ComponentType>::value)
+                {
+                    ApplyAddedComponent(entity, ComponentSerializer<ComponentType>::Load(reader), tick, added);
+                }
+                else
+                {
+                    alignas(ComponentType) unsigned char bytes[sizeof(ComponentType)];
+                    reader.Read(bytes, sizeof(ComponentType));
+                    ApplyAddedComponent(entity, std::move(*std::launder(reinterpret_cast<ComponentType*>(bytes))), tick, added);
+                }
+                stats.addedComponents++;
+            }
+
+            if constexpr (HasComponentSerializer<ComponentType>::value)
+            {
+                count = reader.ReadVarint();
+                index = 0;
+                for (uint64_t i = 0; i < count && !reader.Failed(); i++)
+                {
+                    index += reader.ReadVarint();
+                    ComponentType component = ComponentSerializer<ComponentType>::Load(reader);
+                    ComponentInstance instance = entityMap.GetInstance(entityAt(index));
+                    if (instance == 0)
+                    {
+                        return false;
+                    }
+                    componentData[instance] = std::move(component);
+                    MarkChanged(instance, tick);
+                    stats.changedComponents++;
+                }
+                return !reader.Failed();
+            }
+            else
+            {
+                //The XOR is applied straight onto the components, which hold the same values as the baseline of the encoder.
+                uint64_t currentIndex = std::numeric_limits<uint64_t>::max();
+                ComponentInstance instance = 0;
+                return !reader.Failed() && DecodeXorRle(reader, [&](uint64_t offset, const unsigned char* xorBytes, size_t length)
+                {
+                    while (length > 0)
+                    {
+                        uint64_t valueIndex = offset / sizeof(ComponentType);
+                        size_t byte = static_cast<size_t>(offset % sizeof(ComponentType));
+                        size_t byteCount = std::min(length, sizeof(ComponentType) - byte);
+                        if (valueIndex != currentIndex)
+                        {
+                            currentIndex = valueIndex;
+                            instance = entityMap.GetInstance(entityAt(valueIndex));
+                            if (instance == 0)
+                            {
+                                return false;
+                            }
+                            MarkChanged(instance, tick);
+                            stats.changedComponents++;
+                        }
+
+                        if constexpr (StructOfArrays)
+                        {
+                            ComponentType component = componentData.Load(instance);
+                            unsigned char* value = reinterpret_cast<unsigned char*>(&component) + byte;
+                            for (size_t i = 0; i < byteCount; i++)
+                            {
+                                value[i] ^= xorBytes[i];
+                            }
+                            componentData.Store(instance, component);
+                        }
+                        else
+                        {
+                            unsigned char* value = reinterpret_cast<unsigned char*>(&componentData[instance]) + byte;
+                            for (size_t i = 0; i < byteCount; i++)
+                            {
+                                value[i] ^= xorBytes[i];
+                            }
+                        }
+                        offset += byteCount;
+                        xorBytes += byteCount;
+                        length -= byteCount;
+                    }
+                    return true;
+                });
+            }
+        }
+
+        uint32_t GetAddedVersion(ComponentInstance instance) const { return addedVersions[instance]; }
+        uint32_t GetChangedVersion(ComponentInstance instance) const { return changedVersions[instance]; }
+        uint32_t GetPageAddedVersion(unsigned int page) const { return pageVersions[page].added.load(std::memory_order_relaxed); }
+        uint32_t GetPageChangedVersion(unsigned int page) const { return pageVersions[page].changed.load(std::memory_order_relaxed); }
+
+        //Pages are exposed so that systems can iterate over components page by page. Every page except the last one is full.
+        //Note that Index 0 of the first page is the reserved invalid slot and does not hold a component.
+        unsigned int GetPageCount() const { return (componentData.size + PageSize - 1) / PageSize; }
+        ComponentType* GetPage(unsigned int page) { return componentData.pages[page]; }
+
+        //The array of one field within a page, for structure of arrays components.
+        template <size_t Field>
+        auto* GetFieldArray(unsigned int page) { return componentData.template GetFieldArray<Field>(page); }
+        unsigned char* GetFieldBytes(unsigned int page, size_t field) { return componentData.GetFieldBytes(page, field); }
+
     private:
-        ComponentData<ComponentType> componentData;
+        //Components re-added since the previous delta replace the one the replica still has.
+        void ApplyAddedComponent(Entity entity, ComponentType&& component, uint32_t tick, std::vector<Entity>& added)
+        {
+            ComponentInstance instance = entityMap.GetInstance(entity);
+            if (instance != 0)
+            {
+                if constexpr (StructOfArrays)
+                {
+                    componentData.Store(instance, component);
+                }
+                else
+                {
+                    componentData[instance] = std::move(component);
+                }
+                SetVersions(instance, tick, tick);
+            }
+            else
+            {
+                AddComponent(entity, std::move(component));
+                added.push_back(entity);
+            }
+        }
+
+        //The component itself, or for structure of arrays components, a copy gathered into "scratch".
+        const ComponentType& ReadComponent(ComponentInstance instance, unsigned char* scratch)
+        {
+            if constexpr (StructOfArrays)
+            {
+                return *new (scratch) ComponentType(componentData.Load(instance));
+            }
+            else
+            {
+                return componentData[instance];
+            }
+        }
+
+        //Page versions only ever grow, so that they stay an upper bound of every version in the page.
+        void SetVersions(ComponentInstance instance, uint32_t added, uint32_t changed)
+        {
+            if (instance >= addedVersions.size())
+            {
+                addedVersions.resize(instance + 1, 0);
+                changedVersions.resize(instance + 1, 0);
+            }
+            addedVersions[instance] = added;
+            changedVersions[instance] = changed;
+
+            unsigned int page = instance / PageSize;
+            if (page >= pageVersionCount)
+            {
+                //Atomics cannot be moved, so the versions are copied over by hand. This only happens when a new page is needed.
+                unsigned int count = std::max(page + 1, pageVersionCount * 2);
+                std::unique_ptr<PageVersions[]> grown = std::make_unique<PageVersions[]>(count);
+                for (unsigned int i = 0; i < pageVersionCount; i++)
+                {
+                    grown[i].added.store(pageVersions[i].added.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    grown[i].changed.store(pageVersions[i].changed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+                pageVersions = std::move(grown);
+                pageVersionCount = count;
+            }
+            PageVersions& versions = pageVersions[page];
+            versions.added.store(std::max(versions.added.load(std::memory_order_relaxed), added), std::memory_order_relaxed);
+            versions.changed.store(std::max(versions.changed.load(std::memory_order_relaxed), changed), std::memory_order_relaxed);
+        }
+
+        //SetVersions() over consecutive instances, touching the versions of every page once.
+        void SetVersionRange(ComponentInstance first, size_t count, uint32_t added, uint32_t changed)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+            if (first + count > addedVersions.size())
+            {
+                addedVersions.resize(first + count, 0);
+                changedVersions.resize(first + count, 0);
+            }
+            std::fill_n(addedVersions.begin() + first, count, added);
+            std::fill_n(changedVersions.begin() + first, count, changed);
+
+            ComponentInstance end = first + static_cast<ComponentInstance>(count);
+            for (ComponentInstance instance = first; instance < end; instance = (instance / PageSize + 1) * PageSize)
+            {
+                SetVersions(instance, added, changed);
+            }
+        }
+
+        ComponentStorage<ComponentType> componentData;
         EntityMap entityMap;
+        std::vector<uint32_t> addedVersions;    //Indexed by instance.
+        std::vector<uint32_t> changedVersions;  //Indexed by instance.
+        std::unique_ptr<PageVersions[]> pageVersions;  //Indexed by page.
+        unsigned int pageVersionCount = 0;
     };
 }  
\ No newline at end of file
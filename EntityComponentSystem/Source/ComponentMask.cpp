@@ -3,15 +3,67 @@
 
 namespace EntitySystem
 {
-	bool ComponentMask::IsNewMatch(EntitySystem::ComponentMask oldMask, EntitySystem::ComponentMask systemMask)
+	bool ComponentMask::IsNewMatch(const EntitySystem::ComponentMask& oldMask, const EntitySystem::ComponentMask& systemMask) const
 	{
 		return Matches(systemMask) && !oldMask.Matches(systemMask);
 	}
 
-	bool ComponentMask::IsNoLongerMatched(EntitySystem::ComponentMask oldMask, EntitySystem::ComponentMask systemMask)
+	bool ComponentMask::IsNoLongerMatched(const EntitySystem::ComponentMask& oldMask, const EntitySystem::ComponentMask& systemMask) const
 	{
 		return oldMask.Matches(systemMask) && !Matches(systemMask);
 	}
 
-	bool ComponentMask::Matches(EntitySystem::ComponentMask systemMask) { return ((mask & systemMask.mask) == systemMask.mask); }
-}
\ No newline at end of file
+#if ECS_MASK_SSE2
+	//The signature is loaded into registers once for the whole batch, so every mask only costs one load, one ANDNOT and one compare per 128 bits.
+	struct PreloadedSignature
+	{
+		__m128i lanes[ComponentMask::WordCount / 2];
+
+		explicit PreloadedSignature(const ComponentMask& signature)
+		{
+			for (int lane = 0; lane < ComponentMask::WordCount / 2; lane++)
+			{
+				lanes[lane] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(signature.words + lane * 2));
+			}
+		}
+
+		bool IsMatchedBy(const ComponentMask& mask) const
+		{
+			__m128i missing = _mm_setzero_si128();
+			for (int lane = 0; lane < ComponentMask::WordCount / 2; lane++)
+			{
+				missing = _mm_or_si128(missing, _mm_andnot_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mask.words + lane * 2)), lanes[lane]));
+			}
+			return _mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128())) == 0xFFFF;
+		}
+	};
+#else
+	struct PreloadedSignature
+	{
+		const ComponentMask& signature;
+
+		explicit PreloadedSignature(const ComponentMask& signature) : signature(signature) {}
+		bool IsMatchedBy(const ComponentMask& mask) const { return mask.Matches(signature); }
+	};
+#endif
+
+	void ComponentMask::MatchBatch(const ComponentMask* masks, size_t count, const ComponentMask& signature, unsigned char* results)
+	{
+		PreloadedSignature preloaded(signature);
+		for (size_t i = 0; i < count; i++)
+		{
+			results[i] = preloaded.IsMatchedBy(masks[i]) ? 1 : 0;
+		}
+	}
+
+	void ComponentMask::CompareBatch(const ComponentMask* oldMasks, const ComponentMask* newMasks, size_t count, const ComponentMask& signature, MaskChange* changes)
+	{
+		PreloadedSignature preloaded(signature);
+		for (size_t i = 0; i < count; i++)
+		{
+			bool matched = preloaded.IsMatchedBy(oldMasks[i]);
+			bool matches = preloaded.IsMatchedBy(newMasks[i]);
+			changes[i] = matches == matched ? MaskChange::None : (matches ? MaskChange::NewMatch : MaskChange::NoLongerMatched);
+		}
+	}
+}
@@ -1,6 +1,29 @@
 #pragma once
+#include <cassert>
+#include <cstdint>
 #include "Component.h"
 
+//The number of component families a mask can hold. Can be raised at compile time (for example -DECS_MAX_COMPONENT_FAMILIES=512), and must be a multiple of 128.
+//It includes the ECS_STATIC_COMPONENT_FAMILIES reserved for fixed families (see Component.h), so only the rest is left for dynamically numbered components.
+#ifndef ECS_MAX_COMPONENT_FAMILIES
+#define ECS_MAX_COMPONENT_FAMILIES 256
+#endif
+
+static_assert(ECS_STATIC_COMPONENT_FAMILIES >= 0 && ECS_STATIC_COMPONENT_FAMILIES < ECS_MAX_COMPONENT_FAMILIES, "ECS_STATIC_COMPONENT_FAMILIES has to leave room for dynamically numbered components below ECS_MAX_COMPONENT_FAMILIES.");
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ECS_MASK_AVX2 1
+#define ECS_MASK_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ECS_MASK_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 ///==== Component Masks ====
 
 ///The core idea is that the world is always aware of which components a given entity has at any given time.
@@ -11,30 +34,172 @@
 ///In the above example, a system like the Movement system needs to act on entities that have Transform and Motion. Therefore, the system mask would be 110000. 
 ///Similarly, the system that deals with player input might need Motion and Joystick, in which case the system mask would be 010010.
 
+///Masks are wide (ECS_MAX_COMPONENT_FAMILIES bits) flat arrays of 64-bit words, so matching a mask is a handful of AND + compare operations, done with SSE2 or AVX2 when available.
+///When many entities change at once, MatchBatch() and CompareBatch() test a single signature against a whole array of masks, keeping the signature in registers.
+
 namespace EntitySystem
 {
+    //How an entity's mask change affects its membership in a system. See ComponentMask::CompareBatch().
+    enum class MaskChange : unsigned char
+    {
+        None,
+        NewMatch,
+        NoLongerMatched
+    };
+
     struct ComponentMask
     {
-        unsigned int mask = 0;  //The mask itself.
+        static constexpr int MaxFamilies = ECS_MAX_COMPONENT_FAMILIES;
+        static constexpr int WordCount = MaxFamilies / 64;
+        static_assert(MaxFamilies > 0 && MaxFamilies % 128 == 0, "ECS_MAX_COMPONENT_FAMILIES must be a multiple of 128.");
+
+        uint64_t words[WordCount] = {};  //The mask itself.
 
         template <typename ComponentType>
         void AddComponent()
         {
-            mask |= (1 << GetComponentFamily<ComponentType>()); //Bitwise exclusive/inclusive OR assignment.
+            AddFamily(GetComponentFamily<ComponentType>());
         }
 
         template <typename ComponentType>
         void RemoveComponent()
         {
-            mask &= ~(1 << GetComponentFamily<ComponentType>());
+            RemoveFamily(GetComponentFamily<ComponentType>());
+        }
+
+        //Family based versions of the above, for code that only knows a component type at runtime.
+        void AddFamily(int family)
+        {
+            //Families are checked against MaxFamilies where they are handed out, see ComponentCounter::NextFamily().
+            assert(family < MaxFamilies && "Too many component families, raise ECS_MAX_COMPONENT_FAMILIES.");
+            words[family / 64] |= (uint64_t(1) << (family % 64)); //Bitwise exclusive/inclusive OR assignment.
+        }
+
+        void RemoveFamily(int family) { words[family / 64] &= ~(uint64_t(1) << (family % 64)); }
+        bool HasFamily(int family) const { return (words[family / 64] & (uint64_t(1) << (family % 64))) != 0; }
+
+        //Calls function(family) for every family set in the mask, in increasing order.
+        template <typename Function>
+        void ForEachFamily(Function&& function) const
+        {
+            for (int word = 0; word < WordCount; word++)
+            {
+                for (uint64_t remaining = words[word]; remaining != 0; remaining &= remaining - 1)
+                {
+                    function(word * 64 + CountTrailingZeros(remaining));
+                }
+            }
+        }
+
+        bool Intersects(const ComponentMask& other) const
+        {
+            uint64_t common = 0;
+            for (int word = 0; word < WordCount; word++)
+            {
+                common |= words[word] & other.words[word];
+            }
+            return common != 0;
+        }
+
+        bool IsEmpty() const
+        {
+            uint64_t any = 0;
+            for (int word = 0; word < WordCount; word++)
+            {
+                any |= words[word];
+            }
+            return any == 0;
+        }
+
+        ComponentMask operator|(const ComponentMask& other) const
+        {
+            ComponentMask result;
+            for (int word = 0; word < WordCount; word++)
+            {
+                result.words[word] = words[word] | other.words[word];
+            }
+            return result;
+        }
+
+        bool operator==(const ComponentMask& other) const
+        {
+            uint64_t difference = 0;
+            for (int word = 0; word < WordCount; word++)
+            {
+                difference |= words[word] ^ other.words[word];
+            }
+            return difference == 0;
         }
 
+        bool operator!=(const ComponentMask& other) const { return !(*this == other); }
+
         //Returns true if the system is now matched, but didn't used to be (based on "oldMask")
-        bool IsNewMatch(ComponentMask oldMask, ComponentMask systemMask);
+        bool IsNewMatch(const ComponentMask& oldMask, const ComponentMask& systemMask) const;
 
         //Returns true if the system is not matched, but used to be matched.
-        bool IsNoLongerMatched(ComponentMask oldMask, ComponentMask systemMask);
+        bool IsNoLongerMatched(const ComponentMask& oldMask, const ComponentMask& systemMask) const;
+
+        //Returns true if every family of the system mask is part of this mask.
+        bool Matches(const ComponentMask& systemMask) const
+        {
+#if ECS_MASK_AVX2
+            if constexpr (WordCount % 4 == 0)
+            {
+                for (int word = 0; word < WordCount; word += 4)
+                {
+                    __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + word));
+                    __m256i system = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(systemMask.words + word));
+                    __m256i missing = _mm256_andnot_si256(mask, system);
+                    if (!_mm256_testz_si256(missing, missing))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+#endif
+#if ECS_MASK_SSE2
+            for (int word = 0; word < WordCount; word += 2)
+            {
+                __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + word));
+                __m128i system = _mm_loadu_si128(reinterpret_cast<const __m128i*>(systemMask.words + word));
+                __m128i missing = _mm_andnot_si128(mask, system);
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128())) != 0xFFFF)
+                {
+                    return false;
+                }
+            }
+            return true;
+#else
+            uint64_t missing = 0;
+            for (int word = 0; word < WordCount; word++)
+            {
+                missing |= systemMask.words[word] & ~words[word];
+            }
+            return missing == 0;
+#endif
+        }
 
-        bool Matches(ComponentMask systemMask);
+        //Sets results[i] to 1 if masks[i] matches the signature, and to 0 otherwise.
+        static void MatchBatch(const ComponentMask* masks, size_t count, const ComponentMask& signature, unsigned char* results);
+
+        //Sets changes[i] to how going from oldMasks[i] to newMasks[i] changes the match against the signature.
+        static void CompareBatch(const ComponentMask* oldMasks, const ComponentMask* newMasks, size_t count, const ComponentMask& signature, MaskChange* changes);
+
+    private:
+        static int CountTrailingZeros(uint64_t value)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            if (_BitScanForward(&index, static_cast<unsigned long>(value)))
+            {
+                return static_cast<int>(index);
+            }
+            _BitScanForward(&index, static_cast<unsigned long>(value >> 32));
+            return static_cast<int>(index) + 32;
+#else
+            return __builtin_ctzll(value);
+#endif
+        }
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,98 @@
+#include "ECSPrecompiledHeader.h"
+#include "DeltaSnapshot.h"
+
+namespace EntitySystem
+{
+	void XorRleEncoder::Skip(uint64_t count)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		position += count;
+		if (run.empty())
+		{
+			pendingSkip += count;
+		}
+		else if (trailingZeros + count < MinimumSkip)
+		{
+			for (uint64_t i = 0; i < count; i++)
+			{
+				run.push_back(0);
+			}
+			trailingZeros += static_cast<unsigned int>(count);
+		}
+		else
+		{
+			uint64_t skipped = trailingZeros + count;
+			FlushRun();
+			pendingSkip = skipped;
+		}
+	}
+
+	void XorRleEncoder::Push(const unsigned char* xorBytes, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (xorBytes[i] != 0)
+			{
+				run.push_back(xorBytes[i]);
+				trailingZeros = 0;
+				position++;
+			}
+			else
+			{
+				Skip(1);
+			}
+		}
+	}
+
+	void XorRleEncoder::Finish()
+	{
+		if (!run.empty())
+		{
+			FlushRun();
+		}
+		writer.WriteVarint(0);
+		writer.WriteVarint(0);
+	}
+
+	void XorRleEncoder::FlushRun()
+	{
+		//Zeros at the end of the run are never worth sending, they are folded into the next skip by the caller.
+		run.resize(run.size() - trailingZeros);
+		writer.WriteVarint(pendingSkip);
+		writer.WriteVarint(run.size());
+		writer.Write(run.data(), run.size());
+		run.clear();
+		pendingSkip = 0;
+		trailingZeros = 0;
+	}
+
+	void EncodeBytesDelta(SnapshotWriter& writer, unsigned char* baseline, const unsigned char* current, size_t size)
+	{
+		//Most of an array is usually unchanged, so it is compared a block at a time, and only the blocks that differ are XORed byte by byte.
+		constexpr size_t BlockSize = 64;
+		XorRleEncoder encoder(writer);
+		unsigned char xorBytes[BlockSize];
+
+		for (size_t offset = 0; offset < size; offset += BlockSize)
+		{
+			size_t count = std::min(BlockSize, size - offset);
+			if (std::memcmp(baseline + offset, current + offset, count) == 0)
+			{
+				continue;
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				xorBytes[i] = baseline[offset + i] ^ current[offset + i];
+			}
+			encoder.Skip(offset - encoder.GetPosition());
+			encoder.Push(xorBytes, count);
+			std::memcpy(baseline + offset, current + offset, count);
+		}
+		encoder.Finish();
+	}
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <limits>
+#include "Snapshot.h"
+
+///==== Delta Snapshots ====
+
+///A full snapshot (see Snapshot.h) is far too large to send every tick. A delta only holds what changed since the previous delta of the same encoder:
+///the entity manager state (which is how created and destroyed entities travel), and for every registered component type, the components that were added, removed or changed.
+///A replica that applies every delta of a stream, in order, ends up with the same entities and components as the world that encoded it.
+
+///Finding what changed is cheap thanks to change tracking: pages (and then components) whose changed version is older than the previous delta are skipped without being read.
+///Encoding what changed is done by XOR against the value the replica already has. The encoder keeps a copy of the last value it sent for every entity index,
+///and changed bytes are XORed against it, so fields that did not change come out as zeros. Runs of zeros are then squeezed out (see XorRleEncoder).
+///Added components are sent whole, as the replica has nothing to XOR them against. Components that are not trivially copyable go through their ComponentSerializer, and are always sent whole.
+
+///Stream layout:
+///DeltaHeader | generations | free indices | per component type: name, block size, removed indices, added components, changed components
+
+namespace EntitySystem
+{
+    constexpr uint32_t DeltaMagic = 0x544C4544;  //"DELT"
+
+    //Bumped whenever the layout of a delta changes. Deltas of any other version are rejected.
+    constexpr uint32_t DeltaVersion = 1;
+
+    struct DeltaHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t baseSequence;  //The sequence of the delta this one applies on top of, 0 for the first delta of a stream.
+        uint64_t sequence;
+        uint64_t blockCount;
+    };
+
+    //What the last delta encoded or applied held.
+    struct DeltaStats
+    {
+        uint64_t bytes = 0;
+        uint64_t entityBytes = 0;  //Generations and free indices.
+        unsigned int addedComponents = 0;
+        unsigned int removedComponents = 0;
+        unsigned int changedComponents = 0;
+    };
+
+    //Writes the XOR of a byte sequence against its previous value as runs: a varint number of unchanged bytes to skip, then a varint number of bytes that changed, followed by their XOR.
+    //Short runs of zeros are kept inside the changed bytes, as a new run would cost more than the zeros it saves. A run of 0 changed bytes ends the stream.
+    //Bytes are pushed in increasing order of offset, the gaps in between being unchanged.
+    class XorRleEncoder
+    {
+    public:
+        explicit XorRleEncoder(SnapshotWriter& writer) : writer(writer) {}
+
+        //Offset of the next byte to push, relative to the start of the sequence.
+        uint64_t GetPosition() const { return position; }
+
+        void Skip(uint64_t count);
+        void Push(const unsigned char* xorBytes, size_t count);
+
+        //Writes the pending run and the end of stream marker.
+        void Finish();
+
+    private:
+        //Splitting a run of changed bytes on fewer zeros than this would make the stream larger.
+        static constexpr unsigned int MinimumSkip = 3;
+
+        void FlushRun();
+
+        SnapshotWriter& writer;
+        std::vector<unsigned char> run;
+        uint64_t pendingSkip = 0;
+        unsigned int trailingZeros = 0;  //Zeros at the end of the run, that will be skipped instead if no non-zero byte follows them closely enough.
+        uint64_t position = 0;
+    };
+
+    //Reads a stream written by XorRleEncoder, calling apply(offset, xorBytes, count) for every run of changed bytes. Returns false on a malformed stream or when apply() does.
+    template <typename Function>
+    bool DecodeXorRle(SnapshotReader& reader, Function&& apply)
+    {
+        uint64_t offset = 0;
+        while (!reader.Failed())
+        {
+            offset += reader.ReadVarint();
+            uint64_t count = reader.ReadVarint();
+            if (count == 0)
+            {
+                return !reader.Failed();
+            }
+
+            const unsigned char* bytes = reader.ReadBytes(static_cast<size_t>(count));
+            if (!bytes || !apply(offset, bytes, static_cast<size_t>(count)))
+            {
+                return false;
+            }
+            offset += count;
+        }
+        return false;
+    }
+
+    //Encodes the XOR of "current" against "baseline" (both "size" bytes long), then updates the baseline.
+    void EncodeBytesDelta(SnapshotWriter& writer, unsigned char* baseline, const unsigned char* current, size_t size);
+
+    //Encodes an array as its new length and the XOR of its bytes against "baseline" (zero-extended, or truncated, to the new length), then updates the baseline.
+    template <typename ValueType>
+    void EncodeArrayDelta(SnapshotWriter& writer, std::vector<ValueType>& baseline, const std::vector<ValueType>& current)
+    {
+        static_assert(std::is_trivially_copyable_v<ValueType>, "Only arrays of trivially copyable values can be delta encoded.");
+        writer.WriteVarint(current.size());
+        baseline.resize(current.size(), ValueType{});
+        EncodeBytesDelta(writer, reinterpret_cast<unsigned char*>(baseline.data()), reinterpret_cast<const unsigned char*>(current.data()), current.size() * sizeof(ValueType));
+    }
+
+    //Applies an array written by EncodeArrayDelta() to "target", resizing it to the new length first.
+    template <typename ValueType>
+    bool DecodeArrayDelta(SnapshotReader& reader, std::vector<ValueType>& target)
+    {
+        uint64_t count = reader.ReadVarint();
+        if (reader.Failed() || count > std::numeric_limits<uint32_t>::max())
+        {
+            return false;
+        }
+
+        target.resize(static_cast<size_t>(count), ValueType{});
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(target.data());
+        size_t size = target.size() * sizeof(ValueType);
+        return DecodeXorRle(reader, [bytes, size](uint64_t offset, const unsigned char* xorBytes, size_t length)
+        {
+            if (offset + length > size)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < length; i++)
+            {
+                bytes[offset + i] ^= xorBytes[i];
+            }
+            return true;
+        });
+    }
+
+    //The last value the encoder sent for every entity index of one component type, which is what the replica currently holds.
+    struct ComponentDeltaBaseline
+    {
+        std::vector<unsigned char> present;  //Indexed by entity index.
+        std::vector<unsigned char> values;   //sizeof(ComponentType) bytes per entity index. Unused for serialized components.
+        unsigned int presentCount = 0;
+    };
+
+    //The state a world needs to encode a stream of deltas, see World::EncodeDelta(). One encoder per stream: every replica of the stream sees the same deltas.
+    class DeltaEncoder
+    {
+    public:
+        uint64_t GetSequence() const { return sequence; }
+        const DeltaStats& GetLastStats() const { return lastStats; }
+
+    private:
+        friend class World;
+
+        uint64_t sequence = 0;
+        uint32_t lastTick = 0;  //Components stamped after this tick have changed since the previous delta.
+        std::vector<unsigned int> generations;
+        std::vector<unsigned int> freeIndices;
+        std::vector<ComponentDeltaBaseline> components;  //In the order the component types were registered with World::RegisterSnapshotComponent().
+        DeltaStats lastStats;
+    };
+
+    //The state a replica needs to apply a stream of deltas, see World::ApplyDelta().
+    class DeltaDecoder
+    {
+    public:
+        uint64_t GetSequence() const { return sequence; }
+        const DeltaStats& GetLastStats() const { return lastStats; }
+
+    private:
+        friend class World;
+
+        uint64_t sequence = 0;
+        DeltaStats lastStats;
+    };
+}
@@ -1,10 +1,21 @@
 #pragma once
+#include <cstdint>
 
 namespace EntitySystem
 {
+	//An entity is nothing more than an ID. The lower 32 bits are the index of the entity, which is recycled once the entity is destroyed, so that tables indexed by entity stay dense.
+	//The upper 32 bits are the generation of the index, which is bumped every time the index is recycled. A stale Entity held onto by gameplay code thus never aliases the new entity using its index.
 	struct Entity
 	{
-		unsigned int entityID;
+		uint64_t entityID;
+
+		unsigned int Index() const { return static_cast<unsigned int>(entityID); }
+		unsigned int Generation() const { return static_cast<unsigned int>(entityID >> 32); }
+
+		static Entity Make(unsigned int index, unsigned int generation) { return { (static_cast<uint64_t>(generation) << 32) | index }; }
+
 		friend bool operator<(const Entity& l, const Entity& r) { return l.entityID < r.entityID; }
+		friend bool operator==(const Entity& l, const Entity& r) { return l.entityID == r.entityID; }
+		friend bool operator!=(const Entity& l, const Entity& r) { return l.entityID != r.entityID; }
 	};
-}
\ No newline at end of file
+}
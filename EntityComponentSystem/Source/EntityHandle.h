@@ -30,6 +30,11 @@ namespace EntitySystem
             world->DestroyEntity(entity);
         }
 
+        bool IsAlive() const
+        {
+            return world->IsAlive(entity);
+        }
+
         template<typename ComponentType>
         void AddComponent(ComponentType&& component)
         {
@@ -5,12 +5,86 @@ namespace EntitySystem
 {
 	Entity EntityManager::RegisterNewEntity()
 	{
-		lastEntity++;
-		return { lastEntity }; //Initializer.
+		//Recycle the most recently freed index first, as its slots in the entity tables are the most likely to still be in cache.
+		if (!freeIndices.empty())
+		{
+			unsigned int index = freeIndices.back();
+			freeIndices.pop_back();
+			return Entity::Make(index, generations[index]);
+		}
+
+		unsigned int index = static_cast<unsigned int>(generations.size());
+		generations.push_back(0);
+		return Entity::Make(index, 0);
 	}
 
 	void EntityManager::RemoveEntity(Entity entity)
 	{
+		if (!IsAlive(entity))
+		{
+			return;
+		}
+
+		//Bumping the generation right away is what makes every copy of the removed entity stale.
+		generations[entity.Index()]++;
+		freeIndices.push_back(entity.Index());
+	}
+
+	bool EntityManager::IsAlive(Entity entity) const
+	{
+		unsigned int index = entity.Index();
+		return index != 0 && index < generations.size() && generations[index] == entity.Generation();
+	}
+
+	std::vector<Entity> EntityManager::CreateEntities(unsigned int count)
+	{
+		std::vector<Entity> entities;
+		entities.reserve(count);
+
+		while (entities.size() < count && !freeIndices.empty())
+		{
+			unsigned int index = freeIndices.back();
+			freeIndices.pop_back();
+			entities.push_back(Entity::Make(index, generations[index]));
+		}
+
+		unsigned int firstIndex = static_cast<unsigned int>(generations.size());
+		unsigned int remaining = count - static_cast<unsigned int>(entities.size());
+		generations.resize(generations.size() + remaining, 0);
+		for (unsigned int i = 0; i < remaining; i++)
+		{
+			entities.push_back(Entity::Make(firstIndex + i, 0));
+		}
+		return entities;
+	}
+
+	void EntityManager::Restore(std::vector<unsigned int> savedGenerations, std::vector<unsigned int> savedFreeIndices)
+	{
+		generations = std::move(savedGenerations);
+		freeIndices = std::move(savedFreeIndices);
+		if (generations.empty())
+		{
+			generations.push_back(0);
+		}
+	}
 
+	void EntityManager::RemoveAllEntities()
+	{
+		//Free indices have already been bumped when they were removed. Bumping them again is harmless, and cheaper than finding out which indices are alive.
+		freeIndices.resize(generations.size() - 1);
+		for (unsigned int index = 1; index < generations.size(); index++)
+		{
+			generations[index]++;
+			freeIndices[generations.size() - 1 - index] = index;
+		}
+	}
+
+	void EntityManager::DestroyEntities(const Entity* entities, size_t count)
+	{
+		freeIndices.reserve(freeIndices.size() + count);
+		for (size_t i = 0; i < count; i++)
+		{
+			RemoveEntity(entities[i]);
+		}
 	}
-}
\ No newline at end of file
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "ECSPrecompiledHeader.h"
 #include "Entity.h"
 
 ///==== Entity Managers ====
@@ -7,6 +8,9 @@
 ///When you create a new entity, the entity manager will take care of making sure that no other living entities share the same ID.
 ///For this reason, the entity manager itself will be a singleton. 
 
+///Indices of destroyed entities are kept in a free list and handed out again, with their generation bumped (see Entity.h).
+///Index 0 is never handed out, so that an Entity of ID 0 can be used as "no entity".
+
 namespace EntitySystem
 {
 	class EntityManager
@@ -15,7 +19,36 @@ namespace EntitySystem
 		Entity RegisterNewEntity();
 		void RemoveEntity(Entity entity);
 
+		//Returns false once the entity has been removed, even if its index has been recycled since.
+		bool IsAlive(Entity entity) const;
+
+		//Bulk versions of the above, for workloads that spawn and destroy thousands of entities at once.
+		std::vector<Entity> CreateEntities(unsigned int count);
+		void DestroyEntities(const Entity* entities, size_t count);
+
+		//Removes every entity at once, without looking at them one by one (see World::Reset()). Every existing entity becomes stale, and indices are handed out again from 1.
+		void RemoveAllEntities();
+
+		//Number of indices handed out so far (alive or free), which bounds the size of every table indexed by entity index.
+		unsigned int GetIndexCount() const { return static_cast<unsigned int>(generations.size()); }
+
+		//Number of entities currently alive.
+		unsigned int GetAliveCount() const { return static_cast<unsigned int>(generations.size() - 1 - freeIndices.size()); }
+
+		//The complete state of the manager, for snapshots (see Snapshot.h).
+		const std::vector<unsigned int>& GetGenerations() const { return generations; }
+		const std::vector<unsigned int>& GetFreeIndices() const { return freeIndices; }
+		void Restore(std::vector<unsigned int> savedGenerations, std::vector<unsigned int> savedFreeIndices);
+
+		//Exchanges the state of the manager with the given vectors, so that delta snapshots can patch it in place (see DeltaSnapshot.h).
+		void SwapState(std::vector<unsigned int>& otherGenerations, std::vector<unsigned int>& otherFreeIndices)
+		{
+			generations.swap(otherGenerations);
+			freeIndices.swap(otherFreeIndices);
+		}
+
 	private:
-		unsigned int lastEntity = 0;
+		std::vector<unsigned int> generations = { 0 };  //Current generation of every index. Index 0 is reserved.
+		std::vector<unsigned int> freeIndices;
 	};
 }
@@ -1,38 +1,119 @@
 #pragma once
 #include <ECSPrecompiledHeader.h>
-#include <map>
+#include <algorithm>
 #include "Entity.h"
 
 /*
  * Effectively a bidirectional map
  * Entity <-> ComponentInstance
+ *
+ * Implemented as a paged sparse set. The sparse side is indexed directly by entity index and points into the dense side,
+ * while the dense side (instanceToEntity) holds the owning entity of every component instance.
+ * Lookups, additions and removals are all O(1) and touch at most one sparse page and one dense slot.
  */
 
 namespace EntitySystem
 {
-    const int MAX_NUMBER_OF_COMPONENTS = 1024;
-    using ComponentInstance = unsigned int; 
+    using ComponentInstance = unsigned int;
 
     struct EntityMap
     {
-        Entity GetEntity(ComponentInstance instance) { return instanceToEntity.at(instance); }
-        ComponentInstance GetInstance(Entity entity) { return entityToInstance.at(entity); }
-   
+        //Number of entity indices covered by a single sparse page. Pages are only allocated once an entity inside their range gets a component.
+        static constexpr unsigned int SparsePageSize = 4096;
+
+        Entity GetEntity(ComponentInstance instance) { return instanceToEntity[instance]; }
+
+        //Returns 0 (the reserved invalid instance) if the entity has no component in this map.
+        //The sparse side is indexed by entity index only, so the dense side is checked as well to reject stale entities whose index has been recycled.
+        ComponentInstance GetInstance(Entity entity) const
+        {
+            unsigned int page = entity.Index() / SparsePageSize;
+            if (page >= entityToInstance.size() || !entityToInstance[page])
+            {
+                return 0;
+            }
+
+            ComponentInstance instance = entityToInstance[page][entity.Index() % SparsePageSize];
+            return instance != 0 && instanceToEntity[instance] == entity ? instance : 0;
+        }
+
+        bool Contains(Entity entity) const { return GetInstance(entity) != 0; }
+
         void Add(Entity entity, ComponentInstance instance)
         {
-            entityToInstance.insert({ entity, instance });
-            instanceToEntity.at(instance) = entity;
+            SparseSlot(entity) = instance;
+            if (instance >= instanceToEntity.size())
+            {
+                instanceToEntity.resize(instance + 1);
+            }
+            instanceToEntity[instance] = entity;
+        }
+
+        //Bulk Add() of consecutive instances, starting at "first".
+        void AddRange(const Entity* entities, ComponentInstance first, size_t count)
+        {
+            if (first + count > instanceToEntity.size())
+            {
+                instanceToEntity.resize(first + count);
+            }
+            std::copy(entities, entities + count, instanceToEntity.begin() + first);
+            for (size_t offset = 0; offset < count; offset++)
+            {
+                SparseSlot(entities[offset]) = first + static_cast<ComponentInstance>(offset);
+            }
         }
 
         void Update(Entity entity, ComponentInstance instance)
         {
-            entityToInstance.at(entity) = instance;
-            instanceToEntity.at(instance) = entity; 
+            SparseSlot(entity) = instance;
+            instanceToEntity[instance] = entity;
+        }
+
+        void Remove(Entity entity) { SparseSlot(entity) = 0; }
+
+        //Makes room for "count" instances on the dense side, at least doubling it like push_back() would, so that reserving a little more every time stays amortized.
+        //The sparse side grows a page at a time anyway.
+        void Reserve(ComponentInstance count)
+        {
+            if (count > instanceToEntity.capacity())
+            {
+                instanceToEntity.reserve(std::max<size_t>(count, 2 * instanceToEntity.capacity()));
+            }
         }
 
-        void Remove(Entity entity) { entityToInstance.erase(entity); }
+        //Forgets every entity, releasing the sparse pages.
+        void Clear()
+        {
+            entityToInstance.clear();
+            instanceToEntity.clear();
+        }
 
-        std::map<Entity, ComponentInstance> entityToInstance;
-        std::array<Entity, MAX_NUMBER_OF_COMPONENTS> instanceToEntity;
+        //Rebuilds the map from the dense side alone, instance i being owned by entities[i]. Instance 0 is the reserved invalid instance.
+        void Assign(const Entity* entities, ComponentInstance count)
+        {
+            instanceToEntity.assign(entities, entities + count);
+            for (ComponentInstance instance = 1; instance < count; instance++)
+            {
+                SparseSlot(entities[instance]) = instance;
+            }
+        }
+
+        std::vector<std::unique_ptr<ComponentInstance[]>> entityToInstance;
+        std::vector<Entity> instanceToEntity;
+
+    private:
+        ComponentInstance& SparseSlot(Entity entity)
+        {
+            unsigned int page = entity.Index() / SparsePageSize;
+            if (page >= entityToInstance.size())
+            {
+                entityToInstance.resize(page + 1);
+            }
+            if (!entityToInstance[page])
+            {
+                entityToInstance[page] = std::make_unique<ComponentInstance[]>(SparsePageSize); //Value-initialized, so every slot starts out as the invalid instance.
+            }
+            return entityToInstance[page][entity.Index() % SparsePageSize];
+        }
     };
 }
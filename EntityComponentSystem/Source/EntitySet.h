@@ -0,0 +1,113 @@
+#pragma once
+#include <ECSPrecompiledHeader.h>
+#include <algorithm>
+#include <cassert>
+#include "Entity.h"
+
+/*
+ * An unordered set of entities with O(1) insertion, removal and membership tests.
+ *
+ * Implemented as a paged sparse set, like EntityMap. The sparse side is indexed by entity index and holds the position of the entity in the dense side,
+ * while the dense side is a packed array of entities that can be iterated like a vector.
+ * Removal swaps the last entity into the hole, so the order of iteration is not stable across removals.
+ */
+
+namespace EntitySystem
+{
+    class EntitySet
+    {
+    public:
+        //Number of entity indices covered by a single sparse page. Pages are only allocated once an entity inside their range gets inserted.
+        static constexpr unsigned int SparsePageSize = 4096;
+
+        bool Contains(Entity entity) const
+        {
+            unsigned int page = entity.Index() / SparsePageSize;
+            if (page >= sparse.size() || !sparse[page])
+            {
+                return false;
+            }
+
+            unsigned int position = sparse[page][entity.Index() % SparsePageSize];
+            return position < dense.size() && dense[position] == entity;
+        }
+
+        //Returns false if the entity was already in the set.
+        bool Insert(Entity entity)
+        {
+            if (Contains(entity))
+            {
+                return false;
+            }
+
+            SparseSlot(entity) = static_cast<unsigned int>(dense.size());
+            dense.push_back(entity);
+            return true;
+        }
+
+        //Bulk Insert() of entities that cannot be in the set yet, such as ones that were just created.
+        void InsertNew(const Entity* entities, size_t count)
+        {
+            size_t first = dense.size();
+            Reserve(first + count);
+            for (size_t offset = 0; offset < count; offset++)
+            {
+                assert(!Contains(entities[offset]));
+                SparseSlot(entities[offset]) = static_cast<unsigned int>(first + offset);
+            }
+            dense.insert(dense.end(), entities, entities + count);
+        }
+
+        //Returns false if the entity was not in the set.
+        bool Remove(Entity entity)
+        {
+            if (!Contains(entity))
+            {
+                return false;
+            }
+
+            unsigned int position = SparseSlot(entity);
+            Entity last = dense.back();
+            dense[position] = last;
+            SparseSlot(last) = position;
+            dense.pop_back();
+            return true;
+        }
+
+        void Clear() { dense.clear(); }
+        //At least doubles the capacity when it has to grow, so that reserving a little more every time stays amortized.
+        void Reserve(size_t count)
+        {
+            if (count > dense.capacity())
+            {
+                dense.reserve(std::max(count, 2 * dense.capacity()));
+            }
+        }
+
+        size_t size() const { return dense.size(); }
+        bool empty() const { return dense.empty(); }
+        Entity operator[](size_t position) const { return dense[position]; }
+        const Entity* data() const { return dense.data(); }
+
+        std::vector<Entity>::const_iterator begin() const { return dense.begin(); }
+        std::vector<Entity>::const_iterator end() const { return dense.end(); }
+
+    private:
+        unsigned int& SparseSlot(Entity entity)
+        {
+            unsigned int page = entity.Index() / SparsePageSize;
+            if (page >= sparse.size())
+            {
+                sparse.resize(page + 1);
+            }
+            if (!sparse[page])
+            {
+                sparse[page] = std::make_unique<unsigned int[]>(SparsePageSize);
+            }
+            return sparse[page][entity.Index() % SparsePageSize];
+        }
+
+        std::vector<std::unique_ptr<unsigned int[]>> sparse;
+        std::vector<Entity> dense;
+    };
+}
@@ -57,17 +57,14 @@ public:
 
 	void Update(int deltaTime)
 	{
-		for (auto& entity : registeredEntities)
+		Each<Position>([deltaTime](Entity entity, Position& position)
 		{
-			ComponentHandle<Position> position;
-			parentWorld->Unpack(entity, position);
-
 			//Move every 1 second.
-			position->x += 1.0f * (deltaTime / 1000.0f);
+			position.x += 1.0f * (deltaTime / 1000.0f);
 
 			//Print entity position.
-			std::cout << "Entity " << entity.entityID << position->x << std::endl;
-		}
+			std::cout << "Entity " << entity.entityID << position.x << std::endl;
+		});
 	}
 };
 
@@ -0,0 +1,105 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <algorithm>
+#include <tuple>
+#include "ComponentManager.h"
+#include "ComponentGroup.h"
+
+///==== Group Views ====
+
+///Iterates the members of an owning group (see ComponentGroup.h), as returned by World::Group<Transform, const Velocity>().
+///The members are instances 1 to GetSize() of every pool, in the same order, so a page worth of members is handed out through one pointer per pool, without any lookup.
+///Like views, non-const components count as written and are stamped with the current tick, and the group must not change structurally while it is iterated:
+///adding or removing components during Each() should go through a command buffer.
+
+namespace EntitySystem
+{
+    template <typename... ComponentTypes>
+    class GroupView
+    {
+    public:
+        static_assert(sizeof...(ComponentTypes) > 0, "A group needs at least one component type.");
+        static_assert((!IsStructOfArrays<ComponentTypes> && ...), "Groups hand out whole components, which structure of arrays components are not stored as. Use a view (see StructOfArrays.h).");
+
+        GroupView(uint32_t changeTick, ComponentGroup* group, ComponentManager<std::remove_const_t<ComponentTypes>>*... managers)
+            : managers(managers...), group(group), changeTick(changeTick) {}
+
+        unsigned int GetSize() const { return group->GetSize(); }
+
+        //For iterations Each() does not cover, such as reaching the components of another member by instance. Members are instances 1 to GetSize() of every manager.
+        ComponentGroup& GetGroup() const { return *group; }
+
+        template <typename ComponentType>
+        ComponentManager<std::remove_const_t<ComponentType>>* GetManager() const { return std::get<ComponentManager<std::remove_const_t<ComponentType>>*>(managers); }
+
+        //Calls function(components&...) or function(entity, components&...) for every member of the group.
+        template <typename Function>
+        void Each(Function&& function)
+        {
+            Each(function, std::index_sequence_for<ComponentTypes...>{});
+        }
+
+    private:
+        template <size_t Index>
+        using Type = std::tuple_element_t<Index, std::tuple<ComponentTypes...>>;
+
+        template <typename Function, size_t... Indices>
+        void Each(Function& function, std::index_sequence<Indices...>)
+        {
+            const Entity* entities = std::get<0>(managers)->GetEntities();
+            ComponentInstance first = 1;
+            ComponentInstance last = group->GetSize() + 1;
+
+            while (first < last)
+            {
+                //Pools may use different page sizes, so a run stops at the first page boundary of any of them.
+                ComponentInstance end = std::min({ last, NextPageStart<Indices>(first)... });
+                std::tuple<Type<Indices>*...> components(&std::get<Indices>(managers)->GetComponent(first)...);
+
+                for (ComponentInstance offset = 0; offset < end - first; offset++)
+                {
+                    Invoke(function, entities[first + offset], std::get<Indices>(components)[offset]...);
+                }
+
+                (MarkWritten<Indices>(first, end), ...);
+                first = end;
+            }
+        }
+
+        template <size_t Index>
+        ComponentInstance NextPageStart(ComponentInstance instance) const
+        {
+            constexpr unsigned int PageSize = ComponentManager<std::remove_const_t<Type<Index>>>::PageSize;
+            return (instance / PageSize + 1) * PageSize;
+        }
+
+        //Stamps a run of instances, which never crosses a page, as changed.
+        template <size_t Index>
+        void MarkWritten(ComponentInstance first, ComponentInstance end)
+        {
+            if constexpr (!std::is_const_v<Type<Index>>)
+            {
+                auto* manager = std::get<Index>(managers);
+                std::fill_n(manager->GetChangedVersions() + first, end - first, changeTick);
+                manager->MarkPageChanged(first / std::remove_pointer_t<decltype(manager)>::PageSize, changeTick);
+            }
+        }
+
+        template <typename Function, typename... Arguments>
+        static void Invoke(Function& function, Entity entity, Arguments&... components)
+        {
+            if constexpr (std::is_invocable_v<Function&, Entity, Arguments&...>)
+            {
+                function(entity, components...);
+            }
+            else
+            {
+                function(components...);
+            }
+        }
+
+        std::tuple<ComponentManager<std::remove_const_t<ComponentTypes>>*...> managers;
+        ComponentGroup* group;
+        uint32_t changeTick;
+    };
+}
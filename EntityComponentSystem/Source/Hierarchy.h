@@ -0,0 +1,40 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include "Component.h"
+#include "ComponentManager.h"
+#include "Entity.h"
+
+///==== Hierarchies ====
+
+///Entities can be parented to each other with World::SetParent(), which gives both of them a Hierarchy component.
+///Every node links to its parent, its first child and its siblings, so walking the children of an entity or its subtree needs no allocation,
+///and keeps its depth (0 for roots), which lets systems sort nodes so that parents come before their children (see TransformSystem.h).
+
+///The links are owned by the world: they are only changed through SetParent(), and destroying an entity destroys its whole subtree with it, in one batch.
+///Removing the Hierarchy component directly would leave dangling links, so an entity is detached with SetParent(entity, Entity()) instead.
+///When entities move to another world (see WorldStreaming.h), links to entities that stay behind are dropped.
+
+namespace EntitySystem
+{
+    struct Hierarchy : Component<Hierarchy>
+    {
+        Entity parent = {};
+        Entity firstChild = {};
+        Entity nextSibling = {};
+        Entity previousSibling = {};
+        unsigned int depth = 0;
+        unsigned int childCount = 0;
+    };
+
+    template <>
+    struct ComponentEntityRemapper<Hierarchy>
+    {
+        static void Remap(Hierarchy& node, const EntityRemap& remap)
+        {
+            node.parent = remap(node.parent);
+            node.firstChild = remap(node.firstChild);
+            node.nextSibling = remap(node.nextSibling);
+            node.previousSibling = remap(node.previousSibling);
+        }
+    };
+}
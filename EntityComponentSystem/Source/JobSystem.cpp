@@ -0,0 +1,142 @@
+#include "ECSPrecompiledHeader.h"
+#include "JobSystem.h"
+
+namespace EntitySystem
+{
+	//Lets a thread know which queue it owns, so that jobs spawned from inside a job stay on the same worker.
+	static thread_local const JobSystem* currentJobSystem = nullptr;
+	static thread_local unsigned int currentQueue = 0;
+
+	JobSystem::JobSystem(unsigned int workerCount)
+	{
+		for (unsigned int i = 0; i < workerCount + 1; i++)
+		{
+			queues.push_back(std::make_unique<WorkerQueue>());
+		}
+
+		for (unsigned int i = 0; i < workerCount; i++)
+		{
+			workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			running = false;
+		}
+		wakeUp.notify_all();
+
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	unsigned int JobSystem::DefaultWorkerCount()
+	{
+		//The thread that waits for the jobs works as well, so it does not need a worker of its own.
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	void JobSystem::Submit(std::function<void()> job, JobCounter& counter)
+	{
+		counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+		unsigned int queueIndex = currentJobSystem == this ? currentQueue : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+		{
+			std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+			queues[queueIndex]->jobs.push_back({ std::move(job), &counter });
+		}
+
+		queuedJobs.fetch_add(1, std::memory_order_release);
+		{
+			//Taking the lock makes sure a worker that just found no work is already waiting, and thus receives the notification.
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wakeUp.notify_one();
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		unsigned int queueIndex = currentJobSystem == this ? currentQueue : static_cast<unsigned int>(queues.size() - 1);
+
+		while (counter.pending.load(std::memory_order_acquire) != 0)
+		{
+			Job job;
+			if (TryGetJob(queueIndex, job))
+			{
+				Execute(job);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::WorkerLoop(unsigned int workerIndex)
+	{
+		currentJobSystem = this;
+		currentQueue = workerIndex;
+
+		while (true)
+		{
+			Job job;
+			if (TryGetJob(workerIndex, job))
+			{
+				Execute(job);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wakeUp.wait(lock, [this]() { return queuedJobs.load(std::memory_order_acquire) > 0 || !running; });
+			if (!running)
+			{
+				return;
+			}
+		}
+	}
+
+	bool JobSystem::TryGetJob(unsigned int queueIndex, Job& job)
+	{
+		if (queuedJobs.load(std::memory_order_acquire) == 0)
+		{
+			return false;
+		}
+
+		{
+			WorkerQueue& own = *queues[queueIndex];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.jobs.empty())
+			{
+				job = std::move(own.jobs.back());
+				own.jobs.pop_back();
+				queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		for (size_t offset = 1; offset < queues.size(); offset++)
+		{
+			WorkerQueue& victim = *queues[(queueIndex + offset) % queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.jobs.empty())
+			{
+				job = std::move(victim.jobs.front());
+				victim.jobs.pop_front();
+				queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void JobSystem::Execute(Job& job)
+	{
+		job.function();
+		job.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
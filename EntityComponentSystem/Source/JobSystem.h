@@ -0,0 +1,71 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+///==== Job System ====
+
+///A small work-stealing thread pool shared by the world's scheduler and by data-parallel iteration.
+///Every worker owns a queue. Workers push and pop jobs at the back of their own queue (which keeps recently spawned, cache-warm work local)
+///and, when they run dry, steal from the front of the other workers' queues.
+///Threads that wait for a group of jobs to finish do not sleep: they keep executing pending jobs, so waiting from inside a job can never deadlock the pool.
+
+namespace EntitySystem
+{
+    //Counts the jobs of a group that have not finished yet.
+    struct JobCounter
+    {
+        std::atomic<unsigned int> pending{ 0 };
+    };
+
+    class JobSystem
+    {
+    public:
+        //A worker count of 0 runs every job on the thread that waits for it.
+        explicit JobSystem(unsigned int workerCount = DefaultWorkerCount());
+        ~JobSystem();
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        void Submit(std::function<void()> job, JobCounter& counter);
+
+        //Blocks until every job of the counter has finished, executing pending jobs in the meantime.
+        void Wait(JobCounter& counter);
+
+        unsigned int GetWorkerCount() const { return static_cast<unsigned int>(workers.size()); }
+
+        static unsigned int DefaultWorkerCount();
+
+    private:
+        struct Job
+        {
+            std::function<void()> function;
+            JobCounter* counter;
+        };
+
+        struct WorkerQueue
+        {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        void WorkerLoop(unsigned int workerIndex);
+
+        //Pops from the back of the given queue, then steals from the front of every other queue.
+        bool TryGetJob(unsigned int queueIndex, Job& job);
+        void Execute(Job& job);
+
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<WorkerQueue>> queues;  //One per worker, plus one for threads outside the pool.
+        std::atomic<unsigned int> nextQueue{ 0 };
+        std::atomic<unsigned int> queuedJobs{ 0 };
+        std::atomic<bool> running{ true };
+
+        std::mutex sleepMutex;
+        std::condition_variable wakeUp;
+    };
+}
@@ -0,0 +1,240 @@
+#include "ECSPrecompiledHeader.h"
+#include "PageAllocator.h"
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace EntitySystem
+{
+	HeapPageAllocator& HeapPageAllocator::Get()
+	{
+		static HeapPageAllocator allocator;
+		return allocator;
+	}
+
+	void* HeapPageAllocator::Allocate(int, size_t size, size_t alignment)
+	{
+		return ::operator new(size, std::align_val_t(alignment));
+	}
+
+	void HeapPageAllocator::Free(int, void* page, size_t, size_t alignment)
+	{
+		::operator delete(page, std::align_val_t(alignment));
+	}
+
+	static unsigned char* AlignUp(unsigned char* address, size_t alignment)
+	{
+		uintptr_t value = reinterpret_cast<uintptr_t>(address);
+		return address + ((alignment - value % alignment) % alignment);
+	}
+
+	ComponentArena::ComponentArena(size_t blockSize, bool useHugePages) : blockSize(blockSize), useHugePages(useHugePages)
+	{
+	}
+
+	ComponentArena::~ComponentArena()
+	{
+		Reset();
+	}
+
+	void* ComponentArena::Allocate(int family, size_t size, size_t alignment)
+	{
+		if (family >= 0)
+		{
+			if (static_cast<size_t>(family) >= usage.size())
+			{
+				usage.resize(family + 1, 0);
+				budgets.resize(family + 1, 0);
+			}
+			if (budgets[family] != 0 && usage[family] + size > budgets[family])
+			{
+				ExceedBudget(family, size);
+			}
+			usage[family] += size;
+		}
+
+		//Reusing a freed page is the common case once a level is running: entities come and go, pools grow back to where they were.
+		FreeList& freeList = GetFreeList(size, alignment);
+		if (!freeList.pages.empty())
+		{
+			void* page = freeList.pages.back();
+			freeList.pages.pop_back();
+			return page;
+		}
+
+		//Pages that do not fit in a block get one of their own, which is never carved up further.
+		if (size + alignment > blockSize)
+		{
+			return AlignUp(AllocateBlock(size + alignment), alignment);
+		}
+
+		unsigned char* page = currentBlock ? AlignUp(currentBlock + blockOffset, alignment) : nullptr;
+		if (!page || page + size > currentBlock + blockSize)
+		{
+			//The rest of the previous block is left unused. It is at most one page worth of bytes per block.
+			currentBlock = AllocateBlock(blockSize);
+			page = AlignUp(currentBlock, alignment);
+		}
+		blockOffset = static_cast<size_t>(page + size - currentBlock);
+		return page;
+	}
+
+	void ComponentArena::Free(int family, void* page, size_t size, size_t alignment)
+	{
+		if (family >= 0)
+		{
+			usage[family] -= size;
+		}
+		GetFreeList(size, alignment).pages.push_back(page);
+	}
+
+	void ComponentArena::SetBudget(int family, size_t bytes)
+	{
+		if (static_cast<size_t>(family) >= budgets.size())
+		{
+			usage.resize(family + 1, 0);
+			budgets.resize(family + 1, 0);
+		}
+		budgets[family] = bytes;
+	}
+
+	size_t ComponentArena::GetBudget(int family) const
+	{
+		return static_cast<size_t>(family) < budgets.size() ? budgets[family] : 0;
+	}
+
+	size_t ComponentArena::GetUsage(int family) const
+	{
+		return static_cast<size_t>(family) < usage.size() ? usage[family] : 0;
+	}
+
+	size_t ComponentArena::GetReservedBytes() const
+	{
+		size_t bytes = 0;
+		for (const Block& block : blocks)
+		{
+			bytes += block.size;
+		}
+		return bytes;
+	}
+
+	void ComponentArena::Reset()
+	{
+		for (const Block& block : blocks)
+		{
+			FreeBlock(block);
+		}
+		blocks.clear();
+		freeLists.clear();
+		std::fill(usage.begin(), usage.end(), 0);
+		currentBlock = nullptr;
+		blockOffset = 0;
+	}
+
+	ComponentArena::FreeList& ComponentArena::GetFreeList(size_t size, size_t alignment)
+	{
+		for (FreeList& freeList : freeLists)
+		{
+			if (freeList.size == size && freeList.alignment == alignment)
+			{
+				return freeList;
+			}
+		}
+		freeLists.push_back({ size, alignment, {} });
+		return freeLists.back();
+	}
+
+	void ComponentArena::ExceedBudget(int family, size_t size) const
+	{
+		std::cerr << "ComponentArena: component family " << family << " went over its memory budget of " << budgets[family] << " bytes ("
+			<< usage[family] << " bytes in use, " << size << " bytes requested)." << std::endl;
+		std::abort();
+	}
+
+#ifdef _WIN32
+	unsigned char* ComponentArena::AllocateBlock(size_t size)
+	{
+		void* memory = nullptr;
+
+		//Large pages need the "Lock pages in memory" privilege, which most processes do not have. Without it, the allocation fails and regular pages are used.
+		size_t largePageSize = GetLargePageMinimum();
+		if (useHugePages && largePageSize != 0)
+		{
+			size_t largeSize = (size + largePageSize - 1) / largePageSize * largePageSize;
+			memory = VirtualAlloc(nullptr, largeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+			if (memory)
+			{
+				size = largeSize;
+			}
+		}
+		if (!memory)
+		{
+			memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+		}
+		if (!memory)
+		{
+			throw std::bad_alloc();
+		}
+
+		blocks.push_back({ static_cast<unsigned char*>(memory), size });
+		return blocks.back().memory;
+	}
+
+	void ComponentArena::FreeBlock(const Block& block)
+	{
+		VirtualFree(block.memory, 0, MEM_RELEASE);
+	}
+#else
+	unsigned char* ComponentArena::AllocateBlock(size_t size)
+	{
+		size_t osPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		size = (size + osPageSize - 1) / osPageSize * osPageSize;
+
+		//Transparent huge pages only back ranges aligned to the huge page size, so the mapping is made one block larger and trimmed to an aligned block.
+		size_t alignment = useHugePages ? blockSize : 1;
+		size_t mappedSize = size + (alignment > 1 ? alignment : 0);
+		void* mapping = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mapping == MAP_FAILED)
+		{
+			throw std::bad_alloc();
+		}
+
+		unsigned char* start = static_cast<unsigned char*>(mapping);
+		unsigned char* memory = alignment > 1 ? AlignUp(start, alignment) : start;
+		if (memory != start)
+		{
+			munmap(start, static_cast<size_t>(memory - start));
+		}
+		size_t tail = mappedSize - static_cast<size_t>(memory - start) - size;
+		if (tail != 0)
+		{
+			munmap(memory + size, tail);
+		}
+
+#ifdef MADV_HUGEPAGE
+		if (useHugePages)
+		{
+			madvise(memory, size, MADV_HUGEPAGE);
+		}
+#endif
+
+		blocks.push_back({ memory, size });
+		return memory;
+	}
+
+	void ComponentArena::FreeBlock(const Block& block)
+	{
+		munmap(block.memory, block.size);
+	}
+#endif
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+
+///==== Page Allocators ====
+
+///Component storage never allocates one component at a time: component managers allocate pages (see ComponentData), and archetype storage allocates chunks.
+///Where that memory comes from is up to a PageAllocator, which every component manager and archetype storage is given when it is created.
+///HeapPageAllocator simply goes to the heap, one page at a time. It is what managers created outside of a world use.
+///ComponentArena is what a World uses. Pages are carved out of large blocks (2 MB by default) that are aligned to their size, and backed by huge pages where the OS allows it,
+///so that iterating a pool does not miss the TLB on every page. Freed pages are kept on a free list per size and reused, blocks are only given back by Reset().
+
+///==== Budgets ====
+
+///Every component family can be given a budget, in bytes of pages. Going over it means that something spawns far more components than the game was designed for,
+///which is reported on std::cerr before aborting, rather than letting the process grow until it swaps or runs out of memory much later (fail fast).
+
+namespace EntitySystem
+{
+    //The family that archetype chunks are accounted under, as a chunk holds components of several families.
+    constexpr int ArchetypeChunkFamily = -1;
+
+    class PageAllocator
+    {
+    public:
+        PageAllocator() = default;
+        virtual ~PageAllocator() = default;
+        PageAllocator(const PageAllocator&) = delete;
+        PageAllocator& operator=(const PageAllocator&) = delete;
+
+        //"family" is the component family the page is for. Allocations never fail silently: running out of memory (or budget) aborts.
+        virtual void* Allocate(int family, size_t size, size_t alignment) = 0;
+        virtual void Free(int family, void* page, size_t size, size_t alignment) = 0;
+    };
+
+    class HeapPageAllocator : public PageAllocator
+    {
+    public:
+        //Shared by every manager that was not given an allocator. Stateless, and thus safe to use from several threads.
+        static HeapPageAllocator& Get();
+
+        void* Allocate(int family, size_t size, size_t alignment) override;
+        void Free(int family, void* page, size_t size, size_t alignment) override;
+    };
+
+    class ComponentArena : public PageAllocator
+    {
+    public:
+        explicit ComponentArena(size_t blockSize = DefaultBlockSize, bool useHugePages = true);
+        ~ComponentArena() override;
+
+        //Like every structural change, allocating and freeing pages is not thread-safe. Pages larger than a block get a block of their own.
+        void* Allocate(int family, size_t size, size_t alignment) override;
+        void Free(int family, void* page, size_t size, size_t alignment) override;
+
+        //0 means no budget, which is the default.
+        void SetBudget(int family, size_t bytes);
+        size_t GetBudget(int family) const;
+
+        //Bytes of pages currently allocated for the family (free pages excluded).
+        size_t GetUsage(int family) const;
+
+        //Bytes of blocks held, whether in use or not.
+        size_t GetReservedBytes() const;
+        size_t GetBlockCount() const { return blocks.size(); }
+
+        //Gives every block back to the OS at once, in O(number of blocks). Every page handed out becomes invalid, so whatever used them has to be gone (see World::Reset()).
+        //Budgets are kept.
+        void Reset();
+
+        //Large enough to be backed by a single huge page on x86-64.
+        static constexpr size_t DefaultBlockSize = 2 * 1024 * 1024;
+
+    private:
+        //Blocks are mapped from the OS directly rather than taken from the heap, so that they can be backed by huge pages and given back as soon as they are released.
+        struct Block
+        {
+            unsigned char* memory;
+            size_t size;
+        };
+
+        struct FreeList
+        {
+            size_t size;
+            size_t alignment;
+            std::vector<void*> pages;
+        };
+
+        unsigned char* AllocateBlock(size_t size);
+        static void FreeBlock(const Block& block);
+        FreeList& GetFreeList(size_t size, size_t alignment);
+
+        //Reports the allocation that would go over the budget, and aborts.
+        [[noreturn]] void ExceedBudget(int family, size_t size) const;
+
+        size_t blockSize;
+        bool useHugePages;
+        std::vector<Block> blocks;
+        size_t blockOffset = 0;  //Bytes used in the last regular block, which is the one new pages are carved out of.
+        unsigned char* currentBlock = nullptr;
+        std::vector<FreeList> freeLists;  //Components tend to use a handful of page sizes, so a short vector beats a map.
+        std::vector<size_t> usage;    //Indexed by family.
+        std::vector<size_t> budgets;  //Indexed by family.
+    };
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include "Entity.h"
+#include "ComponentManager.h"
+#include "ComponentMask.h"
+#include "Hierarchy.h"
+
+///==== Prefabs ====
+
+///Spawning a wave of enemies one CreateEntity() and AddComponent() at a time looks every component up in its pool, and tests the mask of every entity against every system once per component.
+///A Prefab holds a copy of every component of an entity instead, captured once with World::CreatePrefab(), or built with Set().
+///World::Instantiate() then creates any number of entities from it in bulk: every pool grows once and is filled by block copies of the prefab's component
+///(doubling memcpy runs for trivially copyable components), every new entity gets the prefab's mask, and each matching system registers them all at once.
+
+///Components are copied, so they have to be copy constructible. Tags are only bits of the prefab's mask. Hierarchy is never part of a prefab: instances start as roots.
+///Instantiating is only available with StorageMode::ComponentPools.
+
+namespace EntitySystem
+{
+    class World;
+
+    class Prefab
+    {
+    public:
+        Prefab() = default;
+        Prefab(Prefab&&) = default;
+        Prefab& operator=(Prefab&&) = default;
+
+        //Gives the prefab the component, replacing the one of the same type it may already have.
+        template <typename ComponentType>
+        void Set(ComponentType component)
+        {
+            static_assert(!std::is_same_v<ComponentType, Hierarchy>, "Hierarchies are set up with World::SetParent(), not through prefabs.");
+            static_assert(std::is_copy_constructible_v<ComponentType>, "Prefab components are copied into every instance, so they have to be copy constructible.");
+            int family = GetComponentFamily<ComponentType>();
+            Remove(family);
+            mask.AddFamily(family);
+            if constexpr (!IsTagComponent<ComponentType>)
+            {
+                auto manager = std::make_unique<ComponentManager<ComponentType>>();
+                manager->AddComponent(Prototype, std::move(component));
+                components.push_back({ family, std::move(manager) });
+            }
+        }
+
+        template <typename ComponentType>
+        void Remove() { Remove(GetComponentFamily<ComponentType>()); }
+
+        const ComponentMask& GetMask() const { return mask; }
+        bool IsEmpty() const { return mask.IsEmpty(); }
+
+    private:
+        friend class World;
+
+        struct PrefabComponent
+        {
+            int family;
+            std::unique_ptr<BaseComponentManager> manager;  //Holds the component, owned by Prototype.
+        };
+
+        void Remove(int family)
+        {
+            components.erase(std::remove_if(components.begin(), components.end(), [family](const PrefabComponent& component) { return component.family == family; }), components.end());
+            mask.RemoveFamily(family);
+        }
+
+        //The entity owning the components in the prefab's own managers. It never exists in a world.
+        static constexpr Entity Prototype = { 1 };
+
+        std::vector<PrefabComponent> components;
+        ComponentMask mask;
+    };
+}
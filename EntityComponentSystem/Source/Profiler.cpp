@@ -0,0 +1,248 @@
+#include "ECSPrecompiledHeader.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define ECS_HAS_TIMESTAMP_COUNTER 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ECS_HAS_TIMESTAMP_COUNTER 1
+#endif
+
+namespace EntitySystem
+{
+	namespace
+	{
+		std::atomic<uint32_t> nextThreadIndex{ 0 };
+
+		size_t RoundUpToPowerOfTwo(size_t value)
+		{
+			size_t result = 1;
+			while (result < value)
+			{
+				result <<= 1;
+			}
+			return result;
+		}
+
+		std::string GetEventName(const ProfileEvent& event, const std::vector<std::string>& systemNames)
+		{
+			switch (event.type)
+			{
+			case ProfileEventType::Frame:
+				return "Frame";
+			case ProfileEventType::FlushCommands:
+				return "FlushCommands";
+			default:
+				break;
+			}
+
+			std::string name = event.system < systemNames.size() ? systemNames[event.system] : "System " + std::to_string(event.system);
+			return event.type == ProfileEventType::SystemRender ? name + "::Render" : name;
+		}
+
+		std::string EscapeJson(const std::string& text)
+		{
+			std::string escaped;
+			for (char character : text)
+			{
+				if (character == '"' || character == '\\')
+				{
+					escaped += '\\';
+					escaped += character;
+				}
+				else if (static_cast<unsigned char>(character) < 0x20)
+				{
+					char code[8];
+					std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned int>(character));
+					escaped += code;
+				}
+				else
+				{
+					escaped += character;
+				}
+			}
+			return escaped;
+		}
+	}
+
+	Profiler::Profiler(size_t capacity) : capacity(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 2))), creationTimestamp(GetTimestamp()), creationTime(std::chrono::steady_clock::now())
+	{
+	}
+
+	uint64_t Profiler::GetTimestamp()
+	{
+#ifdef ECS_HAS_TIMESTAMP_COUNTER
+		return __rdtsc();
+#else
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	uint32_t Profiler::GetThreadIndex()
+	{
+		static thread_local uint32_t index = nextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+		return index;
+	}
+
+	void Profiler::BeginFrame()
+	{
+		if (!events)
+		{
+			events = std::make_unique<ProfileEvent[]>(capacity);
+		}
+		if (timestampFrequency == 0.0 && std::chrono::steady_clock::now() - creationTime >= CalibrationTime)
+		{
+			timestampFrequency = MeasureTimestampFrequency();
+		}
+		frame++;
+	}
+
+	double Profiler::GetTimestampFrequency() const
+	{
+		return timestampFrequency != 0.0 ? timestampFrequency : MeasureTimestampFrequency();
+	}
+
+	double Profiler::MeasureTimestampFrequency() const
+	{
+#ifdef ECS_HAS_TIMESTAMP_COUNTER
+		//The counter ticks at a constant rate on any x86 CPU of the last decade, which is measured against steady_clock rather than asked from the OS.
+		//The longer the interval, the more accurate the measurement, hence waiting for CalibrationTime before keeping it.
+		double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - creationTime).count();
+		return elapsed > 0.0 ? double(GetTimestamp() - creationTimestamp) / elapsed : 1000.0;
+#else
+		return 1000.0;
+#endif
+	}
+
+	std::vector<ProfileEvent> Profiler::GetEvents() const
+	{
+		std::vector<ProfileEvent> recorded;
+		if (!events)
+		{
+			return recorded;
+		}
+
+		uint64_t end = head.load(std::memory_order_acquire);
+		uint64_t begin = end > capacity ? end - capacity : 0;
+		recorded.reserve(static_cast<size_t>(end - begin));
+		for (uint64_t slot = begin; slot < end; slot++)
+		{
+			recorded.push_back(events[slot & (capacity - 1)]);
+		}
+		return recorded;
+	}
+
+	std::vector<ProfileStats> Profiler::GetStats(const std::vector<std::string>& systemNames) const
+	{
+		std::vector<ProfileEvent> recorded = GetEvents();
+		double frequency = GetTimestampFrequency();
+
+		//Frames and flushes first, then the updates of every system, then their renders.
+		struct Series
+		{
+			ProfileEvent first;
+			std::vector<double> durations;
+			uint64_t registeredEntities = 0;
+			uint64_t structuralChanges = 0;
+		};
+
+		size_t systemCount = systemNames.size();
+		std::vector<Series> series(2 + systemCount * 2);
+		for (const ProfileEvent& event : recorded)
+		{
+			size_t index = 0;
+			if (event.type == ProfileEventType::FlushCommands)
+			{
+				index = 1;
+			}
+			else if (event.type != ProfileEventType::Frame)
+			{
+				if (event.system >= systemCount)
+				{
+					continue;
+				}
+				index = (event.type == ProfileEventType::SystemUpdate ? 2 : 2 + systemCount) + event.system;
+			}
+
+			Series& entry = series[index];
+			if (entry.durations.empty())
+			{
+				entry.first = event;
+			}
+			entry.durations.push_back(event.end > event.start ? double(event.end - event.start) / frequency : 0.0);
+			entry.registeredEntities += event.registeredEntities;
+			entry.structuralChanges += event.structuralChanges;
+		}
+
+		std::vector<ProfileStats> stats;
+		for (Series& entry : series)
+		{
+			if (entry.durations.empty())
+			{
+				continue;
+			}
+
+			std::sort(entry.durations.begin(), entry.durations.end());
+			double samples = double(entry.durations.size());
+			double total = 0.0;
+			for (double duration : entry.durations)
+			{
+				total += duration;
+			}
+
+			ProfileStats result;
+			result.name = GetEventName(entry.first, systemNames);
+			result.type = entry.first.type;
+			result.samples = static_cast<unsigned int>(entry.durations.size());
+			result.minimum = entry.durations.front();
+			result.maximum = entry.durations.back();
+			result.average = total / samples;
+			//Nearest rank: the smallest duration that at least 99% of the samples do not exceed.
+			size_t rank = static_cast<size_t>(std::ceil(samples * 0.99));
+			result.p99 = entry.durations[std::min(std::max<size_t>(rank, 1), entry.durations.size()) - 1];
+			result.averageRegisteredEntities = double(entry.registeredEntities) / samples;
+			result.averageStructuralChanges = double(entry.structuralChanges) / samples;
+			stats.push_back(result);
+		}
+		return stats;
+	}
+
+	bool Profiler::WriteChromeTrace(const std::string& path, const std::vector<std::string>& systemNames) const
+	{
+		std::ofstream file(path, std::ios::trunc);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		std::vector<ProfileEvent> recorded = GetEvents();
+		double frequency = GetTimestampFrequency();
+		uint64_t origin = UINT64_MAX;
+		for (const ProfileEvent& event : recorded)
+		{
+			origin = std::min(origin, event.start);
+		}
+
+		//Complete ("X") events, with timestamps in microseconds since the first event.
+		file << std::fixed << std::setprecision(3);
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		for (size_t i = 0; i < recorded.size(); i++)
+		{
+			const ProfileEvent& event = recorded[i];
+			const char* category = event.type == ProfileEventType::Frame ? "frame" : event.type == ProfileEventType::FlushCommands ? "commands" : "system";
+			double duration = event.end > event.start ? double(event.end - event.start) / frequency : 0.0;
+
+			file << (i == 0 ? "\n" : ",\n") << "{\"name\":\"" << EscapeJson(GetEventName(event, systemNames)) << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+				<< ",\"ts\":" << double(event.start - origin) / frequency << ",\"dur\":" << duration
+				<< ",\"args\":{\"frame\":" << event.frame << ",\"registeredEntities\":" << event.registeredEntities << ",\"structuralChanges\":" << event.structuralChanges << "}}";
+		}
+		file << "\n]}\n";
+		return file.good();
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <atomic>
+#include <chrono>
+
+///==== Profiler ====
+
+///Every World::Update() records how long each system took, how many entities it was registered with (not how many it actually touched), and how many structural changes (commands) it recorded,
+///along with how long the whole frame and every command buffer flush took. Records go into a fixed-size ring buffer, which always holds the last few hundred frames.
+///World::GetProfileStats() turns the ring into min/average/p99 statistics per system, and World::WriteChromeTrace() dumps it as a Chrome trace_event file,
+///which chrome://tracing or https://ui.perfetto.dev display as a timeline with one row per thread.
+
+///Recording an event costs two reads of the CPU timestamp counter and one atomic increment, so the profiler can stay enabled in release builds.
+///Defining ECS_ENABLE_PROFILER to 0 compiles the instrumentation out altogether, in which case there are no statistics and no trace.
+
+#ifndef ECS_ENABLE_PROFILER
+#define ECS_ENABLE_PROFILER 1
+#endif
+
+namespace EntitySystem
+{
+    enum class ProfileEventType : uint8_t
+    {
+        Frame,          //A whole World::Update().
+        FlushCommands,  //Playing back the command buffers, see World::FlushCommands().
+        SystemUpdate,
+        SystemRender
+    };
+
+    struct ProfileEvent
+    {
+        uint64_t start;  //Raw timestamps, see Profiler::GetTimestamp().
+        uint64_t end;
+        uint32_t frame;
+        uint32_t system;  //Index of the system in the world, for system events.
+        uint32_t registeredEntities;  //Entities the system was registered with, or alive in the world for frames. Systems may skip some of them.
+        uint32_t structuralChanges;
+        uint32_t thread;  //Small per-thread number, see Profiler::GetThreadIndex().
+        ProfileEventType type;
+    };
+
+    //Statistics over every event of one kind still held by the ring buffer. Times are in microseconds.
+    struct ProfileStats
+    {
+        std::string name;
+        ProfileEventType type;
+        unsigned int samples = 0;
+        double minimum = 0.0;
+        double average = 0.0;
+        double p99 = 0.0;
+        double maximum = 0.0;
+        double averageRegisteredEntities = 0.0;
+        double averageStructuralChanges = 0.0;
+    };
+
+    class Profiler
+    {
+    public:
+        //The capacity is rounded up to a power of two. Memory is only allocated once the first frame starts.
+        explicit Profiler(size_t capacity = DefaultCapacity);
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        //The CPU timestamp counter where there is one, steady_clock nanoseconds elsewhere. Converted to time when the events are read back.
+        static uint64_t GetTimestamp();
+
+        //Numbers the threads that record events, in the order they first do so.
+        static uint32_t GetThreadIndex();
+
+        //Must be called from the thread that updates the world, before any event of the frame is recorded.
+        void BeginFrame();
+
+        //Wait-free, and safe to call from several threads at once. Once the ring is full, the oldest events are overwritten.
+        void Record(ProfileEventType type, uint32_t system, uint64_t start, uint64_t end, uint32_t registeredEntities, uint32_t structuralChanges)
+        {
+            if (!events)
+            {
+                return;
+            }
+
+            uint64_t slot = head.fetch_add(1, std::memory_order_relaxed);
+            events[slot & (capacity - 1)] = { start, end, frame, system, registeredEntities, structuralChanges, GetThreadIndex(), type };
+        }
+
+        //The following read the ring, and must not be called while a frame is being recorded (in practice: from the thread that updates the world, between updates).
+        //"systemNames" are indexed like the systems of the world.
+        std::vector<ProfileEvent> GetEvents() const;
+        std::vector<ProfileStats> GetStats(const std::vector<std::string>& systemNames) const;
+        bool WriteChromeTrace(const std::string& path, const std::vector<std::string>& systemNames) const;
+
+        //Forgets every event recorded so far.
+        void Clear() { head.store(0, std::memory_order_relaxed); }
+
+        //Enough for a few hundred frames of a world with a dozen systems.
+        static constexpr size_t DefaultCapacity = 8192;
+
+    private:
+        //Timestamps per microsecond. Measured once, by the first frame that starts at least CalibrationTime after the profiler was created,
+        //and estimated over the time elapsed so far when the events are read back before that.
+        double GetTimestampFrequency() const;
+        double MeasureTimestampFrequency() const;
+
+        static constexpr std::chrono::milliseconds CalibrationTime{ 10 };
+
+        size_t capacity;
+        std::unique_ptr<ProfileEvent[]> events;
+        std::atomic<uint64_t> head{ 0 };
+        uint32_t frame = 0;
+
+        uint64_t creationTimestamp;
+        std::chrono::steady_clock::time_point creationTime;
+        double timestampFrequency = 0.0;
+    };
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "Component.h"
+
+///==== Shared Components ====
+
+///Thousands of entities often carry the very same value: the material of every tree of a forest, the settings of every enemy of a kind.
+///Shared<ValueType> is a component holding a pointer to a single, reference counted copy of the value, interned in a store per value type:
+///adding Shared<Material>(material) to ten thousand entities keeps one Material, and ten thousand pointers in the pool.
+///struct Material { ... bool operator==(const Material&) const; };   //Also needs a std::hash<Material> specialization.
+///world.AddComponent(entity, Shared<Material>(material));
+///world.View<const Shared<Material>, Position>().Each([](Entity entity, const Shared<Material>& material, Position& position) { Draw(*material, position); });
+
+///Values are immutable once shared: an entity changes its value by being given another Shared<>, which interns the new one and releases the old one.
+///The last reference to go, by destroying or resetting the entities, frees the value. Copies of a Shared<> (into a command buffer, a prefab, or another world) only
+///add a reference, and may be made and released from any thread. Shared components are not saved in snapshots, as their value lives outside the world.
+
+namespace EntitySystem
+{
+    template <typename ValueType>
+    class SharedComponentStore
+    {
+    public:
+        struct Node
+        {
+            explicit Node(const ValueType& value) : value(value) {}
+
+            const ValueType value;
+            std::atomic<uint32_t> references{ 1 };
+        };
+
+        //Never destroyed: components of worlds destroyed during static destruction may still release their values after it would have been.
+        static SharedComponentStore& Get()
+        {
+            static SharedComponentStore* store = new SharedComponentStore();
+            return *store;
+        }
+
+        //The node holding a value equal to the given one, with one more reference, or a new one.
+        Node* Acquire(const ValueType& value)
+        {
+            size_t hash = std::hash<ValueType>()(value);
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto range = nodes.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second->value == value)
+                {
+                    it->second->references.fetch_add(1, std::memory_order_relaxed);
+                    return it->second.get();
+                }
+            }
+            return nodes.emplace(hash, std::make_unique<Node>(value))->second.get();
+        }
+
+        //The caller already holds a reference, so the node cannot go away meanwhile.
+        void AddReference(Node* node) { node->references.fetch_add(1, std::memory_order_relaxed); }
+
+        void Release(Node* node)
+        {
+            //Only the last reference needs the lock, as Acquire() could otherwise revive the node while it is being erased.
+            uint32_t references = node->references.load(std::memory_order_relaxed);
+            while (references > 1)
+            {
+                if (node->references.compare_exchange_weak(references, references - 1, std::memory_order_acq_rel))
+                {
+                    return;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (node->references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            {
+                return;
+            }
+
+            auto range = nodes.equal_range(std::hash<ValueType>()(node->value));
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second.get() == node)
+                {
+                    nodes.erase(it);
+                    return;
+                }
+            }
+        }
+
+        //Number of distinct values currently shared.
+        size_t GetValueCount()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return nodes.size();
+        }
+
+    private:
+        SharedComponentStore() = default;
+
+        std::mutex mutex;
+        std::unordered_multimap<size_t, std::unique_ptr<Node>> nodes;
+    };
+
+    template <typename ValueType>
+    struct Shared : Component<Shared<ValueType>>
+    {
+        using Store = SharedComponentStore<ValueType>;
+
+        Shared() = default;
+        explicit Shared(const ValueType& value) : node(Store::Get().Acquire(value)) {}
+
+        Shared(const Shared& other) : node(other.node)
+        {
+            if (node)
+            {
+                Store::Get().AddReference(node);
+            }
+        }
+
+        Shared(Shared&& other) noexcept : node(other.node) { other.node = nullptr; }
+
+        //Taken by value, which covers both copy and move assignment.
+        Shared& operator=(Shared other) noexcept
+        {
+            std::swap(node, other.node);
+            return *this;
+        }
+
+        ~Shared()
+        {
+            if (node)
+            {
+                Store::Get().Release(node);
+            }
+        }
+
+        const ValueType& Get() const { return node->value; }
+        const ValueType& operator*() const { return node->value; }
+        const ValueType* operator->() const { return &node->value; }
+        explicit operator bool() const { return node != nullptr; }
+
+        //Number of components (and other copies) sharing the value.
+        uint32_t GetReferenceCount() const { return node ? node->references.load(std::memory_order_relaxed) : 0; }
+
+        //Equal values are interned into the same node, so comparing them is comparing pointers.
+        bool operator==(const Shared& other) const { return node == other.node; }
+        bool operator!=(const Shared& other) const { return node != other.node; }
+
+    private:
+        typename Store::Node* node = nullptr;
+    };
+}
@@ -0,0 +1,97 @@
+#include "ECSPrecompiledHeader.h"
+#include "Snapshot.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace EntitySystem
+{
+#ifdef _WIN32
+	bool MemoryMappedFile::Open(const std::string& path)
+	{
+		fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+		{
+			fileHandle = nullptr;
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+		{
+			return false;
+		}
+		size = static_cast<uint64_t>(fileSize.QuadPart);
+
+		//PAGE_WRITECOPY together with FILE_MAP_COPY gives every written page a private copy, just like MAP_PRIVATE.
+		mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (!mappingHandle)
+		{
+			return false;
+		}
+
+		data = static_cast<unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0));
+		return data != nullptr;
+	}
+
+	MemoryMappedFile::~MemoryMappedFile()
+	{
+		if (data)
+		{
+			UnmapViewOfFile(data);
+		}
+		if (mappingHandle)
+		{
+			CloseHandle(mappingHandle);
+		}
+		if (fileHandle)
+		{
+			CloseHandle(fileHandle);
+		}
+	}
+#else
+	bool MemoryMappedFile::Open(const std::string& path)
+	{
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return false;
+		}
+
+		struct stat status;
+		if (fstat(file, &status) != 0 || status.st_size == 0)
+		{
+			close(file);
+			return false;
+		}
+		size = static_cast<uint64_t>(status.st_size);
+
+		//The mapping stays valid once the descriptor is closed.
+		void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		close(file);
+		if (mapping == MAP_FAILED)
+		{
+			return false;
+		}
+
+		data = static_cast<unsigned char*>(mapping);
+		return true;
+	}
+
+	MemoryMappedFile::~MemoryMappedFile()
+	{
+		if (data)
+		{
+			munmap(data, size);
+		}
+	}
+#endif
+}
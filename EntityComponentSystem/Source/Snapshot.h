@@ -0,0 +1,267 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include "Entity.h"
+
+///==== Snapshots ====
+
+///A snapshot is a binary image of a world: the state of the entity manager, and for every registered component type, its dense component array and the entity owning each instance.
+///The file is laid out so that it can be used in place. Component pages are written exactly as they sit in memory, each pool starting on a page boundary of the file,
+///so loading maps the file into memory and hands the mapped pages straight to the component managers (copy-on-write, so the file itself is never modified).
+///Nothing is parsed per entity, and component data is only read from disk once it is first touched.
+
+///This only works for trivially copyable components. Any other component needs a ComponentSerializer specialization, and is written and read one component at a time.
+
+///File layout:
+///SnapshotHeader | SnapshotBlock per component type | generations | free indices | per block: entities, then component data (raw pages or serialized stream)
+
+namespace EntitySystem
+{
+    constexpr char SnapshotMagic[8] = { 'E', 'C', 'S', 'S', 'N', 'A', 'P', '\0' };
+
+    //Bumped whenever the layout below changes. Snapshots of any other version are rejected.
+    constexpr uint32_t SnapshotVersion = 1;
+
+    //Component pages are aligned on this boundary within the file, so that they are just as aligned once mapped.
+    constexpr uint64_t SnapshotPageAlignment = 4096;
+
+    struct SnapshotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t blockCount;
+        uint64_t generationsOffset;
+        uint64_t generationCount;
+        uint64_t freeIndicesOffset;
+        uint64_t freeIndexCount;
+    };
+
+    enum class SnapshotEncoding : uint32_t
+    {
+        RawPages,   //The component pages as they are in memory, adopted on load.
+        Serialized, //A stream written by ComponentSerializer, one component after the other.
+        FieldPages  //The pages of a structure of arrays component as they are in memory (see StructOfArrays.h), adopted on load.
+    };
+
+    struct SnapshotBlock
+    {
+        char name[64];              //The name the component type was registered under, see World::RegisterSnapshotComponent().
+        SnapshotEncoding encoding;
+        uint32_t componentSize;     //For raw pages, the layout has to match exactly.
+        uint32_t pageSize;
+        uint32_t instanceCount;     //Including the reserved instance 0.
+        uint64_t entitiesOffset;    //One Entity per instance.
+        uint64_t dataOffset;
+        uint64_t dataSize;
+    };
+
+    //Appends to a snapshot file, or to a buffer in memory (see DeltaSnapshot.h). Offsets returned by the writer are relative to the start of the file or buffer.
+    class SnapshotWriter
+    {
+    public:
+        explicit SnapshotWriter(const std::string& path) : file(path, std::ios::binary | std::ios::trunc) {}
+        explicit SnapshotWriter(std::vector<unsigned char>& buffer) : buffer(&buffer), offset(buffer.size()) {}
+
+        bool IsOpen() const { return buffer || file.is_open(); }
+        bool Failed() const { return !buffer && !file.good(); }
+        uint64_t GetOffset() const { return offset; }
+
+        void Write(const void* data, size_t size)
+        {
+            if (buffer)
+            {
+                const unsigned char* bytes = static_cast<const unsigned char*>(data);
+                buffer->insert(buffer->end(), bytes, bytes + size);
+            }
+            else
+            {
+                file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            }
+            offset += size;
+        }
+
+        //For trivially copyable values.
+        template <typename ValueType>
+        void Write(const ValueType& value)
+        {
+            static_assert(std::is_trivially_copyable_v<ValueType>, "Only trivially copyable values can be written as raw bytes.");
+            Write(&value, sizeof(ValueType));
+        }
+
+        void WriteString(const std::string& value)
+        {
+            Write(static_cast<uint32_t>(value.size()));
+            Write(value.data(), value.size());
+        }
+
+        //Seven bits per byte, so that the small counts and index gaps of delta streams take a single byte.
+        void WriteVarint(uint64_t value)
+        {
+            unsigned char bytes[10];
+            size_t count = 0;
+            while (value >= 0x80)
+            {
+                bytes[count++] = static_cast<unsigned char>(value | 0x80);
+                value >>= 7;
+            }
+            bytes[count++] = static_cast<unsigned char>(value);
+            Write(bytes, count);
+        }
+
+        void WriteZeros(size_t size)
+        {
+            static const char zeros[4096] = {};
+            while (size > 0)
+            {
+                size_t chunk = std::min(size, sizeof(zeros));
+                Write(zeros, chunk);
+                size -= chunk;
+            }
+        }
+
+        //Pads the file so that the next write starts on a multiple of "alignment".
+        void Align(uint64_t alignment) { WriteZeros(static_cast<size_t>((alignment - offset % alignment) % alignment)); }
+
+        //Overwrites bytes that have already been written, without moving the end of the file.
+        void Patch(uint64_t at, const void* data, size_t size)
+        {
+            if (buffer)
+            {
+                std::memcpy(buffer->data() + at, data, size);
+                return;
+            }
+            file.seekp(static_cast<std::streamoff>(at));
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            file.seekp(static_cast<std::streamoff>(offset));
+        }
+
+    private:
+        std::ofstream file;
+        std::vector<unsigned char>* buffer = nullptr;
+        uint64_t offset = 0;
+    };
+
+    //Reads a serialized stream out of a mapped snapshot. Reading past the end of the stream marks the reader as failed and returns zeroed values.
+    class SnapshotReader
+    {
+    public:
+        SnapshotReader(const unsigned char* data, uint64_t size) : data(data), size(size) {}
+
+        bool Failed() const { return failed; }
+
+        void Read(void* destination, size_t count)
+        {
+            if (failed || count > size - position)
+            {
+                failed = true;
+                std::memset(destination, 0, count);
+                return;
+            }
+            std::memcpy(destination, data + position, count);
+            position += count;
+        }
+
+        template <typename ValueType>
+        ValueType Read()
+        {
+            static_assert(std::is_trivially_copyable_v<ValueType>, "Only trivially copyable values can be read as raw bytes.");
+            ValueType value;
+            Read(&value, sizeof(ValueType));
+            return value;
+        }
+
+        //Returns the next "count" bytes in place, or nullptr if the stream is too short.
+        const unsigned char* ReadBytes(size_t count)
+        {
+            if (failed || count > size - position)
+            {
+                failed = true;
+                return nullptr;
+            }
+            const unsigned char* bytes = data + position;
+            position += count;
+            return bytes;
+        }
+
+        uint64_t ReadVarint()
+        {
+            uint64_t value = 0;
+            for (unsigned int shift = 0; shift < 64; shift += 7)
+            {
+                unsigned char byte = Read<unsigned char>();
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80))
+                {
+                    return value;
+                }
+            }
+            failed = true;
+            return 0;
+        }
+
+        //Marks the reader as failed, for callers that find the data itself to be inconsistent.
+        void Fail() { failed = true; }
+
+        uint64_t GetPosition() const { return position; }
+        bool IsAtEnd() const { return position == size; }
+
+        std::string ReadString()
+        {
+            uint32_t length = Read<uint32_t>();
+            if (failed || length > size - position)
+            {
+                failed = true;
+                return {};
+            }
+            std::string value(reinterpret_cast<const char*>(data + position), length);
+            position += length;
+            return value;
+        }
+
+    private:
+        const unsigned char* data;
+        uint64_t size;
+        uint64_t position = 0;
+        bool failed = false;
+    };
+
+    //Components that are not trivially copyable (because they own memory, for example) need to specialize this, providing:
+    //static void Save(SnapshotWriter& writer, const ComponentType& component);
+    //static ComponentType Load(SnapshotReader& reader);
+    template <typename ComponentType>
+    struct ComponentSerializer
+    {
+        static constexpr bool IsDefault = true;
+    };
+
+    template <typename ComponentType, typename = void>
+    struct HasComponentSerializer : std::true_type {};
+
+    template <typename ComponentType>
+    struct HasComponentSerializer<ComponentType, std::void_t<decltype(ComponentSerializer<ComponentType>::IsDefault)>> : std::false_type {};
+
+    //A read-only view of a whole file, mapped copy-on-write: pages adopted by component managers can be written to without touching the file.
+    class MemoryMappedFile
+    {
+    public:
+        MemoryMappedFile() = default;
+        ~MemoryMappedFile();
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+        bool Open(const std::string& path);
+
+        unsigned char* GetData() const { return data; }
+        uint64_t GetSize() const { return size; }
+
+    private:
+        unsigned char* data = nullptr;
+        uint64_t size = 0;
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,171 @@
+#include "ECSPrecompiledHeader.h"
+#include "SpatialGrid.h"
+#include <cmath>
+
+namespace EntitySystem
+{
+	SpatialHashGrid::SpatialHashGrid(float cellSize, unsigned int bucketCount) : cellSize(cellSize), inverseCellSize(1.0f / cellSize)
+	{
+		assert(cellSize > 0.0f);
+
+		unsigned int size = 1;
+		while (size < bucketCount)
+		{
+			size *= 2;
+		}
+		buckets.resize(size);
+		bucketMask = size - 1;
+	}
+
+	void SpatialHashGrid::Insert(Entity entity, float x, float y)
+	{
+		int cellX = CellOf(x);
+		int cellY = CellOf(y);
+		unsigned int bucket = BucketOf(cellX, cellY);
+
+		if (entity.Index() >= locations.size())
+		{
+			locations.resize(entity.Index() + 1);
+		}
+
+		Location& location = locations[entity.Index()];
+		if (location.bucket != Location::None)
+		{
+			Entry& entry = buckets[location.bucket][location.slot];
+			if (entry.entity == entity && entry.cellX == cellX && entry.cellY == cellY)
+			{
+				//Still in the same cell, which is by far the most common case for moving entities.
+				entry.x = x;
+				entry.y = y;
+				return;
+			}
+			RemoveAt(location);
+		}
+
+		std::vector<Entry>& entries = buckets[bucket];
+		location.bucket = bucket;
+		location.slot = static_cast<unsigned int>(entries.size());
+		entries.push_back({ entity, x, y, cellX, cellY });
+		entityCount++;
+	}
+
+	void SpatialHashGrid::Remove(Entity entity)
+	{
+		if (Contains(entity))
+		{
+			RemoveAt(locations[entity.Index()]);
+		}
+	}
+
+	bool SpatialHashGrid::Contains(Entity entity) const
+	{
+		if (entity.Index() >= locations.size())
+		{
+			return false;
+		}
+
+		const Location& location = locations[entity.Index()];
+		return location.bucket != Location::None && buckets[location.bucket][location.slot].entity == entity;
+	}
+
+	void SpatialHashGrid::Clear()
+	{
+		for (std::vector<Entry>& entries : buckets)
+		{
+			entries.clear();
+		}
+		locations.clear();
+		entityCount = 0;
+	}
+
+	void SpatialHashGrid::QueryRadius(float x, float y, float radius, std::vector<Entity>& results) const
+	{
+		float radiusSquared = radius * radius;
+		ForEachEntry(CellOf(x - radius), CellOf(y - radius), CellOf(x + radius), CellOf(y + radius), [&](const Entry& entry)
+		{
+			float dx = entry.x - x;
+			float dy = entry.y - y;
+			if (dx * dx + dy * dy <= radiusSquared)
+			{
+				results.push_back(entry.entity);
+			}
+		});
+	}
+
+	void SpatialHashGrid::QueryBox(float minX, float minY, float maxX, float maxY, std::vector<Entity>& results) const
+	{
+		ForEachEntry(CellOf(minX), CellOf(minY), CellOf(maxX), CellOf(maxY), [&](const Entry& entry)
+		{
+			if (entry.x >= minX && entry.x <= maxX && entry.y >= minY && entry.y <= maxY)
+			{
+				results.push_back(entry.entity);
+			}
+		});
+	}
+
+	int SpatialHashGrid::CellOf(float coordinate) const
+	{
+		return static_cast<int>(std::floor(coordinate * inverseCellSize));
+	}
+
+	unsigned int SpatialHashGrid::BucketOf(int cellX, int cellY) const
+	{
+		return (static_cast<unsigned int>(cellX) * 73856093u ^ static_cast<unsigned int>(cellY) * 19349663u) & bucketMask;
+	}
+
+	void SpatialHashGrid::RemoveAt(Location location)
+	{
+		std::vector<Entry>& entries = buckets[location.bucket];
+		locations[entries[location.slot].entity.Index()].bucket = Location::None;
+
+		//Swap the last entry into the hole, as EntitySet does.
+		if (location.slot != entries.size() - 1)
+		{
+			entries[location.slot] = entries.back();
+			locations[entries[location.slot].entity.Index()].slot = location.slot;
+		}
+		entries.pop_back();
+		entityCount--;
+	}
+
+	template <typename Function>
+	void SpatialHashGrid::ForEachEntry(int minCellX, int minCellY, int maxCellX, int maxCellY, Function&& function) const
+	{
+		if (minCellX > maxCellX || minCellY > maxCellY)
+		{
+			return;
+		}
+
+		//A range covering more cells than there are buckets would visit some buckets several times, so it tests every entry once instead.
+		uint64_t cellCount = uint64_t(int64_t(maxCellX) - minCellX + 1) * uint64_t(int64_t(maxCellY) - minCellY + 1);
+		if (cellCount > buckets.size())
+		{
+			for (const std::vector<Entry>& entries : buckets)
+			{
+				for (const Entry& entry : entries)
+				{
+					if (entry.cellX >= minCellX && entry.cellX <= maxCellX && entry.cellY >= minCellY && entry.cellY <= maxCellY)
+					{
+						function(entry);
+					}
+				}
+			}
+			return;
+		}
+
+		for (int cellY = minCellY; cellY <= maxCellY; cellY++)
+		{
+			for (int cellX = minCellX; cellX <= maxCellX; cellX++)
+			{
+				for (const Entry& entry : buckets[BucketOf(cellX, cellY)])
+				{
+					//Other cells hashed into the same bucket are visited on their own turn, or are outside of the range.
+					if (entry.cellX == cellX && entry.cellY == cellY)
+					{
+						function(entry);
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include "Entity.h"
+#include "System.h"
+#include "World.h"
+
+///==== Spatial Grids ====
+
+///Answers "which entities are near this point" without looking at every entity, for collision, AI perception or area effects.
+///The plane is cut into square cells of a fixed size, and each cell is hashed into one of a fixed number of buckets, so the grid is unbounded and its memory does not depend on how spread out the entities are.
+///A bucket is a packed array of entries, which queries read without any indirection. Entries keep the cell they were filed under, so that cells sharing a bucket are told apart.
+
+///SpatialGridSystem<Position> keeps a grid up to date from a position component: every update, it only refiles the entities whose position changed since its last update (see Changed<> in View.h),
+///and only moves an entry between buckets when the entity crossed into another cell. Entities that lose the component or are destroyed leave the grid at once.
+///Queries see the positions as of the grid's last update, so systems that query it should RunAfter() it. Queries do not modify the grid and can run on several threads at once.
+
+///The cell size should be about the radius of typical queries: much smaller cells make queries visit many cells, much larger ones make them test many entities.
+///Entities bunched in a few cells degrade to a scan of those cells; a hierarchical structure (such as a loose quadtree) would handle this better but costs more to update every frame.
+
+namespace EntitySystem
+{
+    class SpatialHashGrid
+    {
+    public:
+        //bucketCount is rounded up to a power of two.
+        explicit SpatialHashGrid(float cellSize, unsigned int bucketCount = 4096);
+
+        //Files the entity at (x, y), or moves it there if it is already in the grid.
+        void Insert(Entity entity, float x, float y);
+        void Remove(Entity entity);
+        bool Contains(Entity entity) const;
+        void Clear();
+
+        //Appends every entity within "radius" of (x, y), or inside the box, to "results", in no particular order. Bounds are inclusive.
+        void QueryRadius(float x, float y, float radius, std::vector<Entity>& results) const;
+        void QueryBox(float minX, float minY, float maxX, float maxY, std::vector<Entity>& results) const;
+
+        float GetCellSize() const { return cellSize; }
+        unsigned int GetBucketCount() const { return static_cast<unsigned int>(buckets.size()); }
+        unsigned int GetEntityCount() const { return entityCount; }
+
+    private:
+        struct Entry
+        {
+            Entity entity;
+            float x, y;
+            int cellX, cellY;
+        };
+
+        //Where an entity is filed, indexed by entity index.
+        struct Location
+        {
+            static constexpr unsigned int None = ~0u;
+            unsigned int bucket = None;
+            unsigned int slot = 0;
+        };
+
+        int CellOf(float coordinate) const;
+        unsigned int BucketOf(int cellX, int cellY) const;
+        void RemoveAt(Location location);
+
+        //Calls function(entry) once for every entry filed under a cell of the range. Cells of the range may share a bucket, which is then scanned once per cell,
+        //with the entries of the other cells skipped by their own cell. Ranges of more cells than there are buckets scan every bucket once instead.
+        template <typename Function>
+        void ForEachEntry(int minCellX, int minCellY, int maxCellX, int maxCellY, Function&& function) const;
+
+        float cellSize;
+        float inverseCellSize;
+        unsigned int bucketMask;
+        unsigned int entityCount = 0;
+        std::vector<std::vector<Entry>> buckets;
+        std::vector<Location> locations;
+    };
+
+    //How to read the coordinates of a position component. Defaults to its x and y members; specialize it for components that name them differently.
+    template <typename PositionType>
+    struct SpatialPosition
+    {
+        static float X(const PositionType& position) { return position.x; }
+        static float Y(const PositionType& position) { return position.y; }
+    };
+
+    template <typename PositionType>
+    class SpatialGridSystem : public System
+    {
+    public:
+        explicit SpatialGridSystem(float cellSize, unsigned int bucketCount = 4096) : grid(cellSize, bucketCount)
+        {
+            signature.AddComponent<PositionType>();
+            Reads<PositionType>();
+        }
+
+        void Update(int deltaTime) override
+        {
+            //Newly registered entities are let through too, as their component was added after the last update.
+            Each<Changed<const PositionType>>([this](Entity entity, const PositionType& position)
+            {
+                grid.Insert(entity, SpatialPosition<PositionType>::X(position), SpatialPosition<PositionType>::Y(position));
+            });
+        }
+
+        void QueryRadius(float x, float y, float radius, std::vector<Entity>& results) const { grid.QueryRadius(x, y, radius, results); }
+        void QueryBox(float minX, float minY, float maxX, float maxY, std::vector<Entity>& results) const { grid.QueryBox(minX, minY, maxX, maxY, results); }
+
+        const SpatialHashGrid& GetGrid() const { return grid; }
+
+    protected:
+        void OnEntityUnregistered(Entity entity) override { grid.Remove(entity); }
+        void OnReset() override { grid.Clear(); }
+
+    private:
+        SpatialHashGrid grid;
+    };
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <tuple>
+#include "World.h"
+
+///==== Static Worlds ====
+
+///A World finds the manager of a component type at runtime: it looks the family up in a vector, creating the manager the first time, and casts it to the right type.
+///When the component types of a game are known up front, StaticWorld<Position, Velocity, ...> keeps their managers in a std::tuple instead,
+///so that reaching one is a member access the compiler resolves entirely, and adding, removing, viewing and unpacking those components skips the lookup.
+///Every listed component needs a fixed family (see ECS_COMPONENT_FAMILY in Component.h), which also makes the families the same in every run.
+
+///A StaticWorld is a World: other component types (for example ones loaded by plugins) are still registered dynamically, and code that only knows the World,
+///such as systems and entity handles, works with every component, just without the shortcut. Only StorageMode::ComponentPools is supported, as archetypes do not use managers.
+
+namespace EntitySystem
+{
+    template <typename... ComponentTypes>
+    class StaticWorld : public World
+    {
+        static_assert((HasStaticFamily<ComponentTypes> && ...), "Every component of a StaticWorld needs a fixed family, see ECS_COMPONENT_FAMILY.");
+        static_assert((!std::is_const_v<ComponentTypes> && ...), "The components of a StaticWorld are listed without const.");
+        static_assert((!IsTagComponent<ComponentTypes> && ...), "Tags have no manager to resolve, and are not listed in a StaticWorld.");
+
+    public:
+        explicit StaticWorld(std::unique_ptr<EntityManager> entityManager) : World(std::move(entityManager)), managers(GetPageAllocator<ComponentTypes>()...)
+        {
+            static_assert(HasUniqueFamilies(), "Two components of a StaticWorld share the same fixed family.");
+            (RegisterManager<ComponentTypes>(), ...);
+        }
+
+        template <typename ComponentType>
+        static constexpr bool Contains = (std::is_same_v<std::remove_const_t<ComponentType>, ComponentTypes> || ...);
+
+        //The manager of a listed component type.
+        template <typename ComponentType>
+        ComponentManager<std::remove_const_t<ComponentType>>& GetManager()
+        {
+            static_assert(Contains<ComponentType>, "The component is not part of the StaticWorld.");
+            return std::get<ComponentManager<std::remove_const_t<ComponentType>>>(managers);
+        }
+
+        //The same as World's, with the manager of listed components resolved at compile time.
+
+        template <typename ComponentType>
+        void AddCustomComponentManager(std::unique_ptr<ComponentManager<ComponentType>> manager)
+        {
+            static_assert(!Contains<ComponentType>, "The managers of the components of a StaticWorld cannot be replaced.");
+            World::AddCustomComponentManager(std::move(manager));
+        }
+
+        //Lvalues are copied, rvalues moved. Either way, the component type is the one without reference or const, so that listed components never miss their manager.
+        template <typename ComponentType>
+        void AddComponent(Entity const& entity, ComponentType&& component)
+        {
+            using StoredType = std::remove_cv_t<std::remove_reference_t<ComponentType>>;
+            if constexpr (Contains<StoredType>)
+            {
+                GetManager<StoredType>().AddComponent(entity, StoredType(std::forward<ComponentType>(component)));
+
+                ComponentMask& mask = GetEntityMask(entity);
+                ComponentMask oldMask = mask;
+                mask.AddFamily(ComponentFamilyTraits<StoredType>::Family);
+
+                UpdateEntityMask(entity, oldMask);
+            }
+            else
+            {
+                World::AddComponent(entity, StoredType(std::forward<ComponentType>(component)));
+            }
+        }
+
+        template <typename ComponentType>
+        void RemoveComponent(Entity const& entity)
+        {
+            if constexpr (Contains<ComponentType>)
+            {
+                GetManager<ComponentType>().DestroyComponent(entity);
+
+                ComponentMask& mask = GetEntityMask(entity);
+                ComponentMask oldMask = mask;
+                mask.RemoveFamily(ComponentFamilyTraits<ComponentType>::Family);
+
+                UpdateEntityMask(entity, oldMask);
+            }
+            else
+            {
+                World::RemoveComponent<ComponentType>(entity);
+            }
+        }
+
+        template <typename ComponentType, typename... Args>
+        void Unpack(Entity e, ComponentHandle<ComponentType>& handle, ComponentHandle<Args>&... args)
+        {
+            Unpack(e, handle);
+            Unpack<Args...>(e, args...);
+        }
+
+        template <typename ComponentType>
+        void Unpack(Entity e, ComponentHandle<ComponentType>& handle)
+        {
+            if constexpr (Contains<ComponentType>)
+            {
+                if constexpr (std::is_const_v<ComponentType>)
+                {
+                    handle = ComponentHandle<ComponentType>(e, GetManager<ComponentType>().LookupComponent(e), this);
+                }
+                else
+                {
+                    handle = ComponentHandle<ComponentType>(e, GetManager<ComponentType>().LookupComponentForWrite(e), this);
+                }
+            }
+            else
+            {
+                World::Unpack(e, handle);
+            }
+        }
+
+        template <typename... ViewTypes>
+        EntityView<ViewTypes...> View(uint32_t sinceTick = 0)
+        {
+            return EntityView<ViewTypes...>(GetChangeTick(), sinceTick, &entityMasks, GetViewManager<typename ViewTerm<ViewTypes>::StoredType>()...);
+        }
+
+    private:
+        static constexpr bool HasUniqueFamilies()
+        {
+            const int families[] = { ComponentFamilyTraits<ComponentTypes>::Family... };
+            for (size_t i = 0; i < sizeof...(ComponentTypes); i++)
+            {
+                for (size_t j = i + 1; j < sizeof...(ComponentTypes); j++)
+                {
+                    if (families[i] == families[j])
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        //One argument per manager of the tuple: they all allocate from the world's arena.
+        template <typename ComponentType>
+        PageAllocator& GetPageAllocator() { return arena; }
+
+        //Lets the World reach the managers too, for whatever only knows families (destroying entities, snapshots, Reset()...).
+        template <typename ComponentType>
+        void RegisterManager()
+        {
+            int family = ComponentFamilyTraits<ComponentType>::Family;
+            if (family >= static_cast<int>(componentManagers.size()))
+            {
+                componentManagers.resize(family + 1);
+            }
+
+            ComponentManager<ComponentType>& manager = GetManager<ComponentType>();
+            manager.SetChangeTickSource(&changeTick);
+            componentManagers[family] = &manager;
+        }
+
+        template <typename ComponentType>
+        ComponentManager<ComponentType>* GetViewManager()
+        {
+            if constexpr (Contains<ComponentType>)
+            {
+                return &GetManager<ComponentType>();
+            }
+            else
+            {
+                return World::GetViewManager<ComponentType>();
+            }
+        }
+
+        std::tuple<ComponentManager<ComponentTypes>...> managers;
+    };
+}
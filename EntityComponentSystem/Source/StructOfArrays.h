@@ -0,0 +1,155 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <array>
+#include <tuple>
+
+///==== Structure of Arrays Components ====
+
+///Component pools store whole structs one after the other, so a loop that only reads Position::x still pulls Position::y through the cache alongside it.
+///A component can instead declare its fields, in which case its pool stores every field in its own array: a page of Positions becomes PageSize x values followed by PageSize y values.
+///Each array starts on a cache line, and a loop over one of them is a plain walk over floats that the compiler can vectorize.
+
+///Fields are declared with a list of member pointers, at global scope, after the component:
+///struct Position : Component<Position> { float x, y; };
+///ECS_STRUCT_OF_ARRAYS(Position, &Position::x, &Position::y)
+
+///The component has to be trivially copyable, and its fields have to cover every one of its bytes (no padding, no undeclared member).
+///As a struct of arrays component is never stored whole, it cannot be handed out by reference: Unpack() does not compile for it.
+///EntityView::Each() still works, on a copy that is gathered from the fields before the callback and scattered back after it,
+///while EntityView::EachSpan() hands out the field arrays themselves (see FieldSpans), which is what the layout is for.
+///Archetype storage is unaffected: there, the component is stored whole, and EachSpan() gathers its fields.
+
+namespace EntitySystem
+{
+    //Specialized (through ECS_STRUCT_OF_ARRAYS) for the components stored as structure of arrays, with a tuple of member pointers named Fields.
+    template <typename ComponentType>
+    struct ComponentFields
+    {
+    };
+
+    template <typename ComponentType, typename = void>
+    struct HasComponentFields : std::false_type {};
+
+    template <typename ComponentType>
+    struct HasComponentFields<ComponentType, std::void_t<decltype(ComponentFields<ComponentType>::Fields)>> : std::true_type {};
+
+    template <typename ComponentType>
+    constexpr bool IsStructOfArrays = HasComponentFields<std::remove_const_t<ComponentType>>::value;
+
+    template <typename ComponentType, size_t... Indices>
+    constexpr std::array<size_t, sizeof...(Indices)> GetFieldSizes(std::index_sequence<Indices...>)
+    {
+        return { sizeof(std::remove_reference_t<decltype(std::declval<ComponentType&>().*std::get<Indices>(ComponentFields<ComponentType>::Fields))>)... };
+    }
+
+    //Where every field array starts within a page of "pageSize" components, the arrays being back to back. The last entry is the size of the whole page.
+    template <size_t Count>
+    constexpr std::array<size_t, Count + 1> GetFieldArrayOffsets(const std::array<size_t, Count>& sizes, size_t pageSize)
+    {
+        std::array<size_t, Count + 1> offsets = {};
+        for (size_t field = 0; field < Count; field++)
+        {
+            offsets[field + 1] = offsets[field] + sizes[field] * pageSize;
+        }
+        return offsets;
+    }
+
+    //Compile time helpers over the declared fields of a component.
+    template <typename ComponentType>
+    struct FieldList
+    {
+        using FieldTuple = std::remove_const_t<decltype(ComponentFields<ComponentType>::Fields)>;
+        static constexpr size_t Count = std::tuple_size_v<FieldTuple>;
+
+        template <size_t Index>
+        static constexpr auto Member = std::get<Index>(ComponentFields<ComponentType>::Fields);
+
+        template <size_t Index>
+        using FieldType = std::remove_reference_t<decltype(std::declval<ComponentType&>().*Member<Index>)>;
+
+        //The size of every field, in declaration order.
+        static constexpr std::array<size_t, Count> Sizes = GetFieldSizes<ComponentType>(std::make_index_sequence<Count>{});
+
+        //The position of a member pointer in the field list, or Count if it is not a declared field.
+        template <auto Field>
+        static constexpr size_t IndexOf() { return IndexOf<Field>(std::make_index_sequence<Count>{}); }
+
+        template <auto Field, size_t... Indices>
+        static constexpr size_t IndexOf(std::index_sequence<Indices...>)
+        {
+            const bool matches[] = { IsField<Indices>(Field)... };
+            for (size_t index = 0; index < Count; index++)
+            {
+                if (matches[index])
+                {
+                    return index;
+                }
+            }
+            return Count;
+        }
+
+        template <size_t Index, typename MemberPointer>
+        static constexpr bool IsField(MemberPointer field)
+        {
+            if constexpr (std::is_same_v<std::tuple_element_t<Index, FieldTuple>, MemberPointer>)
+            {
+                return Member<Index> == field;
+            }
+            return false;
+        }
+
+        //Calls function(std::integral_constant<size_t, Index>) for every field.
+        template <typename Function>
+        static void ForEach(Function&& function)
+        {
+            ForEach(function, std::make_index_sequence<Count>{});
+        }
+
+        template <typename Function, size_t... Indices>
+        static void ForEach(Function& function, std::index_sequence<Indices...>)
+        {
+            (function(std::integral_constant<size_t, Indices>{}), ...);
+        }
+    };
+
+    //The field arrays of a run of components, as handed out by EntityView::EachSpan(). Const components give const arrays.
+    //Position::x of the run is Get<&Position::x>()[0] up to Get<&Position::x>()[count - 1].
+    template <typename ComponentType>
+    class FieldSpans
+    {
+    public:
+        using StoredType = std::remove_const_t<ComponentType>;
+        using Fields = FieldList<StoredType>;
+        static_assert(IsStructOfArrays<StoredType>, "FieldSpans are only available for components declared with ECS_STRUCT_OF_ARRAYS.");
+
+        template <auto Field>
+        auto* Get() const
+        {
+            static_assert(Fields::template IndexOf<Field>() < Fields::Count, "The member is not a declared field of the component, see ECS_STRUCT_OF_ARRAYS.");
+            return GetField<Fields::template IndexOf<Field>()>();
+        }
+
+        template <size_t Index>
+        auto* GetField() const
+        {
+            using FieldType = typename Fields::template FieldType<Index>;
+            using Pointer = std::conditional_t<std::is_const_v<ComponentType>, const FieldType*, FieldType*>;
+            return static_cast<Pointer>(static_cast<void*>(arrays[Index]));
+        }
+
+        void SetField(size_t index, unsigned char* array) { arrays[index] = array; }
+
+    private:
+        std::array<unsigned char*, Fields::Count> arrays = {};
+    };
+}
+
+#define ECS_STRUCT_OF_ARRAYS(ComponentType, ...) \
+    namespace EntitySystem \
+    { \
+        template <> \
+        struct ComponentFields<ComponentType> \
+        { \
+            static constexpr auto Fields = std::make_tuple(__VA_ARGS__); \
+        }; \
+    }
@@ -1,5 +1,12 @@
 #include "ECSPrecompiledHeader.h"
 #include "System.h"
+#include "World.h"
+#include <typeinfo>
+#include <cmath>
+#ifdef __GNUG__
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
 
 namespace EntitySystem
 {
@@ -10,22 +17,140 @@ namespace EntitySystem
 
 	void System::RegisterEntity(const Entity& entity)
 	{
-		registeredEntities.push_back(entity);
+		registeredEntities.Insert(entity);
+		OnEntityRegistered(entity);
+	}
+
+	void System::RegisterEntities(const Entity* entities, size_t count)
+	{
+		registeredEntities.InsertNew(entities, count);
+		for (size_t i = 0; i < count; i++)
+		{
+			OnEntityRegistered(entities[i]);
+		}
 	}
 
 	void System::UnregisterEntity(const Entity& entity)
 	{
-		for (auto it = registeredEntities.begin(); it != registeredEntities.end(); ++it)
+		registeredEntities.Remove(entity);
+		OnEntityUnregistered(entity);
+	}
+
+	std::string System::GetName() const
+	{
+		const char* name = typeid(*this).name();
+#ifdef __GNUG__
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+		if (status == 0 && demangled)
 		{
-			Entity entity = *it;
-			if (entity.entityID == entity.entityID)
-			{
-				registeredEntities.erase(it);
-				return;
-			}
+			std::string result = demangled;
+			std::free(demangled);
+			return result;
 		}
+		return name;
+#else
+		//MSVC names are readable already, apart from their "class " prefix.
+		std::string result = name;
+		return result.compare(0, 6, "class ") == 0 ? result.substr(6) : result;
+#endif
 	}
 
 	ComponentMask System::GetSignature() { return signature; }
+
+	void System::SetTickRate(double ticksPerSecond, unsigned int maximumTicks)
+	{
+		assert(ticksPerSecond > 0.0 && maximumTicks > 0);
+		ClearTickRate();
+		fixedStep = std::max<int64_t>(1, std::llround(1000000.0 / ticksPerSecond));
+		maximumTicksPerFrame = maximumTicks;
+	}
+
+	void System::SetFrameInterval(unsigned int frames, unsigned int phase)
+	{
+		assert(frames > 0 && phase < frames);
+		ClearTickRate();
+		frameInterval = frames;
+		framePhase = phase;
+	}
+
+	void System::ClearTickRate()
+	{
+		fixedStep = 0;
+		accumulator = 0;
+		maximumTicksPerFrame = 1;
+		frameInterval = 1;
+		framePhase = 0;
+		frameCounter = 0;
+		elapsedTime = 0;
+	}
+
+	void System::SetTimeSlices(unsigned int slices)
+	{
+		assert(slices > 0);
+		timeSlices = slices;
+		currentSlice = 0;
+	}
+
+	unsigned int System::AdvanceClock(int deltaTime, int& tickTime)
+	{
+		if (fixedStep > 0)
+		{
+			accumulator += static_cast<int64_t>(deltaTime) * 1000;
+			int64_t ticks = accumulator / fixedStep;
+			accumulator -= ticks * fixedStep;
+
+			tickTime = static_cast<int>((fixedStep + 500) / 1000);
+			return static_cast<unsigned int>(std::min<int64_t>(ticks, maximumTicksPerFrame));
+		}
+
+		elapsedTime += deltaTime;
+		if (frameCounter++ % frameInterval != framePhase)
+		{
+			return 0;
+		}
+
+		tickTime = elapsedTime;
+		elapsedTime = 0;
+		return 1;
+	}
+
+	CommandBuffer& System::Commands() { return parentWorld->GetCommandBuffer(); }
+
+	void System::RunAfter(System* other)
+	{
+		runAfter.push_back(other);
+	}
+
+	void System::RunBefore(System* other)
+	{
+		other->runAfter.push_back(this);
+	}
+
+	ComponentMask System::GetReadMask() { return readMask; }
+
+	ComponentMask System::GetWriteMask()
+	{
+		//Without any declarations, we have to assume the worst: every component the system pays attention to may be written.
+		if (readMask.IsEmpty() && writeMask.IsEmpty())
+		{
+			return signature;
+		}
+		return writeMask;
+	}
+
+	bool System::ConflictsWith(System& other)
+	{
+		ComponentMask writes = GetWriteMask();
+		ComponentMask otherWrites = other.GetWriteMask();
+
+		//Nothing is known about what these systems touch.
+		if ((writes.IsEmpty() && readMask.IsEmpty()) || (otherWrites.IsEmpty() && other.readMask.IsEmpty()))
+		{
+			return true;
+		}
+
+		return writes.Intersects(otherWrites | other.readMask) || otherWrites.Intersects(readMask);
+	}
 }
 
@@ -1,8 +1,8 @@
 #pragma once
 #include "ECSPrecompiledHeader.h"
 #include "Entity.h"
-#include "World.h"
 #include "ComponentMask.h"
+#include "EntitySet.h"
 
 ///==== System ====
 ///A system is a self contained unit of game functionality. Generally, systems run their logic on every game update.
@@ -14,6 +14,7 @@
 namespace EntitySystem
 {
 	class World;
+	class CommandBuffer;
 	class System
 	{
 	public:
@@ -32,20 +33,127 @@ namespace EntitySystem
 		virtual void Update(int deltaTime) {};
 		virtual void Render() {};
 
+		//The name the profiler reports the system under. Defaults to the class name.
+		virtual std::string GetName() const;
+
+		//Called once an entity has started or stopped matching the signature (registeredEntities is already up to date), for systems that keep their own data per entity.
+		virtual void OnEntityRegistered(Entity entity) {};
+		virtual void OnEntityUnregistered(Entity entity) {};
+
+		//Called by World::Reset(), once every entity is gone, instead of unregistering them one by one.
+		virtual void OnReset() {};
+
 		//When a system is added to the world, the world will register itself.
 		void RegisterWorld(World* world);
 
 		//When a component is added such that this system should begin acting on it, register will be called.
+		//Both registering and unregistering are O(1), as registeredEntities is a sparse set.
 		void RegisterEntity(const Entity& entity);
 		
+		//Bulk RegisterEntity() for entities that were just created (see World::Instantiate()).
+		void RegisterEntities(const Entity* entities, size_t count);
+
 		//If a component is removed from an entity such that the system should stop acting on it, unregister will be called.
 		void UnregisterEntity(const Entity& entity);
 
 		ComponentMask GetSignature();
 
+		//Calls function(components&...) or function(entity, components&...) for every entity in the world that has all of the given components.
+		//This is usually the signature of the system, and is much faster than looping over registeredEntities and calling Unpack().
+		//Defined in World.h, as it needs the full World definition.
+		template <typename... ComponentTypes, typename Function>
+		void Each(Function&& function);
+
+		//Same as Each(), but spreads the entities over the world's job system. The function may only write to the components it is handed for the current entity.
+		template <typename... ComponentTypes, typename Function>
+		void ParallelEach(Function&& function, unsigned int minimumBatchSize = 256);
+
+		//Runs the function over the field arrays of structure of arrays components, a run of entities at a time (see EntityView::EachSpan()).
+		template <typename... ComponentTypes, typename Function>
+		void EachSpan(Function&& function);
+
+		//Same as Each(), but only visits the current time slice of the entities (see SetTimeSlices()), so that every entity is visited once over that many updates.
+		//Changed<> and Added<> filters only see what happened since the previous update, so entities outside of the slice miss their changes.
+		template <typename... ComponentTypes, typename Function>
+		void EachSlice(Function&& function);
+
+		//==== Tick Rates ====
+		//By default, a system is updated on every World::Update(), with the frame's delta time.
+		//A system with a tick rate is updated with a fixed step instead: the frame times add up in an accumulator, and the system is updated once per whole step in it,
+		//which may be several times or not at all in a given frame. At most maximumTicksPerFrame steps are taken per frame, and the time beyond them is dropped, so that a slow frame cannot snowball.
+		//The step is handed to Update() in whole milliseconds, GetFixedStep() has it exactly.
+		void SetTickRate(double ticksPerSecond, unsigned int maximumTicksPerFrame = 4);
+
+		//Updates the system on one frame out of "frames" only, with the time elapsed since its previous update. Systems with the same interval can be spread over frames with different phases.
+		void SetFrameInterval(unsigned int frames, unsigned int phase = 0);
+
+		//Back to an update every frame.
+		void ClearTickRate();
+
+		//Splits the entities EachSlice() visits into that many parts, one of which is visited per update, in turn.
+		void SetTimeSlices(unsigned int slices);
+		unsigned int GetTimeSlice() const { return currentSlice; }
+		unsigned int GetTimeSliceCount() const { return timeSlices; }
+
+		//In seconds, or 0 for systems without a tick rate.
+		double GetFixedStep() const { return fixedStep / 1000000.0; }
+
+		//How far the time left in the accumulator goes into the next step, from 0 to 1. Render() blends the state of the last two steps with it, so that motion stays smooth
+		//when the tick rate and the frame rate differ. Always 1 for systems without a tick rate.
+		float GetInterpolationAlpha() const { return fixedStep > 0 ? static_cast<float>(static_cast<double>(accumulator) / fixedStep) : 1.0f; }
+
+		//==== Scheduling ====
+		//Systems that work on different components can be updated on different threads at the same time. To know which ones can, systems declare which components they read and write.
+		//A system that declares nothing is assumed to write every component of its signature, and a system without a signature or declarations is always updated on its own.
+		//Systems whose accesses conflict are updated in the order they were added to the world, unless RunAfter()/RunBefore() say otherwise.
+
+		void RunAfter(System* other);
+		void RunBefore(System* other);
+		const std::vector<System*>& GetRunAfter() const { return runAfter; }
+
+		ComponentMask GetReadMask();
+		ComponentMask GetWriteMask();
+
+		//Returns true if the two systems may not be updated at the same time.
+		bool ConflictsWith(System& other);
+
+		//The change tick at which the system last finished updating. Changed<> and Added<> filters in Each() let through what happened after it (see View.h).
+		uint32_t GetLastChangeTick() const { return lastChangeTick; }
+
 	protected:
-		std::vector<Entity> registeredEntities;
+		template <typename ComponentType>
+		void Reads() { readMask.AddComponent<ComponentType>(); }
+
+		template <typename ComponentType>
+		void Writes() { writeMask.AddComponent<ComponentType>(); }
+
+		EntitySet registeredEntities;
 		World* parentWorld;
 		ComponentMask signature;
+		ComponentMask readMask;
+		ComponentMask writeMask;
+		std::vector<System*> runAfter;
+
+		//The command buffer of the thread running this system. Adding or removing components and destroying entities during Update() should go through it.
+		CommandBuffer& Commands();
+
+	private:
+		//Only the world advances lastChangeTick, once the system has finished updating.
+		friend class World;
+		uint32_t lastChangeTick = 0;
+
+		//Adds the frame time to the system's clock, and returns how many times the system has to be updated this frame, with which delta time.
+		unsigned int AdvanceClock(int deltaTime, int& tickTime);
+
+		//Times are in microseconds, so that steps such as 1/60th of a second do not drift.
+		int64_t fixedStep = 0;
+		int64_t accumulator = 0;
+		unsigned int maximumTicksPerFrame = 1;
+		unsigned int frameInterval = 1;
+		unsigned int framePhase = 0;
+		unsigned int frameCounter = 0;
+		int elapsedTime = 0;
+		unsigned int timeSlices = 1;
+		unsigned int currentSlice = 0;
 	};
 }
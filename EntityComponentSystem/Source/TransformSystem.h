@@ -0,0 +1,187 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <algorithm>
+#include "Hierarchy.h"
+#include "System.h"
+#include "World.h"
+
+///==== Transform Propagation ====
+
+///Composes the world transform of every entity of a hierarchy (see Hierarchy.h) from its local transform and the world transform of its parent.
+///TransformSystem<Matrix> works with any transform type whose composition is written parent * local, and updates WorldTransform<Matrix> from LocalTransform<Matrix>.
+///Only entities with a Hierarchy and both transform components are updated, roots included: an entity outside of any hierarchy is given a default Hierarchy() to be transformed.
+///A child whose parent has no transform is treated as a root.
+
+///Instead of chasing parent links, the system owns a group over Hierarchy and both transforms (see ComponentGroup.h) and keeps it sorted by depth:
+///parents then always come before their children, and propagation is a single pass over three parallel arrays, reaching the parent's world transform by an instance cached at sort time.
+///The sort only happens when the group or the hierarchy changed structurally. Only dirty subtrees are recomputed: a world transform is only written (and stamped as changed)
+///when the local transform changed since the system's last update, or when its parent's was recomputed. Entities of the same depth never depend on each other,
+///so large depth levels are spread over the world's job system.
+
+///As the group takes over the order of the Hierarchy pool, only one TransformSystem can be added to a world, and only with StorageMode::ComponentPools.
+
+namespace EntitySystem
+{
+    template <typename TransformType>
+    struct LocalTransform : Component<LocalTransform<TransformType>>
+    {
+        LocalTransform() = default;
+        LocalTransform(const TransformType& value) : value(value) {}
+        TransformType value = {};
+    };
+
+    template <typename TransformType>
+    struct WorldTransform : Component<WorldTransform<TransformType>>
+    {
+        WorldTransform() = default;
+        WorldTransform(const TransformType& value) : value(value) {}
+        TransformType value = {};
+    };
+
+    template <typename TransformType>
+    class TransformSystem : public System
+    {
+    public:
+        using Local = LocalTransform<TransformType>;
+        using Global = WorldTransform<TransformType>;
+        using TransformGroup = GroupView<const Hierarchy, const Local, Global>;
+
+        //Depth levels with fewer entities than twice the batch size are propagated on the updating thread.
+        explicit TransformSystem(unsigned int minimumBatchSize = 1024) : minimumBatchSize(minimumBatchSize)
+        {
+            signature.AddComponent<Hierarchy>();
+            signature.AddComponent<Local>();
+            signature.AddComponent<Global>();
+
+            //Sorting moves the components of all three pools around, so nothing else may read them meanwhile.
+            Writes<Hierarchy>();
+            Writes<Local>();
+            Writes<Global>();
+        }
+
+        void Initialize() override
+        {
+            parentWorld->template Group<const Hierarchy, const Local, Global>();
+        }
+
+        void Update(int deltaTime) override
+        {
+            TransformGroup group = parentWorld->template Group<const Hierarchy, const Local, Global>();
+
+            bool sorted = group.GetGroup().GetVersion() == groupVersion && parentWorld->GetHierarchyVersion() == hierarchyVersion;
+            if (!sorted)
+            {
+                Sort(group);
+            }
+            Propagate(group, !sorted);
+        }
+
+        //Number of world transforms written by the last update.
+        unsigned int GetUpdatedCount() const { return updatedCount; }
+
+    private:
+        void Sort(TransformGroup& group)
+        {
+            ComponentManager<Hierarchy>* hierarchies = group.template GetManager<Hierarchy>();
+            unsigned int size = group.GetSize();
+
+            //Stable, so entities of the same depth keep their relative order from one sort to the next and the pools are not shuffled for nothing.
+            std::vector<std::pair<unsigned int, Entity>> keys(size);
+            for (ComponentInstance instance = 1; instance <= size; instance++)
+            {
+                keys[instance - 1] = { hierarchies->GetComponent(instance).depth, hierarchies->GetEntities()[instance] };
+            }
+            std::stable_sort(keys.begin(), keys.end(), [](const auto& l, const auto& r) { return l.first < r.first; });
+
+            std::vector<Entity> members(size);
+            std::transform(keys.begin(), keys.end(), members.begin(), [](const auto& key) { return key.second; });
+            group.GetGroup().Reorder(members);
+
+            parentInstances.assign(size + 1, 0);
+            levelStarts.clear();
+            unsigned int depth = ~0u;
+            for (ComponentInstance instance = 1; instance <= size; instance++)
+            {
+                const Hierarchy& node = hierarchies->GetComponent(instance);
+                if (node.depth != depth)
+                {
+                    levelStarts.push_back(instance);
+                    depth = node.depth;
+                }
+
+                ComponentInstance parent = node.parent != Entity() ? hierarchies->FindInstance(node.parent) : 0;
+                parentInstances[instance] = parent <= size ? parent : 0;
+            }
+            levelStarts.push_back(size + 1);
+
+            groupVersion = group.GetGroup().GetVersion();
+            hierarchyVersion = parentWorld->GetHierarchyVersion();
+        }
+
+        void Propagate(TransformGroup& group, bool everything)
+        {
+            dirty.assign(group.GetSize() + 1, 0);
+            std::atomic<unsigned int> updated{ 0 };
+            JobSystem& jobs = parentWorld->GetJobSystem();
+
+            for (size_t level = 0; level + 1 < levelStarts.size(); level++)
+            {
+                ComponentInstance first = levelStarts[level];
+                ComponentInstance end = levelStarts[level + 1];
+                if (jobs.GetWorkerCount() == 0 || end - first < 2 * minimumBatchSize)
+                {
+                    updated += PropagateRange(group, first, end, everything);
+                    continue;
+                }
+
+                //Every level has to be done before the next one starts, as it reads the world transforms of this one.
+                JobCounter counter;
+                for (ComponentInstance batch = first; batch < end; batch += minimumBatchSize)
+                {
+                    ComponentInstance batchEnd = std::min(batch + minimumBatchSize, end);
+                    jobs.Submit([this, &group, &updated, batch, batchEnd, everything]() { updated += PropagateRange(group, batch, batchEnd, everything); }, counter);
+                }
+                jobs.Wait(counter);
+            }
+            updatedCount = updated;
+        }
+
+        unsigned int PropagateRange(TransformGroup& group, ComponentInstance first, ComponentInstance end, bool everything)
+        {
+            ComponentManager<Local>* locals = group.template GetManager<Local>();
+            ComponentManager<Global>* globals = group.template GetManager<Global>();
+            const uint32_t* localVersions = locals->GetChangedVersions();
+            uint32_t sinceTick = GetLastChangeTick();
+            uint32_t tick = parentWorld->GetChangeTick();
+
+            unsigned int updated = 0;
+            for (ComponentInstance instance = first; instance < end; instance++)
+            {
+                ComponentInstance parent = parentInstances[instance];
+                if (!everything && localVersions[instance] <= sinceTick && !(parent && dirty[parent]))
+                {
+                    continue;
+                }
+
+                const TransformType& local = locals->GetComponent(instance).value;
+                globals->GetComponent(instance).value = parent ? globals->GetComponent(parent).value * local : local;
+                globals->MarkChanged(instance, tick);
+                dirty[instance] = 1;
+                updated++;
+            }
+            return updated;
+        }
+
+        unsigned int minimumBatchSize;
+        uint32_t groupVersion = ~0u;
+        uint32_t hierarchyVersion = ~0u;
+        unsigned int updatedCount = 0;
+
+        //Indexed by instance, and only valid while the group is sorted.
+        std::vector<ComponentInstance> parentInstances;
+        std::vector<unsigned char> dirty;
+
+        //The first instance of every depth level, followed by the end of the group.
+        std::vector<ComponentInstance> levelStarts;
+    };
+}
@@ -0,0 +1,875 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include <numeric>
+#include <tuple>
+#include <utility>
+#include "Entity.h"
+#include "ComponentManager.h"
+#include "Archetype.h"
+#include "JobSystem.h"
+
+///==== Views ====
+
+///Iterating with World::Unpack() is convenient, but it looks up the component manager and the entity map for every component of every entity, every frame.
+///A view resolves its component managers once, and then drives the iteration from the smallest of the pools: every other pool only needs one O(1) sparse lookup per entity.
+///The callback receives direct references to the components (optionally preceded by the entity), so no ComponentHandle is ever constructed.
+
+///Components that are only read should be requested as const (View<const Position, Velocity>), which hands out const references.
+
+///When the world uses StorageMode::Archetypes, the view walks the matching chunks instead, where every column is already contiguous.
+
+///Components stored as structure of arrays (see StructOfArrays.h) are handed to Each() as a copy gathered from their fields, and scattered back unless const.
+///EachSpan() hands out their field arrays instead, a run of entities at a time, for loops that the compiler can vectorize.
+
+///==== Change Filters ====
+
+///Every component handed out by a view as non-const is stamped with the world's current tick, whether or not the callback ends up writing to it.
+///Wrapping a component in Changed<> or Added<> (View<Changed<const Transform>, RenderProxy>) only lets through the entities whose component was stamped,
+///or added, after the view's "since" tick. System::Each() uses the tick at which the system last finished updating, so a system sees every change made since its previous update.
+///Whole pages (or chunks) whose highest version is not newer than the since tick are skipped without looking at their components.
+///When a view has filters, iteration is always driven by a filtered component, so that the page skipping applies.
+
+///==== Tags ====
+
+///Tags (see Component.h) have no pool to drive the iteration or to look the entity up in: with StorageMode::ComponentPools, the view tests their bit in the entity's mask instead.
+///Every tag is handed to the callback as the same instance, and is never stamped as changed. A view needs at least one component that is not a tag.
+
+namespace EntitySystem
+{
+    template <typename ComponentType>
+    struct Changed {};
+
+    template <typename ComponentType>
+    struct Added {};
+
+    enum class ViewFilter
+    {
+        None,
+        Changed,
+        Added
+    };
+
+    //Unwraps the filters of a view's component list.
+    template <typename Term>
+    struct ViewTerm
+    {
+        using Type = Term;                              //What the callback receives a reference to. Const when the component is only read.
+        using StoredType = std::remove_const_t<Term>;
+        static constexpr ViewFilter Filter = ViewFilter::None;
+    };
+
+    template <typename ComponentType>
+    struct ViewTerm<Changed<ComponentType>> : ViewTerm<ComponentType>
+    {
+        static constexpr ViewFilter Filter = ViewFilter::Changed;
+    };
+
+    template <typename ComponentType>
+    struct ViewTerm<Added<ComponentType>> : ViewTerm<ComponentType>
+    {
+        static constexpr ViewFilter Filter = ViewFilter::Added;
+    };
+
+    template <typename... ComponentTypes>
+    class EntityView
+    {
+    public:
+        static_assert(sizeof...(ComponentTypes) > 0, "A view needs at least one component type.");
+        static_assert((!IsTagComponent<typename ViewTerm<ComponentTypes>::StoredType> || ...), "A view needs at least one component that is not a tag.");
+        static_assert(((!IsTagComponent<typename ViewTerm<ComponentTypes>::StoredType> || ViewTerm<ComponentTypes>::Filter == ViewFilter::None) && ...), "Tags have no versions to filter on.");
+
+        //changeTick is the tick components handed out for writing are stamped with, and sinceTick the tick the filters compare against.
+        //The managers of tags are nullptr, and their bits are looked up in entityMasks, indexed by entity index.
+        EntityView(uint32_t changeTick, uint32_t sinceTick, const std::vector<ComponentMask>* entityMasks, ComponentManager<typename ViewTerm<ComponentTypes>::StoredType>*... managers)
+            : managers(managers...), archetypes(nullptr), entityMasks(entityMasks), changeTick(changeTick), sinceTick(sinceTick) {}
+        EntityView(uint32_t changeTick, uint32_t sinceTick, ArchetypeStorage* archetypes) : archetypes(archetypes), changeTick(changeTick), sinceTick(sinceTick) {}
+
+        //Calls function(components&...) or function(entity, components&...) for every entity that has all of the view's components.
+        template <typename Function>
+        void Each(Function&& function)
+        {
+            if (archetypes)
+            {
+                ComponentMask signature = GetSignature();
+                archetypes->ForEachMatchingChunk(signature, [this, &function](Archetype& archetype, ArchetypeChunk& chunk)
+                {
+                    EachInChunk(function, archetype, chunk, std::index_sequence_for<ComponentTypes...>{});
+                });
+                return;
+            }
+
+            size_t driver = FindDriver();
+            ForEachIndex([&](auto index)
+            {
+                if constexpr (!IsTag<decltype(index)::value>)
+                {
+                    if (decltype(index)::value == driver)
+                    {
+                        EachDrivenBy<decltype(index)::value>(function, 1, GetManager<decltype(index)::value>()->GetSize() + 1, std::index_sequence_for<ComponentTypes...>{});
+                    }
+                }
+            });
+        }
+
+        //Same as Each(), but only visits the part "slice" out of "sliceCount" of the entities, so that visiting every slice in turn visits every entity once.
+        //Slices are contiguous ranges of the driving pool, or every sliceCount-th chunk with archetypes, so a slice costs about its share of a whole pass.
+        //Entities added or removed between two slices may move from one slice to another, and be visited twice or not at all during that round.
+        template <typename Function>
+        void EachSlice(Function&& function, unsigned int slice, unsigned int sliceCount)
+        {
+            assert(slice < sliceCount);
+            if (archetypes)
+            {
+                ComponentMask signature = GetSignature();
+                unsigned int chunkIndex = 0;
+                archetypes->ForEachMatchingChunk(signature, [this, &function, &chunkIndex, slice, sliceCount](Archetype& archetype, ArchetypeChunk& chunk)
+                {
+                    if (chunkIndex++ % sliceCount == slice)
+                    {
+                        EachInChunk(function, archetype, chunk, std::index_sequence_for<ComponentTypes...>{});
+                    }
+                });
+                return;
+            }
+
+            size_t driver = FindDriver();
+            ForEachIndex([&](auto index)
+            {
+                if constexpr (!IsTag<decltype(index)::value>)
+                {
+                    if (decltype(index)::value == driver)
+                    {
+                        uint64_t size = GetManager<decltype(index)::value>()->GetSize();
+                        ComponentInstance first = static_cast<ComponentInstance>(1 + size * slice / sliceCount);
+                        ComponentInstance last = static_cast<ComponentInstance>(1 + size * (slice + 1) / sliceCount);
+                        EachDrivenBy<decltype(index)::value>(function, first, last, std::index_sequence_for<ComponentTypes...>{});
+                    }
+                }
+            });
+        }
+
+        //Calls function(count, spans...) or function(count, entities, spans...) for runs of up to SpanSize matching entities, with one FieldSpans per component (see StructOfArrays.h).
+        //Every component of the view has to be declared with ECS_STRUCT_OF_ARRAYS. Each run lies within one page of the driving pool.
+        //Components the run finds at consecutive instances of their pool, which is the case for entities that were given their components in the same order, are handed out straight from their pages.
+        //The other ones are gathered into scratch arrays, and scattered back after the callback unless they are const. Non-const components are stamped as changed, as with Each().
+        template <typename Function>
+        void EachSpan(Function&& function)
+        {
+            static_assert((IsStructOfArrays<typename ViewTerm<ComponentTypes>::StoredType> && ...), "EachSpan() needs every component of the view to be declared with ECS_STRUCT_OF_ARRAYS.");
+
+            if (archetypes)
+            {
+                ComponentMask signature = GetSignature();
+                archetypes->ForEachMatchingChunk(signature, [this, &function](Archetype& archetype, ArchetypeChunk& chunk)
+                {
+                    SpansInChunk(function, archetype, chunk, std::index_sequence_for<ComponentTypes...>{});
+                });
+                return;
+            }
+
+            size_t driver = FindDriver();
+            ForEachIndex([&](auto index)
+            {
+                if (decltype(index)::value == driver)
+                {
+                    SpansDrivenBy<decltype(index)::value>(function, std::index_sequence_for<ComponentTypes...>{});
+                }
+            });
+        }
+
+        //The most entities EachSpan() hands out at once.
+        static constexpr unsigned int SpanSize = 256;
+
+        //Same as Each(), but splits the entities into batches that are processed concurrently on the job system.
+        //The callback is called from several threads at once, so it may only write to the components it is handed for the current entity.
+        //Batches never hold less than minimumBatchSize entities, so small views are not split into jobs that cost more to schedule than to run.
+        template <typename Function>
+        void ParallelEach(JobSystem& jobs, Function&& function, unsigned int minimumBatchSize = 256)
+        {
+            JobCounter counter;
+
+            if (archetypes)
+            {
+                //Chunks are already cache-line aligned blocks of entities, so every chunk is a natural batch.
+                ComponentMask signature = GetSignature();
+                archetypes->ForEachMatchingChunk(signature, [this, &function, &jobs, &counter](Archetype& archetype, ArchetypeChunk& chunk)
+                {
+                    jobs.Submit([this, &function, &archetype, &chunk]() { EachInChunk(function, archetype, chunk, std::index_sequence_for<ComponentTypes...>{}); }, counter);
+                });
+                jobs.Wait(counter);
+                return;
+            }
+
+            size_t driver = FindDriver();
+            ForEachIndex([&](auto index)
+            {
+                constexpr size_t Driver = decltype(index)::value;
+                if constexpr (!IsTag<Driver>)
+                {
+                    if (Driver != driver)
+                    {
+                        return;
+                    }
+
+                    using DriverType = typename Term<Driver>::StoredType;
+                    ComponentInstance end = GetManager<Driver>()->GetSize() + 1;
+                    unsigned int batchSize = GetBatchSize<DriverType>(end, jobs.GetWorkerCount() + 1, minimumBatchSize);
+
+                    //Batch boundaries are multiples of the batch size, and thus start on a cache line of the driving pool, so no two batches write to the same line of it.
+                    for (ComponentInstance first = 0; first < end; first += batchSize)
+                    {
+                        ComponentInstance last = std::min(first + batchSize, end);
+                        jobs.Submit([this, &function, first, last]() { EachDrivenBy<Driver>(function, std::max(first, 1u), last, std::index_sequence_for<ComponentTypes...>{}); }, counter);
+                    }
+                }
+                jobs.Wait(counter);
+            });
+        }
+
+    private:
+        template <size_t Index>
+        using Term = ViewTerm<std::tuple_element_t<Index, std::tuple<ComponentTypes...>>>;
+
+        template <size_t Index>
+        static constexpr bool IsTag = IsTagComponent<typename Term<Index>::StoredType>;
+
+        static constexpr bool HasFilters = ((ViewTerm<ComponentTypes>::Filter != ViewFilter::None) || ...);
+        static constexpr bool HasStructOfArrays = (IsStructOfArrays<typename ViewTerm<ComponentTypes>::StoredType> || ...);
+
+        //How Each() hands a component to the callback: by reference, or as a gathered copy for structure of arrays components.
+        template <size_t Index>
+        using Access = std::conditional_t<IsStructOfArrays<typename Term<Index>::StoredType>, typename Term<Index>::Type, typename Term<Index>::Type&>;
+
+        //Where EachSpan() gathers the fields of a component that cannot be handed out straight from its pages: one array of SpanSize values per field.
+        template <typename ComponentType>
+        struct SpanScratch
+        {
+            static constexpr auto FieldOffsets = GetFieldArrayOffsets(FieldList<ComponentType>::Sizes, SpanSize);
+            alignas(CacheLineSize) unsigned char bytes[SpanSize * sizeof(ComponentType)];
+
+            template <size_t Field>
+            typename FieldList<ComponentType>::template FieldType<Field>* GetFieldArray() { return reinterpret_cast<typename FieldList<ComponentType>::template FieldType<Field>*>(bytes + FieldOffsets[Field]); }
+        };
+
+        static ComponentMask GetSignature()
+        {
+            ComponentMask signature;
+            (signature.AddComponent<typename ViewTerm<ComponentTypes>::StoredType>(), ...);
+            return signature;
+        }
+
+        template <size_t Index>
+        auto* GetManager() { return std::get<Index>(managers); }
+
+        //The smallest pool bounds the number of entities that can possibly match, so iteration is driven from it.
+        //With filters, only the filtered pools are candidates, as their page versions let whole pages be skipped.
+        size_t FindDriver()
+        {
+            size_t driver = sizeof...(ComponentTypes);
+            unsigned int smallest = 0;
+            ForEachIndex([&](auto index)
+            {
+                constexpr size_t Index = decltype(index)::value;
+                if (IsTag<Index> || (HasFilters && Term<Index>::Filter == ViewFilter::None))
+                {
+                    return;
+                }
+
+                unsigned int size = GetSize<Index>();
+                if (driver == sizeof...(ComponentTypes) || size < smallest)
+                {
+                    smallest = size;
+                    driver = Index;
+                }
+            });
+            return driver;
+        }
+
+        template <size_t Index>
+        unsigned int GetSize()
+        {
+            if constexpr (IsTag<Index>)
+            {
+                return 0;
+            }
+            else
+            {
+                return GetManager<Index>()->GetSize();
+            }
+        }
+
+        //The instance of the entity's component, or 0 if it does not have it. Tags have no instance, and are found at 1 when the entity has them.
+        template <size_t Index>
+        ComponentInstance FindInstance(Entity entity)
+        {
+            if constexpr (IsTag<Index>)
+            {
+                return (*entityMasks)[entity.Index()].HasFamily(GetComponentFamily<typename Term<Index>::StoredType>()) ? 1 : 0;
+            }
+            else
+            {
+                return GetManager<Index>()->GetInstance(entity);
+            }
+        }
+
+        //The version a filter compares against, for a single instance or for a whole page of the pool.
+        template <size_t Index>
+        uint32_t GetVersion(ComponentInstance instance)
+        {
+            return Term<Index>::Filter == ViewFilter::Added ? GetManager<Index>()->GetAddedVersion(instance) : GetManager<Index>()->GetChangedVersion(instance);
+        }
+
+        template <size_t Index>
+        uint32_t GetPageVersion(unsigned int page)
+        {
+            return Term<Index>::Filter == ViewFilter::Added ? GetManager<Index>()->GetPageAddedVersion(page) : GetManager<Index>()->GetPageChangedVersion(page);
+        }
+
+        template <size_t Index>
+        bool PassesFilter(ComponentInstance instance)
+        {
+            return Term<Index>::Filter == ViewFilter::None || GetVersion<Index>(instance) > sinceTick;
+        }
+
+        template <size_t Index>
+        void MarkWritten(ComponentInstance instance)
+        {
+            if constexpr (!std::is_const_v<typename Term<Index>::Type> && !IsTag<Index>)
+            {
+                GetManager<Index>()->MarkChanged(instance, changeTick);
+            }
+        }
+
+        template <size_t Index>
+        static uint32_t GetChunkVersion(Archetype& archetype, ArchetypeChunk& chunk, int column)
+        {
+            return Term<Index>::Filter == ViewFilter::Added ? archetype.GetChunkAddedVersion(chunk, column) : archetype.GetChunkChangedVersion(chunk, column);
+        }
+
+        template <typename DriverType>
+        static unsigned int GetBatchSize(unsigned int count, unsigned int threadCount, unsigned int minimumBatchSize)
+        {
+            //A few batches per thread let work stealing even out batches that happen to hold fewer matching entities.
+            unsigned int batchSize = std::max(minimumBatchSize, count / (threadCount * 4) + 1);
+
+            //Rounded to the fewest components spanning a whole number of cache lines, lcm(Stride, CacheLineSize) / Stride, which is 8 for 24 byte components and 2 for 96 byte ones.
+            //Pages start on a cache line and, with the default 1024 components per page, hold a whole number of such runs, so every batch then starts on one too.
+            //The field arrays of structure of arrays components can be as narrow as a byte per component.
+            constexpr size_t Stride = IsStructOfArrays<DriverType> ? 1 : sizeof(DriverType);
+            constexpr unsigned int BatchAlignment = static_cast<unsigned int>(CacheLineSize / std::gcd(Stride, CacheLineSize));
+            return (batchSize + BatchAlignment - 1) / BatchAlignment * BatchAlignment;
+        }
+
+        template <typename Function>
+        static void ForEachIndex(Function&& function)
+        {
+            ForEachIndex(function, std::index_sequence_for<ComponentTypes...>{});
+        }
+
+        template <typename Function, size_t... Indices>
+        static void ForEachIndex(Function& function, std::index_sequence<Indices...>)
+        {
+            (function(std::integral_constant<size_t, Indices>{}), ...);
+        }
+
+        template <typename Function, typename... Arguments>
+        static void Invoke(Function& function, Entity entity, Arguments&... components)
+        {
+            if constexpr (std::is_invocable_v<Function&, Entity, Arguments&...>)
+            {
+                function(entity, components...);
+            }
+            else
+            {
+                function(components...);
+            }
+        }
+
+        //Visits the instances [first, last) of the driving pool.
+        template <size_t Driver, typename Function, size_t... Indices>
+        void EachDrivenBy(Function& function, ComponentInstance first, ComponentInstance last, std::index_sequence<Indices...>)
+        {
+            auto* driverManager = std::get<Driver>(managers);
+            constexpr unsigned int PageSize = std::remove_pointer_t<decltype(driverManager)>::PageSize;
+            const Entity* entities = driverManager->GetEntities();
+            constexpr bool WritesDriver = !std::is_const_v<typename Term<Driver>::Type>;
+            uint32_t* driverVersions = driverManager->GetChangedVersions();
+
+            //The driving pool is walked page by page, so its components are a plain linear walk. Every other pool is reached through its sparse map.
+            while (first < last)
+            {
+                unsigned int page = first / PageSize;
+                auto* components = GetComponentPage<Driver>(page);
+                ComponentInstance pageStart = page * PageSize;
+                ComponentInstance pageEnd = std::min((page + 1) * PageSize, last);
+
+                if (Term<Driver>::Filter != ViewFilter::None && GetPageVersion<Driver>(page) <= sinceTick)
+                {
+                    first = pageEnd;
+                    continue;
+                }
+
+                bool pageWritten = false;
+                for (ComponentInstance instance = first; instance < pageEnd; instance++)
+                {
+                    Entity entity = entities[instance];
+                    ComponentInstance instances[] = { (Indices == Driver ? instance : FindInstance<Indices>(entity))... };
+
+                    bool matches = true;
+                    for (ComponentInstance other : instances)
+                    {
+                        matches &= other != 0;
+                    }
+
+                    if (matches && HasFilters)
+                    {
+                        matches = (PassesFilter<Indices>(instances[Indices]) && ...);
+                    }
+
+                    if (matches)
+                    {
+                        if constexpr (HasStructOfArrays)
+                        {
+                            std::tuple<Access<Indices>...> accessed(Fetch<Indices, Driver>(instances[Indices], components, instance - pageStart)...);
+                            Invoke(function, entity, std::get<Indices>(accessed)...);
+                            (StoreBack<Indices>(instances[Indices], std::get<Indices>(accessed)), ...);
+                        }
+                        else
+                        {
+                            Invoke(function, entity, Fetch<Indices, Driver>(instances[Indices], components, instance - pageStart)...);
+                        }
+                        ((Indices != Driver ? MarkWritten<Indices>(instances[Indices]) : void()), ...);
+
+                        //The driver's page version is stamped once for the whole page, below.
+                        if constexpr (WritesDriver)
+                        {
+                            driverVersions[instance] = changeTick;
+                            pageWritten = true;
+                        }
+                    }
+                }
+
+                if (pageWritten)
+                {
+                    driverManager->MarkPageChanged(page, changeTick);
+                }
+                first = pageEnd;
+            }
+        }
+
+        //The components of a page of the pool, or nullptr for structure of arrays components, which are not stored whole.
+        template <size_t Index>
+        auto* GetComponentPage(unsigned int page)
+        {
+            using StoredType = typename Term<Index>::StoredType;
+            if constexpr (IsStructOfArrays<StoredType>)
+            {
+                return static_cast<StoredType*>(nullptr);
+            }
+            else
+            {
+                return GetManager<Index>()->GetPage(page);
+            }
+        }
+
+        template <size_t Index, size_t Driver, typename DriverComponentType>
+        decltype(auto) Fetch(ComponentInstance instance, DriverComponentType* driverPage, ComponentInstance pageOffset)
+        {
+            using ComponentType = typename Term<Index>::Type;
+            if constexpr (IsTag<Index>)
+            {
+                return static_cast<ComponentType&>(GetTagInstance<ComponentType>());
+            }
+            else if constexpr (IsStructOfArrays<ComponentType>)
+            {
+                return std::get<Index>(managers)->LoadComponent(instance);
+            }
+            else if constexpr (Index == Driver)
+            {
+                return static_cast<ComponentType&>(driverPage[pageOffset]);
+            }
+            else
+            {
+                return static_cast<ComponentType&>(std::get<Index>(managers)->GetComponent(instance));
+            }
+        }
+
+        //Scatters the copy of a structure of arrays component back into its fields, once the callback is done with it.
+        template <size_t Index, typename ValueType>
+        void StoreBack(ComponentInstance instance, ValueType& value)
+        {
+            if constexpr (IsStructOfArrays<typename Term<Index>::StoredType> && !std::is_const_v<typename Term<Index>::Type>)
+            {
+                GetManager<Index>()->StoreComponent(instance, value);
+            }
+        }
+
+        template <typename Function, typename... Spans>
+        static void InvokeSpans(Function& function, unsigned int count, const Entity* entities, Spans&... spans)
+        {
+            if constexpr (std::is_invocable_v<Function&, unsigned int, const Entity*, Spans&...>)
+            {
+                function(count, entities, spans...);
+            }
+            else
+            {
+                function(count, spans...);
+            }
+        }
+
+        //EachSpan() over the pools: the driving pool is cut into runs that do not cross a page, and the matching entities of every run are handed out together.
+        template <size_t Driver, typename Function, size_t... Indices>
+        void SpansDrivenBy(Function& function, std::index_sequence<Indices...>)
+        {
+            auto* driverManager = std::get<Driver>(managers);
+            constexpr unsigned int PageSize = std::remove_pointer_t<decltype(driverManager)>::PageSize;
+            const Entity* entities = driverManager->GetEntities();
+            ComponentInstance end = driverManager->GetSize() + 1;
+
+            std::tuple<SpanScratch<typename Term<Indices>::StoredType>...> scratch;
+            Entity runEntities[SpanSize];
+            ComponentInstance runInstances[sizeof...(ComponentTypes)][SpanSize];
+
+            ComponentInstance first = 1;
+            while (first < end)
+            {
+                unsigned int page = first / PageSize;
+                ComponentInstance pageEnd = std::min((page + 1) * PageSize, end);
+                if (Term<Driver>::Filter != ViewFilter::None && GetPageVersion<Driver>(page) <= sinceTick)
+                {
+                    first = pageEnd;
+                    continue;
+                }
+
+                ComponentInstance runEnd = std::min(first + SpanSize, pageEnd);
+
+                //Entities that were given their components in the same order sit at the same offsets in every pool, which one memcmp of the entities per pool confirms.
+                //The whole run then matches, and is handed out straight from the pages without a single sparse lookup.
+                if constexpr (!HasFilters)
+                {
+                    unsigned int runLength = runEnd - first;
+                    ComponentInstance bases[] = { (Indices == Driver ? first : std::get<Indices>(managers)->GetInstance(entities[first]))... };
+                    if ((IsRunAligned<Indices>(bases[Indices], entities + first, runLength) && ...))
+                    {
+                        std::tuple<FieldSpans<typename Term<Indices>::Type>...> spans;
+                        (PointSpan<Indices>(std::get<Indices>(spans), bases[Indices]), ...);
+                        InvokeSpans(function, runLength, entities + first, std::get<Indices>(spans)...);
+                        (FinishSpan<Indices>(&bases[Indices], runLength, false, std::get<Indices>(scratch)), ...);
+                        first = runEnd;
+                        continue;
+                    }
+                }
+
+                unsigned int count = 0;
+                for (ComponentInstance instance = first; instance < runEnd; instance++)
+                {
+                    Entity entity = entities[instance];
+                    ComponentInstance instances[] = { (Indices == Driver ? instance : FindInstance<Indices>(entity))... };
+
+                    bool matches = true;
+                    for (ComponentInstance other : instances)
+                    {
+                        matches &= other != 0;
+                    }
+
+                    if (matches && HasFilters)
+                    {
+                        matches = (PassesFilter<Indices>(instances[Indices]) && ...);
+                    }
+
+                    if (matches)
+                    {
+                        runEntities[count] = entity;
+                        ((runInstances[Indices][count] = instances[Indices]), ...);
+                        count++;
+                    }
+                }
+                first = runEnd;
+
+                if (count == 0)
+                {
+                    continue;
+                }
+
+                std::tuple<FieldSpans<typename Term<Indices>::Type>...> spans;
+                bool gathered[] = { PrepareSpan<Indices>(std::get<Indices>(spans), runInstances[Indices], count, std::get<Indices>(scratch))... };
+                InvokeSpans(function, count, runEntities, std::get<Indices>(spans)...);
+                (FinishSpan<Indices>(runInstances[Indices], count, gathered[Indices], std::get<Indices>(scratch)), ...);
+            }
+        }
+
+        //Whether the pool holds the given entities, in the same order, from instance "base" on, without crossing a page.
+        template <size_t Index>
+        bool IsRunAligned(ComponentInstance base, const Entity* runEntities, unsigned int count)
+        {
+            auto* manager = GetManager<Index>();
+            constexpr unsigned int PageSize = std::remove_pointer_t<decltype(manager)>::PageSize;
+            return base != 0 && base % PageSize + count <= PageSize && base + count <= manager->GetSize() + 1
+                && (manager->GetEntities() + base == runEntities || std::memcmp(manager->GetEntities() + base, runEntities, count * sizeof(Entity)) == 0);
+        }
+
+        //Points the spans of a component straight at its field arrays, from instance "base" on.
+        template <size_t Index, typename Spans>
+        void PointSpan(Spans& spans, ComponentInstance base)
+        {
+            using Fields = FieldList<typename Term<Index>::StoredType>;
+            auto* manager = GetManager<Index>();
+            constexpr unsigned int PageSize = std::remove_pointer_t<decltype(manager)>::PageSize;
+            for (size_t field = 0; field < Fields::Count; field++)
+            {
+                spans.SetField(field, manager->GetFieldBytes(base / PageSize, field) + base % PageSize * Fields::Sizes[field]);
+            }
+        }
+
+        //Points the spans of a component at its pages when the run's instances are consecutive, and gathers them into scratch arrays otherwise. Returns whether they were gathered.
+        template <size_t Index, typename Spans, typename Scratch>
+        bool PrepareSpan(Spans& spans, const ComponentInstance* instances, unsigned int count, Scratch& scratch)
+        {
+            using StoredType = typename Term<Index>::StoredType;
+            using Fields = FieldList<StoredType>;
+            auto* manager = GetManager<Index>();
+            constexpr unsigned int PageSize = std::remove_pointer_t<decltype(manager)>::PageSize;
+
+            ComponentInstance base = instances[0];
+            bool consecutive = base % PageSize + count <= PageSize;
+            for (unsigned int i = 1; consecutive && i < count; i++)
+            {
+                consecutive = instances[i] == base + i;
+            }
+
+            if (consecutive)
+            {
+                PointSpan<Index>(spans, base);
+                return false;
+            }
+
+            Fields::ForEach([&](auto field)
+            {
+                constexpr size_t Field = decltype(field)::value;
+                auto* target = scratch.template GetFieldArray<Field>();
+                for (unsigned int i = 0; i < count; i++)
+                {
+                    target[i] = manager->template GetFieldArray<Field>(instances[i] / PageSize)[instances[i] % PageSize];
+                }
+                spans.SetField(Field, reinterpret_cast<unsigned char*>(target));
+            });
+            return true;
+        }
+
+        //Scatters back what PrepareSpan() gathered, and stamps the run, for non-const components.
+        template <size_t Index, typename Scratch>
+        void FinishSpan(const ComponentInstance* instances, unsigned int count, bool gathered, Scratch& scratch)
+        {
+            if constexpr (!std::is_const_v<typename Term<Index>::Type>)
+            {
+                using Fields = FieldList<typename Term<Index>::StoredType>;
+                auto* manager = GetManager<Index>();
+                constexpr unsigned int PageSize = std::remove_pointer_t<decltype(manager)>::PageSize;
+
+                if (!gathered)
+                {
+                    std::fill_n(manager->GetChangedVersions() + instances[0], count, changeTick);
+                    manager->MarkPageChanged(instances[0] / PageSize, changeTick);
+                    return;
+                }
+
+                Fields::ForEach([&](auto field)
+                {
+                    constexpr size_t Field = decltype(field)::value;
+                    auto* source = scratch.template GetFieldArray<Field>();
+                    for (unsigned int i = 0; i < count; i++)
+                    {
+                        manager->template GetFieldArray<Field>(instances[i] / PageSize)[instances[i] % PageSize] = source[i];
+                    }
+                });
+                for (unsigned int i = 0; i < count; i++)
+                {
+                    manager->MarkChanged(instances[i], changeTick);
+                }
+            }
+        }
+
+        //EachSpan() over an archetype chunk, whose columns hold whole components: every run is gathered, and scattered back for the non-const components.
+        template <typename Function, size_t... Indices>
+        void SpansInChunk(Function& function, Archetype& archetype, ArchetypeChunk& chunk, std::index_sequence<Indices...>)
+        {
+            int columnIndices[] = { archetype.GetColumn(GetComponentFamily<typename ViewTerm<ComponentTypes>::StoredType>())... };
+            if (HasFilters && !((Term<Indices>::Filter == ViewFilter::None || GetChunkVersion<Indices>(archetype, chunk, columnIndices[Indices]) > sinceTick) && ...))
+            {
+                return;
+            }
+
+            Entity* entities = archetype.GetEntities(chunk);
+            std::tuple<typename ViewTerm<ComponentTypes>::StoredType*...> columns(static_cast<typename ViewTerm<ComponentTypes>::StoredType*>(archetype.GetColumnData(chunk, columnIndices[Indices]))...);
+            uint32_t* changedVersions[] = { archetype.GetChangedVersions(chunk, columnIndices[Indices])... };
+            uint32_t* filterVersions[] = { (Term<Indices>::Filter == ViewFilter::Added ? archetype.GetAddedVersions(chunk, columnIndices[Indices]) : changedVersions[Indices])... };
+            constexpr bool Writes[] = { !std::is_const_v<typename ViewTerm<ComponentTypes>::Type>... };
+
+            std::tuple<SpanScratch<typename Term<Indices>::StoredType>...> scratch;
+            Entity runEntities[SpanSize];
+            unsigned int rows[SpanSize];
+            bool written = false;
+
+            for (unsigned int first = 0; first < chunk.count; first += SpanSize)
+            {
+                unsigned int count = 0;
+                for (unsigned int row = first; row < std::min(first + SpanSize, chunk.count); row++)
+                {
+                    if (!HasFilters || ((Term<Indices>::Filter == ViewFilter::None || filterVersions[Indices][row] > sinceTick) && ...))
+                    {
+                        runEntities[count] = entities[row];
+                        rows[count++] = row;
+                    }
+                }
+
+                if (count == 0)
+                {
+                    continue;
+                }
+
+                std::tuple<FieldSpans<typename Term<Indices>::Type>...> spans;
+                (GatherRows<Indices>(std::get<Indices>(spans), std::get<Indices>(columns), rows, count, std::get<Indices>(scratch)), ...);
+                InvokeSpans(function, count, runEntities, std::get<Indices>(spans)...);
+                (ScatterRows<Indices>(std::get<Indices>(columns), rows, count, std::get<Indices>(scratch)), ...);
+
+                for (size_t column = 0; column < sizeof...(ComponentTypes); column++)
+                {
+                    for (unsigned int i = 0; Writes[column] && i < count; i++)
+                    {
+                        changedVersions[column][rows[i]] = changeTick;
+                    }
+                }
+                written = true;
+            }
+
+            for (size_t column = 0; written && column < sizeof...(ComponentTypes); column++)
+            {
+                if (Writes[column])
+                {
+                    archetype.GetChunkChangedVersion(chunk, columnIndices[column]) = changeTick;
+                }
+            }
+        }
+
+        template <size_t Index, typename Spans, typename ComponentType, typename Scratch>
+        static void GatherRows(Spans& spans, ComponentType* column, const unsigned int* rows, unsigned int count, Scratch& scratch)
+        {
+            using Fields = FieldList<ComponentType>;
+            Fields::ForEach([&](auto field)
+            {
+                constexpr size_t Field = decltype(field)::value;
+                auto* target = scratch.template GetFieldArray<Field>();
+                for (unsigned int i = 0; i < count; i++)
+                {
+                    target[i] = column[rows[i]].*Fields::template Member<Field>;
+                }
+                spans.SetField(Field, reinterpret_cast<unsigned char*>(target));
+            });
+        }
+
+        template <size_t Index, typename ComponentType, typename Scratch>
+        static void ScatterRows(ComponentType* column, const unsigned int* rows, unsigned int count, Scratch& scratch)
+        {
+            if constexpr (!std::is_const_v<typename Term<Index>::Type>)
+            {
+                using Fields = FieldList<ComponentType>;
+                Fields::ForEach([&](auto field)
+                {
+                    constexpr size_t Field = decltype(field)::value;
+                    auto* source = scratch.template GetFieldArray<Field>();
+                    for (unsigned int i = 0; i < count; i++)
+                    {
+                        column[rows[i]].*Fields::template Member<Field> = source[i];
+                    }
+                });
+            }
+        }
+
+        template <typename Function, size_t... Indices>
+        void EachInChunk(Function& function, Archetype& archetype, ArchetypeChunk& chunk, std::index_sequence<Indices...>)
+        {
+            int columnIndices[] = { archetype.GetColumn(GetComponentFamily<typename ViewTerm<ComponentTypes>::StoredType>())... };
+
+            //A chunk can only hold a matching row if every filtered column of the chunk has been touched since.
+            if (HasFilters && !((Term<Indices>::Filter == ViewFilter::None || GetChunkVersion<Indices>(archetype, chunk, columnIndices[Indices]) > sinceTick) && ...))
+            {
+                return;
+            }
+
+            Entity* entities = archetype.GetEntities(chunk);
+            std::tuple<typename ViewTerm<ComponentTypes>::Type*...> columns(static_cast<typename ViewTerm<ComponentTypes>::Type*>(archetype.GetColumnData(chunk, columnIndices[Indices]))...);
+
+            uint32_t* changedVersions[] = { archetype.GetChangedVersions(chunk, columnIndices[Indices])... };
+            constexpr bool Writes[] = { (!std::is_const_v<typename ViewTerm<ComponentTypes>::Type> && !IsTagComponent<typename ViewTerm<ComponentTypes>::StoredType>)... };
+
+            if constexpr (!HasFilters)
+            {
+                for (unsigned int row = 0; row < chunk.count; row++)
+                {
+                    Invoke(function, entities[row], AtRow<Indices>(std::get<Indices>(columns), row)...);
+                }
+
+                //Every row has been handed out, so the written columns are stamped in one go.
+                for (size_t column = 0; column < sizeof...(ComponentTypes); column++)
+                {
+                    if (Writes[column])
+                    {
+                        std::fill_n(changedVersions[column], chunk.count, changeTick);
+                        archetype.GetChunkChangedVersion(chunk, columnIndices[column]) = changeTick;
+                    }
+                }
+            }
+            else
+            {
+                uint32_t* filterVersions[] = { (Term<Indices>::Filter == ViewFilter::Added ? archetype.GetAddedVersions(chunk, columnIndices[Indices]) : changedVersions[Indices])... };
+                bool written = false;
+
+                for (unsigned int row = 0; row < chunk.count; row++)
+                {
+                    if (!((Term<Indices>::Filter == ViewFilter::None || filterVersions[Indices][row] > sinceTick) && ...))
+                    {
+                        continue;
+                    }
+
+                    Invoke(function, entities[row], AtRow<Indices>(std::get<Indices>(columns), row)...);
+                    for (size_t column = 0; column < sizeof...(ComponentTypes); column++)
+                    {
+                        if (Writes[column])
+                        {
+                            changedVersions[column][row] = changeTick;
+                        }
+                    }
+                    written = true;
+                }
+
+                for (size_t column = 0; written && column < sizeof...(ComponentTypes); column++)
+                {
+                    if (Writes[column])
+                    {
+                        archetype.GetChunkChangedVersion(chunk, columnIndices[column]) = changeTick;
+                    }
+                }
+            }
+        }
+
+        //A row of a chunk column. The columns of tags take no bytes, so they always hand out the same instance.
+        template <size_t Index, typename ComponentType>
+        static ComponentType& AtRow(ComponentType* column, unsigned int row)
+        {
+            if constexpr (IsTag<Index>)
+            {
+                return GetTagInstance<ComponentType>();
+            }
+            else
+            {
+                return column[row];
+            }
+        }
+
+        std::tuple<ComponentManager<typename ViewTerm<ComponentTypes>::StoredType>*...> managers;
+        ArchetypeStorage* archetypes;
+        const std::vector<ComponentMask>* entityMasks = nullptr;
+        uint32_t changeTick;
+        uint32_t sinceTick;
+    };
+}
@@ -4,10 +4,222 @@
 #include "ComponentMask.h"
 #include "EntityHandle.h"
 #include "System.h"
+#include "WorldStreaming.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <limits>
 
 namespace EntitySystem
 {
-	World::World(std::unique_ptr<EntityManager> entityManager) : entityManager(std::move(entityManager)) {}
+	static std::atomic<uint64_t> nextWorldID{ 1 };
+
+	//The command buffer the calling thread used last, so that recording into it does not have to take the world's lock.
+	static thread_local uint64_t cachedCommandBufferWorld = 0;
+	static thread_local CommandBuffer* cachedCommandBuffer = nullptr;
+
+	World::World(std::unique_ptr<EntityManager> entityManager, StorageMode storageMode) : storageMode(storageMode), entityManager(std::move(entityManager)), worldID(nextWorldID.fetch_add(1))
+	{
+		if (storageMode == StorageMode::Archetypes)
+		{
+			archetypes = std::make_unique<ArchetypeStorage>(arena);
+			archetypes->SetChangeTickSource(&changeTick);
+		}
+	}
+
+	void World::Reset()
+	{
+		{
+			std::lock_guard<std::mutex> lock(commandBufferMutex);
+			for (auto& threadBuffer : commandBuffers)
+			{
+				threadBuffer.second->Clear();
+			}
+			pendingCommands.clear();
+		}
+
+		for (auto& system : systems)
+		{
+			system->registeredEntities.Clear();
+			system->OnReset();
+		}
+		hierarchyVersion++;
+
+		//The pages go back to the arena's free lists, which are dropped together with the blocks below.
+		for (auto& manager : componentManagers)
+		{
+			if (manager)
+			{
+				manager->Clear();
+			}
+		}
+		if (archetypes)
+		{
+			archetypes = std::make_unique<ArchetypeStorage>(arena);
+			archetypes->SetChangeTickSource(&changeTick);
+		}
+
+		entityMasks.clear();
+		entityManager->RemoveAllEntities();
+		arena.Reset();
+	}
+
+	std::vector<Entity> World::Merge(World& staging)
+	{
+		WorldMerge merge(*this, staging);
+		merge.Step();
+		return merge.GetEntities();
+	}
+
+	std::vector<Entity> World::Extract(const std::vector<Entity>& entities, World& staging)
+	{
+		assert(storageMode == StorageMode::ComponentPools && staging.storageMode == StorageMode::ComponentPools && "Extracting entities is only supported with StorageMode::ComponentPools.");
+
+		std::vector<Entity> extracted;
+		for (Entity entity : entities)
+		{
+			if (IsAlive(entity))
+			{
+				extracted.push_back(entity);
+			}
+		}
+
+		//Subtrees go along with their roots, which become roots in the staging world.
+		if (std::any_of(extracted.begin(), extracted.end(), [this](Entity entity) { return HasHierarchy(entity); }))
+		{
+			AddDescendants(extracted);
+			std::vector<Entity> descendants;
+			for (Entity entity : extracted)
+			{
+				Hierarchy* node = HasHierarchy(entity) ? LookupComponentForWrite<Hierarchy>(entity) : nullptr;
+				if (node && node->parent == Entity() && node->depth > 0)
+				{
+					unsigned int depth = node->depth;
+					descendants.clear();
+					GetDescendants(entity, descendants);
+					for (Entity descendant : descendants)
+					{
+						LookupComponentForWrite<Hierarchy>(descendant)->depth -= depth;
+					}
+					node->depth = 0;
+				}
+			}
+		}
+
+		std::vector<Entity> created = staging.CreateEntities(static_cast<unsigned int>(extracted.size()));
+		EntityRemap remap;
+		std::vector<std::vector<Entity>> byFamily(componentManagers.size());
+		for (size_t i = 0; i < extracted.size(); i++)
+		{
+			remap.Add(extracted[i], created[i]);
+			GetEntityMask(extracted[i]).ForEachFamily([this, &byFamily, &extracted, i](int family)
+			{
+				//Tags have no manager, they move with the masks.
+				if (HasComponentManager(family))
+				{
+					byFamily[family].push_back(extracted[i]);
+				}
+			});
+		}
+
+		for (size_t family = 0; family < byFamily.size(); family++)
+		{
+			if (!byFamily[family].empty())
+			{
+				BaseComponentManager* manager = staging.GetComponentManagerLike(static_cast<int>(family), *componentManagers[family]);
+				manager->AppendFrom(*componentManagers[family], byFamily[family].data(), byFamily[family].size(), remap);
+			}
+		}
+
+		for (size_t i = 0; i < extracted.size(); i++)
+		{
+			staging.GetEntityMask(created[i]) = GetEntityMask(extracted[i]);
+		}
+		staging.UpdateEntityMasks(created, std::vector<ComponentMask>(created.size()));
+		staging.hierarchyVersion++;
+
+		DestroyEntities(extracted);
+		return created;
+	}
+
+	Prefab World::CreatePrefab(Entity entity)
+	{
+		assert(storageMode == StorageMode::ComponentPools && "Prefabs are only available with StorageMode::ComponentPools.");
+		assert(IsAlive(entity));
+
+		Prefab prefab;
+		int hierarchyFamily = GetComponentFamily<Hierarchy>();
+		GetEntityMask(entity).ForEachFamily([this, entity, hierarchyFamily, &prefab](int family)
+		{
+			if (!HasComponentManager(family))
+			{
+				prefab.mask.AddFamily(family);
+			}
+			else if (family != hierarchyFamily)
+			{
+				if (!componentManagers[family]->IsCopyable())
+				{
+					std::cerr << "World: component family " << family << " cannot be copy constructed, so it cannot be part of a prefab." << std::endl;
+					std::abort();
+				}
+
+				std::unique_ptr<BaseComponentManager> manager = componentManagers[family]->MakeEmpty(HeapPageAllocator::Get());
+				manager->AppendCopies(*componentManagers[family], entity, &Prefab::Prototype, 1);
+				prefab.components.push_back({ family, std::move(manager) });
+				prefab.mask.AddFamily(family);
+			}
+		});
+		return prefab;
+	}
+
+	std::vector<Entity> World::Instantiate(const Prefab& prefab, unsigned int count)
+	{
+		assert(storageMode == StorageMode::ComponentPools && "Prefabs are only available with StorageMode::ComponentPools.");
+		std::vector<Entity> entities = CreateEntities(count);
+		if (entities.empty())
+		{
+			return entities;
+		}
+
+		for (const Prefab::PrefabComponent& component : prefab.components)
+		{
+			GetComponentManagerLike(component.family, *component.manager)->AppendCopies(*component.manager, Prefab::Prototype, entities.data(), entities.size());
+		}
+
+		//Every instance has the same mask, so each system is tested once, and registers all of them or none.
+		Entity last = *std::max_element(entities.begin(), entities.end(), [](Entity l, Entity r) { return l.Index() < r.Index(); });
+		GetEntityMask(last);
+		for (Entity entity : entities)
+		{
+			entityMasks[entity.Index()] = prefab.mask;
+		}
+
+		for (auto& system : systems)
+		{
+			if (prefab.mask.Matches(system->GetSignature()))
+			{
+				system->RegisterEntities(entities.data(), entities.size());
+			}
+		}
+		return entities;
+	}
+
+	BaseComponentManager* World::GetComponentManagerLike(int family, const BaseComponentManager& other)
+	{
+		if (family >= static_cast<int>(componentManagers.size()))
+		{
+			componentManagers.resize(family + 1);
+		}
+
+		if (!componentManagers[family])
+		{
+			ownedComponentManagers.push_back(other.MakeEmpty(arena));
+			componentManagers[family] = ownedComponentManagers.back().get();
+			componentManagers[family]->SetChangeTickSource(&changeTick);
+		}
+		return componentManagers[family];
+	}
 
 	void World::Initialize()
 	{
@@ -19,40 +231,1038 @@ namespace EntitySystem
 
 	void World::Update(int deltaTime)
 	{
+#if ECS_ENABLE_PROFILER
+		profiler.BeginFrame();
+		uint64_t frameStart = Profiler::GetTimestamp();
+#endif
+
+		//Sync point: whatever was recorded since the last frame is in place before any system runs.
+		FlushCommands();
+		if (!IsScheduleCurrent())
+		{
+			BuildSchedule();
+		}
+
+		if (schedulerMode == SchedulerMode::SingleThreaded || systems.size() < 2)
+		{
+			for (size_t index : schedule.order)
+			{
+				UpdateSystem(index, deltaTime);
+			}
+		}
+		else
+		{
+			RunScheduleInParallel(deltaTime);
+		}
+
+		//Sync point: every system is done, so the changes they recorded can be applied.
+		FlushCommands();
+
+#if ECS_ENABLE_PROFILER
+		profiler.Record(ProfileEventType::Frame, 0, frameStart, Profiler::GetTimestamp(), static_cast<uint32_t>(entityManager->GetAliveCount()), 0);
+#endif
+	}
+
+	CommandBuffer& World::GetCommandBuffer()
+	{
+		if (cachedCommandBufferWorld == worldID)
+		{
+			return *cachedCommandBuffer;
+		}
+
+		std::lock_guard<std::mutex> lock(commandBufferMutex);
+		std::thread::id thread = std::this_thread::get_id();
+
+		CommandBuffer* buffer = nullptr;
+		for (auto& threadBuffer : commandBuffers)
+		{
+			if (threadBuffer.first == thread)
+			{
+				buffer = threadBuffer.second.get();
+				break;
+			}
+		}
+
+		if (!buffer)
+		{
+			commandBuffers.emplace_back(thread, std::make_unique<CommandBuffer>());
+			buffer = commandBuffers.back().second.get();
+		}
+
+		cachedCommandBufferWorld = worldID;
+		cachedCommandBuffer = buffer;
+		return *buffer;
+	}
+
+	void World::FlushCommands()
+	{
+#if ECS_ENABLE_PROFILER
+		uint64_t start = Profiler::GetTimestamp();
+		size_t commandCount = PlayBackCommands();
+		profiler.Record(ProfileEventType::FlushCommands, 0, start, Profiler::GetTimestamp(), 0, static_cast<uint32_t>(commandCount));
+#else
+		PlayBackCommands();
+#endif
+	}
+
+	size_t World::PlayBackCommands()
+	{
+		size_t commandCount = 0;
+		std::lock_guard<std::mutex> lock(commandBufferMutex);
+		pendingCommands.clear();
+
+		for (auto& threadBuffer : commandBuffers)
+		{
+			CommandBuffer& buffer = *threadBuffer.second;
+			if (buffer.IsEmpty())
+			{
+				continue;
+			}
+
+			commandCount += buffer.GetCommandCount();
+
+			//Placeholders are only meaningful within the buffer that handed them out, so they are resolved buffer by buffer.
+			std::vector<Entity> created = entityManager->CreateEntities(buffer.placeholderCount);
+			for (EntityCommand& command : buffer.commands)
+			{
+				if (CommandBuffer::IsPlaceholder(command.entity))
+				{
+					command.entity = created[command.entity.Generation() - 1];
+				}
+
+				if (command.type != EntityCommandType::CreateEntity)
+				{
+					pendingCommands.push_back(command);
+				}
+
+				//The component now belongs to the pending command, which takes care of destroying it.
+				command.component = nullptr;
+			}
+			buffer.Clear();
+		}
+
+		if (pendingCommands.empty())
+		{
+			return commandCount;
+		}
+
+		//Remember the mask of every entity before any command is played back, so that systems are notified once per entity with the final result.
+		std::vector<Entity> touched;
+		std::vector<ComponentMask> oldMasks;
+		if (touchedSlots.size() < entityManager->GetIndexCount())
+		{
+			touchedSlots.resize(entityManager->GetIndexCount(), 0);
+		}
+
+		for (const EntityCommand& command : pendingCommands)
+		{
+			if (IsAlive(command.entity) && touchedSlots[command.entity.Index()] == 0)
+			{
+				touched.push_back(command.entity);
+				oldMasks.push_back(GetEntityMask(command.entity));
+				touchedSlots[command.entity.Index()] = static_cast<unsigned int>(touched.size());
+			}
+		}
+
+		//Sorting by family means every component manager is visited once. The sort is stable, so the commands of one family keep the order they were recorded in.
+		//Destruction goes last: an entity that gets destroyed ends up without components regardless of what else was recorded for it.
+		auto sortKey = [](const EntityCommand& command) { return command.type == EntityCommandType::DestroyEntity ? INT_MAX : command.family; };
+		std::stable_sort(pendingCommands.begin(), pendingCommands.end(), [&sortKey](const EntityCommand& l, const EntityCommand& r) { return sortKey(l) < sortKey(r); });
+
+		std::vector<Entity> destroyed;
+		size_t begin = 0;
+		while (begin < pendingCommands.size())
+		{
+			EntityCommand& first = pendingCommands[begin];
+			if (first.type == EntityCommandType::DestroyEntity)
+			{
+				if (IsAlive(first.entity))
+				{
+					destroyed.push_back(first.entity);
+				}
+				begin++;
+				continue;
+			}
+
+			size_t end = begin + 1;
+			while (end < pendingCommands.size() && pendingCommands[end].family == first.family && pendingCommands[end].type != EntityCommandType::DestroyEntity)
+			{
+				end++;
+			}
+
+			first.playback(*this, &pendingCommands[begin], end - begin);
+			begin = end;
+		}
+
+		//An entity may have been destroyed by several commands.
+		std::sort(destroyed.begin(), destroyed.end());
+		destroyed.erase(std::unique(destroyed.begin(), destroyed.end()), destroyed.end());
+
+		//Destroyed parents take their subtrees down with them, and the descendants need their masks updated like the entities the commands touched.
+		if (std::any_of(destroyed.begin(), destroyed.end(), [this](Entity entity) { return HasHierarchy(entity); }))
+		{
+			AddDescendants(destroyed);
+			for (Entity entity : destroyed)
+			{
+				if (touchedSlots[entity.Index()] == 0)
+				{
+					touched.push_back(entity);
+					oldMasks.push_back(GetEntityMask(entity));
+					touchedSlots[entity.Index()] = static_cast<unsigned int>(touched.size());
+				}
+			}
+		}
+
+		for (Entity entity : destroyed)
+		{
+			ClearComponents(entity);
+		}
+
+		UpdateEntityMasks(touched, oldMasks);
+		entityManager->DestroyEntities(destroyed.data(), destroyed.size());
+
+		for (Entity entity : touched)
+		{
+			touchedSlots[entity.Index()] = 0;
+		}
+		pendingCommands.clear();
+		return commandCount;
+	}
+
+	void World::UpdateSystem(size_t index, int deltaTime)
+	{
+		System& system = *systems[index];
+
+		//Systems with a tick rate may be updated several times, or not at all (see System::SetTickRate()). Those skipped keep their last change tick, so they still see every change on their next update.
+		int tickTime = deltaTime;
+		unsigned int ticks = system.AdvanceClock(deltaTime, tickTime);
+		for (unsigned int tick = 0; tick < ticks; tick++)
+		{
+#if ECS_ENABLE_PROFILER
+			//Structural changes are counted as the commands the system recorded on this thread, which is where it records them unless it spawns jobs of its own.
+			CommandBuffer& commands = GetCommandBuffer();
+			size_t commandCount = commands.GetCommandCount();
+			uint64_t start = Profiler::GetTimestamp();
+			system.Update(tickTime);
+			profiler.Record(ProfileEventType::SystemUpdate, static_cast<uint32_t>(index), start, Profiler::GetTimestamp(),
+				static_cast<uint32_t>(system.registeredEntities.size()), static_cast<uint32_t>(commands.GetCommandCount() - commandCount));
+#else
+			system.Update(tickTime);
+#endif
+
+			//Everything the system wrote is stamped with a tick up to this one, and everything written from now on with a later one.
+			system.lastChangeTick = changeTick.fetch_add(1, std::memory_order_relaxed);
+			system.currentSlice = (system.currentSlice + 1) % system.timeSlices;
+		}
+	}
+
+	JobSystem& World::GetJobSystem()
+	{
+		if (!jobSystem)
+		{
+			jobSystem = std::make_unique<JobSystem>();
+		}
+		return *jobSystem;
+	}
+
+	bool World::IsScheduleCurrent()
+	{
+		if (schedule.order.size() != systems.size())
+		{
+			return false;
+		}
+		for (size_t index = 0; index < systems.size(); index++)
+		{
+			System& system = *systems[index];
+			if (system.GetReadMask() != schedule.readMasks[index] || system.GetWriteMask() != schedule.writeMasks[index] || system.GetRunAfter() != schedule.runAfter[index])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void World::BuildSchedule()
+	{
+		size_t systemCount = systems.size();
+		schedule.order.clear();
+		schedule.dependents.assign(systemCount, {});
+		schedule.dependencyCount.assign(systemCount, 0);
+
+		//explicitBefore[a][b] is true when system a has to run before system b.
+		std::vector<std::vector<bool>> explicitBefore(systemCount, std::vector<bool>(systemCount, false));
+		std::vector<unsigned int> explicitCount(systemCount, 0);
+		for (size_t index = 0; index < systemCount; index++)
+		{
+			for (System* other : systems[index]->GetRunAfter())
+			{
+				for (size_t otherIndex = 0; otherIndex < systemCount; otherIndex++)
+				{
+					if (systems[otherIndex].get() == other && otherIndex != index && !explicitBefore[otherIndex][index])
+					{
+						explicitBefore[otherIndex][index] = true;
+						explicitCount[index]++;
+					}
+				}
+			}
+		}
+
+		//Orders the systems by the explicit constraints, breaking ties by the order they were added in.
+		std::vector<bool> scheduled(systemCount, false);
+		while (schedule.order.size() < systemCount)
+		{
+			size_t next = systemCount;
+			for (size_t index = 0; index < systemCount; index++)
+			{
+				if (!scheduled[index] && explicitCount[index] == 0)
+				{
+					next = index;
+					break;
+				}
+			}
+
+			if (next == systemCount)
+			{
+				std::cerr << "World: RunAfter()/RunBefore() constraints form a cycle, the remaining systems run in the order they were added." << std::endl;
+				for (size_t index = 0; index < systemCount; index++)
+				{
+					if (!scheduled[index])
+					{
+						explicitCount[index] = 0;
+					}
+				}
+				continue;
+			}
+
+			scheduled[next] = true;
+			schedule.order.push_back(next);
+			for (size_t index = 0; index < systemCount; index++)
+			{
+				if (explicitBefore[next][index] && explicitCount[index] > 0)
+				{
+					explicitCount[index]--;
+				}
+			}
+		}
+
+		//Any two systems that conflict, or are explicitly ordered, keep the order chosen above.
+		for (size_t first = 0; first < systemCount; first++)
+		{
+			for (size_t second = first + 1; second < systemCount; second++)
+			{
+				size_t before = schedule.order[first];
+				size_t after = schedule.order[second];
+				if (explicitBefore[before][after] || explicitBefore[after][before] || systems[before]->ConflictsWith(*systems[after]))
+				{
+					schedule.dependents[before].push_back(after);
+					schedule.dependencyCount[after]++;
+				}
+			}
+		}
+
+		schedule.readMasks.clear();
+		schedule.writeMasks.clear();
+		schedule.runAfter.clear();
 		for (auto& system : systems)
 		{
-			system->Update(deltaTime);
+			schedule.readMasks.push_back(system->GetReadMask());
+			schedule.writeMasks.push_back(system->GetWriteMask());
+			schedule.runAfter.push_back(system->GetRunAfter());
 		}
 	}
 
+	void World::RunScheduleInParallel(int deltaTime)
+	{
+		JobSystem& jobs = GetJobSystem();
+		JobCounter counter;
+
+		std::vector<std::atomic<unsigned int>> remaining(systems.size());
+		for (size_t index = 0; index < systems.size(); index++)
+		{
+			remaining[index].store(schedule.dependencyCount[index], std::memory_order_relaxed);
+		}
+
+		//Once a system is done, every dependent whose last dependency it was can start.
+		std::function<void(size_t)> run = [&](size_t index)
+		{
+			UpdateSystem(index, deltaTime);
+			for (size_t dependent : schedule.dependents[index])
+			{
+				if (remaining[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					jobs.Submit([&run, dependent]() { run(dependent); }, counter);
+				}
+			}
+		};
+
+		for (size_t index : schedule.order)
+		{
+			if (schedule.dependencyCount[index] == 0)
+			{
+				jobs.Submit([&run, index]() { run(index); }, counter);
+			}
+		}
+		jobs.Wait(counter);
+	}
+
 	void World::Render()
 	{
-		for (auto& system : systems)
+		for (size_t index = 0; index < systems.size(); index++)
+		{
+#if ECS_ENABLE_PROFILER
+			uint64_t start = Profiler::GetTimestamp();
+			systems[index]->Render();
+			profiler.Record(ProfileEventType::SystemRender, static_cast<uint32_t>(index), start, Profiler::GetTimestamp(), static_cast<uint32_t>(systems[index]->registeredEntities.size()), 0);
+#else
+			systems[index]->Render();
+#endif
+		}
+	}
+
+	std::vector<std::string> World::GetSystemNames() const
+	{
+		std::vector<std::string> names;
+		for (const auto& system : systems)
 		{
-			system->Render();
+			names.push_back(system->GetName());
 		}
+		return names;
+	}
+
+	std::vector<ProfileStats> World::GetProfileStats() const
+	{
+#if ECS_ENABLE_PROFILER
+		return profiler.GetStats(GetSystemNames());
+#else
+		return {};
+#endif
+	}
+
+	bool World::WriteChromeTrace(const std::string& path) const
+	{
+#if ECS_ENABLE_PROFILER
+		return profiler.WriteChromeTrace(path, GetSystemNames());
+#else
+		return false;
+#endif
 	}
 
 	EntityHandle World::CreateEntity() { return { entityManager->RegisterNewEntity(), this }; }
 
 	void World::DestroyEntity(EntitySystem::Entity entity)
 	{
-		for (auto& system : systems)
+		if (!entityManager->IsAlive(entity))
 		{
-			system->UnregisterEntity(entity);
+			return;
 		}
 
+		//Takes its subtree down with it.
+		if (HasHierarchy(entity))
+		{
+			DestroyEntities({ entity });
+			return;
+		}
+
+		//Only the systems whose signature matched the old mask have the entity registered, and those are exactly the ones that see the now empty mask as no longer matched.
+		ComponentMask oldMask = ClearComponents(entity);
+		UpdateEntityMask(entity, oldMask);
 		entityManager->RemoveEntity(entity);
 	}
 
-	void World::AddSystem(std::unique_ptr<EntitySystem::System> system)
+	void World::DestroyEntities(const std::vector<Entity>& entities)
+	{
+		//Parents take their subtrees down with them, which only costs a copy of the list when there are any.
+		std::vector<Entity> withDescendants;
+		const std::vector<Entity>* list = &entities;
+		if (std::any_of(entities.begin(), entities.end(), [this](Entity entity) { return HasHierarchy(entity); }))
+		{
+			withDescendants = entities;
+			AddDescendants(withDescendants);
+			list = &withDescendants;
+		}
+
+		std::vector<Entity> destroyed;
+		std::vector<ComponentMask> oldMasks;
+		destroyed.reserve(list->size());
+		oldMasks.reserve(list->size());
+
+		for (Entity entity : *list)
+		{
+			if (entityManager->IsAlive(entity) && !GetEntityMask(entity).IsEmpty())
+			{
+				destroyed.push_back(entity);
+				oldMasks.push_back(ClearComponents(entity));
+			}
+		}
+
+		//Every destroyed entity now has an empty mask, so the systems they were registered with see them as no longer matched.
+		UpdateEntityMasks(destroyed, oldMasks);
+		entityManager->DestroyEntities(list->data(), list->size());
+	}
+
+	void World::SetParent(Entity child, Entity parent)
+	{
+		assert(IsAlive(child) && (parent == Entity() || IsAlive(parent)));
+
+		//Checked before anything changes, as linking a cycle would send every walk down the hierarchy into an endless loop.
+		for (Entity ancestor = parent; ancestor != Entity(); ancestor = HasHierarchy(ancestor) ? LookupComponent<Hierarchy>(ancestor)->parent : Entity())
+		{
+			if (ancestor == child)
+			{
+				assert(false && "An entity cannot be parented to itself or to one of its descendants.");
+				return;
+			}
+		}
+
+		//Both components are added before any of them is looked up, as adding one may move the other within its pool.
+		if (!HasHierarchy(child))
+		{
+			AddComponent(child, Hierarchy());
+		}
+		if (parent != Entity() && !HasHierarchy(parent))
+		{
+			AddComponent(parent, Hierarchy());
+		}
+		Hierarchy* node = LookupComponentForWrite<Hierarchy>(child);
+
+		Unlink(*node);
+		unsigned int depth = 0;
+		if (parent != Entity())
+		{
+			Hierarchy* parentNode = LookupComponentForWrite<Hierarchy>(parent);
+
+			node->parent = parent;
+			node->nextSibling = parentNode->firstChild;
+			if (parentNode->firstChild != Entity())
+			{
+				LookupComponentForWrite<Hierarchy>(parentNode->firstChild)->previousSibling = child;
+			}
+			parentNode->firstChild = child;
+			parentNode->childCount++;
+			depth = parentNode->depth + 1;
+		}
+
+		//The depths of the whole subtree follow the new one of its root.
+		int difference = static_cast<int>(depth) - static_cast<int>(node->depth);
+		if (difference != 0)
+		{
+			node->depth = depth;
+			std::vector<Entity> descendants;
+			GetDescendants(child, descendants);
+			for (Entity descendant : descendants)
+			{
+				LookupComponentForWrite<Hierarchy>(descendant)->depth += difference;
+			}
+		}
+		hierarchyVersion++;
+	}
+
+	Entity World::GetParent(Entity entity)
+	{
+		Hierarchy* node = HasHierarchy(entity) ? LookupComponent<Hierarchy>(entity) : nullptr;
+		return node ? node->parent : Entity();
+	}
+
+	void World::GetDescendants(Entity entity, std::vector<Entity>& descendants)
+	{
+		if (!HasHierarchy(entity))
+		{
+			return;
+		}
+
+		//Breadth first, using the output as the queue, so that parents always come before their children.
+		size_t next = descendants.size();
+		Entity current = entity;
+		while (true)
+		{
+			for (Entity child = LookupComponent<Hierarchy>(current)->firstChild; child != Entity(); child = LookupComponent<Hierarchy>(child)->nextSibling)
+			{
+				descendants.push_back(child);
+			}
+
+			if (next == descendants.size())
+			{
+				return;
+			}
+			current = descendants[next++];
+		}
+	}
+
+	void World::Unlink(Hierarchy& node)
+	{
+		if (node.parent == Entity())
+		{
+			return;
+		}
+
+		if (node.previousSibling != Entity())
+		{
+			LookupComponentForWrite<Hierarchy>(node.previousSibling)->nextSibling = node.nextSibling;
+		}
+		else
+		{
+			LookupComponentForWrite<Hierarchy>(node.parent)->firstChild = node.nextSibling;
+		}
+		if (node.nextSibling != Entity())
+		{
+			LookupComponentForWrite<Hierarchy>(node.nextSibling)->previousSibling = node.previousSibling;
+		}
+		LookupComponentForWrite<Hierarchy>(node.parent)->childCount--;
+
+		node.parent = Entity();
+		node.nextSibling = Entity();
+		node.previousSibling = Entity();
+	}
+
+	bool World::HasHierarchy(Entity entity)
+	{
+		return IsAlive(entity) && GetEntityMask(entity).HasFamily(GetComponentFamily<Hierarchy>());
+	}
+
+	void World::AddDescendants(std::vector<Entity>& entities)
+	{
+		EntitySet listed;
+		for (Entity entity : entities)
+		{
+			listed.Insert(entity);
+		}
+
+		//The set keeps descendants that were listed as well from being listed twice.
+		size_t count = entities.size();
+		std::vector<Entity> descendants;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (HasHierarchy(entities[i]))
+			{
+				descendants.clear();
+				GetDescendants(entities[i], descendants);
+				for (Entity descendant : descendants)
+				{
+					if (listed.Insert(descendant))
+					{
+						entities.push_back(descendant);
+					}
+				}
+			}
+		}
+
+		//Only the roots of the subtrees, whose parents stay behind, are detached: the links inside of the subtrees go along with them, or die with them.
+		for (Entity entity : entities)
+		{
+			if (HasHierarchy(entity))
+			{
+				Hierarchy& node = *LookupComponentForWrite<Hierarchy>(entity);
+				if (node.parent != Entity() && !listed.Contains(node.parent))
+				{
+					Unlink(node);
+				}
+			}
+		}
+	}
+
+	bool World::SaveSnapshot(const std::string& path)
+	{
+		if (storageMode != StorageMode::ComponentPools)
+		{
+			std::cerr << "World: snapshots are only supported with StorageMode::ComponentPools." << std::endl;
+			return false;
+		}
+
+		SnapshotWriter writer(path);
+		if (!writer.IsOpen())
+		{
+			std::cerr << "World: could not open " << path << " to save a snapshot." << std::endl;
+			return false;
+		}
+
+		//The header and the block directory are written once everything else is, as only then are the offsets known.
+		SnapshotHeader header = {};
+		std::memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+		header.version = SnapshotVersion;
+		header.blockCount = static_cast<uint32_t>(snapshotComponents.size());
+		std::vector<SnapshotBlock> blocks(snapshotComponents.size(), SnapshotBlock{});
+		writer.Write(header);
+		writer.Write(blocks.data(), blocks.size() * sizeof(SnapshotBlock));
+
+		const std::vector<unsigned int>& generations = entityManager->GetGenerations();
+		header.generationsOffset = writer.GetOffset();
+		header.generationCount = generations.size();
+		writer.Write(generations.data(), generations.size() * sizeof(unsigned int));
+
+		const std::vector<unsigned int>& freeIndices = entityManager->GetFreeIndices();
+		header.freeIndicesOffset = writer.GetOffset();
+		header.freeIndexCount = freeIndices.size();
+		writer.Write(freeIndices.data(), freeIndices.size() * sizeof(unsigned int));
+
+		for (size_t i = 0; i < snapshotComponents.size(); i++)
+		{
+			std::strncpy(blocks[i].name, snapshotComponents[i].name.c_str(), sizeof(blocks[i].name) - 1);
+			snapshotComponents[i].save(*this, writer, blocks[i]);
+		}
+
+		writer.Patch(0, &header, sizeof(header));
+		writer.Patch(sizeof(header), blocks.data(), blocks.size() * sizeof(SnapshotBlock));
+		if (writer.Failed())
+		{
+			std::cerr << "World: writing the snapshot " << path << " failed." << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool World::LoadSnapshot(const std::string& path)
+	{
+		if (storageMode != StorageMode::ComponentPools)
+		{
+			std::cerr << "World: snapshots are only supported with StorageMode::ComponentPools." << std::endl;
+			return false;
+		}
+
+		if (entityManager->GetAliveCount() > 0)
+		{
+			std::cerr << "World: snapshots can only be loaded into a world without any live entity." << std::endl;
+			return false;
+		}
+
+		std::shared_ptr<MemoryMappedFile> file = std::make_shared<MemoryMappedFile>();
+		if (!file->Open(path))
+		{
+			std::cerr << "World: could not map the snapshot " << path << "." << std::endl;
+			return false;
+		}
+
+		const unsigned char* data = file->GetData();
+		uint64_t size = file->GetSize();
+		SnapshotHeader header;
+		if (size < sizeof(header))
+		{
+			std::cerr << "World: " << path << " is not a snapshot." << std::endl;
+			return false;
+		}
+		std::memcpy(&header, data, sizeof(header));
+
+		if (std::memcmp(header.magic, SnapshotMagic, sizeof(header.magic)) != 0 || header.version != SnapshotVersion)
+		{
+			std::cerr << "World: " << path << " is not a snapshot of version " << SnapshotVersion << "." << std::endl;
+			return false;
+		}
+
+		if (sizeof(header) + static_cast<uint64_t>(header.blockCount) * sizeof(SnapshotBlock) > size
+			|| header.generationsOffset + header.generationCount * sizeof(unsigned int) > size
+			|| header.freeIndicesOffset + header.freeIndexCount * sizeof(unsigned int) > size)
+		{
+			std::cerr << "World: the snapshot " << path << " is truncated." << std::endl;
+			return false;
+		}
+
+		//Every block is checked to lie within the file before the world is touched. What only the component managers can check is caught while loading, which resets the world.
+		std::vector<SnapshotBlock> blocks(header.blockCount);
+		for (uint32_t i = 0; i < header.blockCount; i++)
+		{
+			SnapshotBlock& block = blocks[i];
+			std::memcpy(&block, data + sizeof(header) + i * sizeof(SnapshotBlock), sizeof(block));
+			block.name[sizeof(block.name) - 1] = '\0';
+
+			if (block.instanceCount == 0 || block.entitiesOffset > size || static_cast<uint64_t>(block.instanceCount) * sizeof(Entity) > size - block.entitiesOffset
+				|| block.dataOffset > size || block.dataSize > size - block.dataOffset)
+			{
+				std::cerr << "World: the block of the component type " << block.name << " of the snapshot " << path << " is truncated." << std::endl;
+				return false;
+			}
+		}
+
+		const unsigned int* generations = reinterpret_cast<const unsigned int*>(data + header.generationsOffset);
+		const unsigned int* freeIndices = reinterpret_cast<const unsigned int*>(data + header.freeIndicesOffset);
+		entityManager->Restore(std::vector<unsigned int>(generations, generations + header.generationCount), std::vector<unsigned int>(freeIndices, freeIndices + header.freeIndexCount));
+		unsigned int indexCount = entityManager->GetIndexCount();
+		entityMasks.assign(indexCount, ComponentMask());
+
+		for (const SnapshotBlock& block : blocks)
+		{
+			auto type = std::find_if(snapshotComponents.begin(), snapshotComponents.end(), [&block](const SnapshotComponentType& type) { return type.name == block.name; });
+			if (type == snapshotComponents.end())
+			{
+				std::cerr << "World: skipping the unregistered component type " << block.name << " of the snapshot " << path << "." << std::endl;
+				continue;
+			}
+
+			if (!type->load(*this, file, block))
+			{
+				std::cerr << "World: the component type " << block.name << " of the snapshot " << path << " does not match the registered type." << std::endl;
+
+				//Some entities and components may already be in, without their masks or systems knowing: a failed load leaves an empty world instead.
+				Reset();
+				return false;
+			}
+
+			//The entity list of the block was validated by the component manager.
+			const Entity* entities = reinterpret_cast<const Entity*>(data + block.entitiesOffset);
+			for (uint32_t instance = 1; instance < block.instanceCount; instance++)
+			{
+				if (entities[instance].Index() < indexCount)
+				{
+					entityMasks[entities[instance].Index()].AddFamily(type->family);
+				}
+			}
+		}
+
+		//The pools were filled in the order they were saved in, which is only the order of the groups if the saving world had the same groups.
+		for (auto& group : groups)
+		{
+			group->Rebuild();
+		}
+
+		//Every loaded entity goes from an empty mask to its full mask, so the systems pick up exactly the entities matching their signatures.
+		std::vector<Entity> loaded;
+		for (unsigned int index = 1; index < indexCount; index++)
+		{
+			if (!entityMasks[index].IsEmpty())
+			{
+				loaded.push_back(Entity::Make(index, entityManager->GetGenerations()[index]));
+			}
+		}
+		UpdateEntityMasks(loaded, std::vector<ComponentMask>(loaded.size()));
+		return true;
+	}
+
+	bool World::EncodeDelta(DeltaEncoder& encoder, std::vector<unsigned char>& stream)
+	{
+		if (storageMode != StorageMode::ComponentPools)
+		{
+			std::cerr << "World: delta snapshots are only supported with StorageMode::ComponentPools." << std::endl;
+			return false;
+		}
+
+		//The tick is advanced like after a system update, so that whatever is written from now on is newer than this delta.
+		uint32_t sinceTick = encoder.lastTick;
+		encoder.lastTick = changeTick.fetch_add(1, std::memory_order_relaxed);
+
+		stream.clear();
+		SnapshotWriter writer(stream);
+		DeltaStats stats;
+
+		DeltaHeader header = {};
+		header.magic = DeltaMagic;
+		header.version = DeltaVersion;
+		header.baseSequence = encoder.sequence;
+		header.sequence = encoder.sequence + 1;
+		header.blockCount = snapshotComponents.size();
+		writer.Write(header);
+
+		EncodeArrayDelta(writer, encoder.generations, entityManager->GetGenerations());
+		EncodeArrayDelta(writer, encoder.freeIndices, entityManager->GetFreeIndices());
+		stats.entityBytes = writer.GetOffset() - sizeof(header);
+
+		//Every block starts with its size, so that replicas which do not know a component type can skip it.
+		encoder.components.resize(snapshotComponents.size());
+		for (size_t i = 0; i < snapshotComponents.size(); i++)
+		{
+			writer.WriteString(snapshotComponents[i].name);
+			uint64_t sizeOffset = writer.GetOffset();
+			writer.Write(uint64_t{ 0 });
+			snapshotComponents[i].encodeDelta(*this, writer, encoder.components[i], sinceTick, stats);
+
+			uint64_t blockSize = writer.GetOffset() - sizeOffset - sizeof(uint64_t);
+			writer.Patch(sizeOffset, &blockSize, sizeof(blockSize));
+		}
+
+		stats.bytes = stream.size();
+		encoder.sequence = header.sequence;
+		encoder.lastStats = stats;
+		return true;
+	}
+
+	bool World::ApplyDelta(DeltaDecoder& decoder, const unsigned char* data, size_t size)
+	{
+		if (storageMode != StorageMode::ComponentPools)
+		{
+			std::cerr << "World: delta snapshots are only supported with StorageMode::ComponentPools." << std::endl;
+			return false;
+		}
+
+		SnapshotReader reader(data, size);
+		DeltaHeader header = reader.Read<DeltaHeader>();
+		if (reader.Failed() || header.magic != DeltaMagic || header.version != DeltaVersion)
+		{
+			std::cerr << "World: not a delta snapshot of version " << DeltaVersion << "." << std::endl;
+			return false;
+		}
+
+		if (header.baseSequence == 0 && entityManager->GetAliveCount() > 0)
+		{
+			std::cerr << "World: the first delta of a stream can only be applied to a world without any live entity." << std::endl;
+			return false;
+		}
+
+		if (header.baseSequence != decoder.sequence)
+		{
+			std::cerr << "World: delta " << header.sequence << " applies on top of delta " << header.baseSequence << ", but the last delta applied is " << decoder.sequence << "." << std::endl;
+			return false;
+		}
+
+		//The entity manager is patched in place. Every index whose generation changed has seen its entity destroyed, which is remembered before the new generation is written.
+		std::vector<unsigned int> generations;
+		std::vector<unsigned int> freeIndices;
+		entityManager->SwapState(generations, freeIndices);
+
+		std::vector<Entity> destroyed;
+		uint64_t generationCount = reader.ReadVarint();
+		size_t previousGenerationCount = generations.size();
+		bool valid = !reader.Failed() && generationCount <= std::numeric_limits<uint32_t>::max();
+		if (valid)
+		{
+			generations.resize(static_cast<size_t>(generationCount), 0);
+			valid = DecodeXorRle(reader, [&generations, &destroyed, previousGenerationCount](uint64_t offset, const unsigned char* xorBytes, size_t length)
+			{
+				if (offset + length > generations.size() * sizeof(unsigned int))
+				{
+					return false;
+				}
+
+				unsigned char* bytes = reinterpret_cast<unsigned char*>(generations.data());
+				for (size_t i = 0; i < length; i++)
+				{
+					size_t index = static_cast<size_t>((offset + i) / sizeof(unsigned int));
+					if (index < previousGenerationCount && index != 0 && (destroyed.empty() || destroyed.back().Index() != index))
+					{
+						destroyed.push_back(Entity::Make(static_cast<unsigned int>(index), generations[index]));
+					}
+					bytes[offset + i] ^= xorBytes[i];
+				}
+				return true;
+			});
+		}
+		valid = valid && DecodeArrayDelta(reader, freeIndices);
+		entityManager->SwapState(generations, freeIndices);
+
+		if (!valid)
+		{
+			std::cerr << "World: the entities of delta " << header.sequence << " are malformed." << std::endl;
+			return false;
+		}
+
+		DeltaStats stats;
+		stats.bytes = size;
+		stats.entityBytes = reader.GetPosition() - sizeof(header);
+
+		//Destroyed entities are dealt with before the components, as their index may already be in use by an entity that receives components below.
+		std::vector<Entity> touched;
+		std::vector<ComponentMask> oldMasks;
+		for (Entity entity : destroyed)
+		{
+			if (entity.Index() < entityMasks.size() && !entityMasks[entity.Index()].IsEmpty())
+			{
+				touched.push_back(entity);
+				oldMasks.push_back(ClearComponents(entity));
+			}
+		}
+		UpdateEntityMasks(touched, oldMasks);
+		touched.clear();
+		oldMasks.clear();
+
+		//The systems are notified once per entity, with the mask it ends up with, just like when command buffers are played back.
+		if (touchedSlots.size() < entityManager->GetIndexCount())
+		{
+			touchedSlots.resize(entityManager->GetIndexCount(), 0);
+		}
+		auto touch = [this, &touched, &oldMasks](Entity entity)
+		{
+			if (touchedSlots[entity.Index()] == 0)
+			{
+				touched.push_back(entity);
+				oldMasks.push_back(GetEntityMask(entity));
+				touchedSlots[entity.Index()] = static_cast<unsigned int>(touched.size());
+			}
+		};
+
+		std::vector<Entity> added;
+		std::vector<Entity> removed;
+		for (uint64_t block = 0; block < header.blockCount && valid; block++)
+		{
+			std::string name = reader.ReadString();
+			uint64_t blockSize = reader.Read<uint64_t>();
+			if (reader.Failed() || blockSize > size - reader.GetPosition())
+			{
+				valid = false;
+				break;
+			}
+
+			//Component types this world does not know about are not replicated.
+			auto type = std::find_if(snapshotComponents.begin(), snapshotComponents.end(), [&name](const SnapshotComponentType& type) { return type.name == name; });
+			if (type == snapshotComponents.end())
+			{
+				reader.ReadBytes(static_cast<size_t>(blockSize));
+				continue;
+			}
+
+			uint64_t blockEnd = reader.GetPosition() + blockSize;
+			added.clear();
+			removed.clear();
+			valid = type->applyDelta(*this, reader, added, removed, stats) && reader.GetPosition() == blockEnd;
+
+			for (Entity entity : added)
+			{
+				touch(entity);
+				GetEntityMask(entity).AddFamily(type->family);
+			}
+			for (Entity entity : removed)
+			{
+				touch(entity);
+				GetEntityMask(entity).RemoveFamily(type->family);
+			}
+		}
+
+		UpdateEntityMasks(touched, oldMasks);
+		for (Entity entity : touched)
+		{
+			touchedSlots[entity.Index()] = 0;
+		}
+
+		if (!valid)
+		{
+			std::cerr << "World: the components of delta " << header.sequence << " are malformed or do not match this world." << std::endl;
+			return false;
+		}
+
+		decoder.sequence = header.sequence;
+		decoder.lastStats = stats;
+		return true;
+	}
+
+	ComponentMask World::ClearComponents(Entity entity)
+	{
+		ComponentMask& mask = GetEntityMask(entity);
+		ComponentMask oldMask = mask;
+
+		//The index of the entity will be recycled, so its components have to go now rather than linger in the component managers.
+		if (storageMode == StorageMode::Archetypes)
+		{
+			archetypes->DestroyEntity(entity);
+		}
+		else
+		{
+			oldMask.ForEachFamily([this, entity](int family)
+			{
+				if (HasComponentManager(family))
+				{
+					componentManagers[family]->DestroyComponent(entity);
+				}
+			});
+		}
+
+		mask = ComponentMask();
+		return oldMask;
+	}
+
+	System* World::AddSystem(std::unique_ptr<EntitySystem::System> system)
 	{
 		system->RegisterWorld(this);
 		systems.push_back(std::move(system));
+		return systems.back().get();
 	}
 
-	void World::UpdateEntityMask(EntitySystem::Entity const& entity, EntitySystem::ComponentMask oldMask) {
-		ComponentMask newMask = entityMasks[entity];
+	void World::UpdateEntityMask(EntitySystem::Entity const& entity, const EntitySystem::ComponentMask& oldMask) {
+		const ComponentMask& newMask = GetEntityMask(entity);
 
 		for (auto& system : systems) {
 			ComponentMask systemSignature = system->GetSignature();
@@ -65,6 +1275,48 @@ namespace EntitySystem
 			}
 		}
 	}
-}
+	void World::ReserveRegistrations(const std::vector<ComponentMask>& masks)
+	{
+		for (auto& system : systems)
+		{
+			ComponentMask signature = system->GetSignature();
+			size_t count = std::count_if(masks.begin(), masks.end(), [&signature](const ComponentMask& mask) { return mask.Matches(signature); });
+			system->registeredEntities.Reserve(system->registeredEntities.size() + count);
+		}
+	}
 
+	void World::UpdateEntityMasks(const std::vector<Entity>& entities, const std::vector<ComponentMask>& oldMasks)
+	{
+		if (entities.size() < BatchMaskUpdateThreshold)
+		{
+			for (size_t i = 0; i < entities.size(); i++)
+			{
+				UpdateEntityMask(entities[i], oldMasks[i]);
+			}
+			return;
+		}
+
+		std::vector<ComponentMask> newMasks(entities.size());
+		for (size_t i = 0; i < entities.size(); i++)
+		{
+			newMasks[i] = GetEntityMask(entities[i]);
+		}
 
+		std::vector<MaskChange> changes(entities.size());
+		for (auto& system : systems)
+		{
+			ComponentMask::CompareBatch(oldMasks.data(), newMasks.data(), entities.size(), system->GetSignature(), changes.data());
+			for (size_t i = 0; i < entities.size(); i++)
+			{
+				if (changes[i] == MaskChange::NewMatch)
+				{
+					system->RegisterEntity(entities[i]);
+				}
+				else if (changes[i] == MaskChange::NoLongerMatched)
+				{
+					system->UnregisterEntity(entities[i]);
+				}
+			}
+		}
+	}
+}
@@ -8,6 +8,19 @@
 #include "ComponentMask.h"
 #include <map>
 #include "ComponentHandle.h"
+#include "Archetype.h"
+#include "View.h"
+#include "GroupView.h"
+#include "JobSystem.h"
+#include "CommandBuffer.h"
+#include "Snapshot.h"
+#include "DeltaSnapshot.h"
+#include "Profiler.h"
+#include "Hierarchy.h"
+#include "Prefab.h"
+#include <cassert>
+#include <mutex>
+#include <thread>
 
 ///How do systems find out that a component has been added or removed?
 ///There are too many interconnected pieces around our component system, and thus the World will be in charge of linking all of them together.
@@ -21,11 +34,31 @@ namespace EntitySystem
 {
     struct EntityHandle;
     class System;
+    class WorldMerge;
+
+    //How the world stores component data.
+    //ComponentPools keeps one ComponentManager per component type, which is the cheapest option when components are added and removed often.
+    //Archetypes groups entities with identical masks into chunks (see Archetype.h), which is the fastest option for systems that iterate several components at once.
+    enum class StorageMode
+    {
+        ComponentPools,
+        Archetypes
+    };
+
+    //How World::Update() runs the systems.
+    //SingleThreaded, the default, updates them one after another on the calling thread, in the same order the parallel schedule respects, which makes debugging deterministic.
+    //Parallel updates systems whose component accesses do not conflict at the same time on the world's job system. It is opt-in: the systems then have to declare their
+    //accesses (see System.h), record structural changes into Commands() instead of changing the world directly, and keep away from any other state they share.
+    enum class SchedulerMode
+    {
+        Parallel,
+        SingleThreaded
+    };
 
     class World 
     {
     public:
-        explicit World(std::unique_ptr<EntityManager> entityManager);
+        explicit World(std::unique_ptr<EntityManager> entityManager, StorageMode storageMode = StorageMode::ComponentPools);
 
         //As we talked about in our discussion about Systems, we have an Initialize method that is called after the basic game initialization happens (systems & first components have been added), but before the game begins to run. 
         //Calling Initialize() on the world will be forwarded to all its systems.
@@ -36,30 +69,68 @@ namespace EntitySystem
         
         //For CreateEntity(), the World communicates with the EntityManager to create a new entity. We then wrap the entity in a pretty handle.
         EntityHandle CreateEntity();
-        void AddSystem(std::unique_ptr<System> system);
+        System* AddSystem(std::unique_ptr<System> system);
+
+        //Destroying an entity removes all of its components and unregisters it from the systems that were acting on it. Its ID then becomes stale (see Entity.h).
         void DestroyEntity(Entity entity);
+        bool IsAlive(Entity entity) const { return entityManager->IsAlive(entity); }
+
+        //Bulk versions of CreateEntity() and DestroyEntity().
+        std::vector<Entity> CreateEntities(unsigned int count) { return entityManager->CreateEntities(count); }
+        void DestroyEntities(const std::vector<Entity>& entities);
+
+        //==== Hierarchy ====
+        //Parents the child to the parent (see Hierarchy.h), giving both a Hierarchy component if they do not have one yet. The child keeps its own subtree.
+        //Entity() as the parent makes the child a root again. The parent may not be the child itself or one of its descendants: that asserts, and leaves the hierarchy as it was in release builds. Not to be called during Update().
+        void SetParent(Entity child, Entity parent);
+        Entity GetParent(Entity entity);
+
+        //Appends every descendant of the entity to "descendants", parents before their children.
+        void GetDescendants(Entity entity, std::vector<Entity>& descendants);
+
+        //Advances every time an entity is reparented, so that systems relying on depths can tell when to sort again.
+        uint32_t GetHierarchyVersion() const { return hierarchyVersion; }
 
         //All component adding and removal will be done through the world. This is because there are actually two things we need to worry about when adding a component:
         //Allocating/deallocating the required space in the component manager.
         //Notifying systems that a component has been added/removed.
 
+        //Replaces the manager of a component type, for example with one that allocates its pages elsewhere (see PageAllocator.h). Has to be called before any component of the type is added.
+        //The world's memory budgets only apply to managers that allocate from the world's arena.
         template <typename ComponentType>
         void AddCustomComponentManager(std::unique_ptr<ComponentManager<ComponentType>> manager) {
+            static_assert(!IsTagComponent<ComponentType>, "Tags have no component manager (see Component.h).");
             int family = GetComponentFamily<ComponentType>();
-            if (family >= componentManagers.size()) {
+            if (family >= static_cast<int>(componentManagers.size())) {
                 componentManagers.resize(family + 1);
             }
-            componentManagers[family] = manager;
+            manager->SetChangeTickSource(&changeTick);
+
+            //The manager it replaces goes away, unless a StaticWorld owns it.
+            BaseComponentManager* replaced = componentManagers[family];
+            ownedComponentManagers.erase(std::remove_if(ownedComponentManagers.begin(), ownedComponentManagers.end(),
+                [replaced](const std::unique_ptr<BaseComponentManager>& owned) { return owned.get() == replaced; }), ownedComponentManagers.end());
+
+            componentManagers[family] = manager.get();
+            ownedComponentManagers.push_back(std::move(manager));
         }
 
         template <typename ComponentType>
         void AddComponent(Entity const& entity, ComponentType&& component) 
         {
-            ComponentManager<ComponentType>* manager = GetComponentManager<ComponentType>();
-            manager->AddComponent(entity, component);
+            if (storageMode == StorageMode::Archetypes)
+            {
+                archetypes->AddComponent(entity, ComponentTypeInfo::Get<ComponentType>(), &component);
+            }
+            else if constexpr (!IsTagComponent<ComponentType>)
+            {
+                ComponentManager<ComponentType>* manager = GetComponentManager<ComponentType>();
+                manager->AddComponent(entity, std::move(component));
+            }
 
-            ComponentMask oldMask = entityMasks[entity];
-            entityMasks[entity].AddComponent<ComponentType>();
+            ComponentMask& mask = GetEntityMask(entity);
+            ComponentMask oldMask = mask;
+            mask.AddComponent<ComponentType>();
 
             UpdateEntityMask(entity, oldMask);
         }
@@ -67,25 +138,43 @@ namespace EntitySystem
         template <typename ComponentType>
         void RemoveComponent(Entity const& entity) 
         {
-            ComponentManager<ComponentType>* manager = GetComponentManager<ComponentType>();
-            ComponentHandle<ComponentType> component = manager->LookupComponent(entity);
-            component.Destroy();
+            if (storageMode == StorageMode::Archetypes)
+            {
+                archetypes->RemoveComponent(entity, GetComponentFamily<ComponentType>());
+            }
+            else if constexpr (!IsTagComponent<ComponentType>)
+            {
+                GetComponentManager<ComponentType>()->DestroyComponent(entity);
+            }
 
-            ComponentMask oldMask = entityMasks[entity];
-            entityMasks[entity].RemoveComponent<ComponentType>();
+            ComponentMask& mask = GetEntityMask(entity);
+            ComponentMask oldMask = mask;
+            mask.RemoveComponent<ComponentType>();
 
             UpdateEntityMask(entity, oldMask);
         }
 
+        //Only looks at the mask of the entity, which is all there is to a tag.
+        template <typename ComponentType>
+        bool HasComponent(Entity entity) { return GetEntityMask(entity).HasFamily(GetComponentFamily<ComponentType>()); }
+
+        //Preallocates storage for "count" components of the given type, so that spawning them later does not allocate pages mid-frame.
+        template <typename ComponentType>
+        void ReserveComponents(unsigned int count) { GetComponentManager<ComponentType>()->Reserve(count); }
+
+        //Releases component pages left empty after a large number of components have been removed (for example after unloading a level).
+        template <typename ComponentType>
+        void ShrinkComponents() { GetComponentManager<ComponentType>()->ShrinkToFit(); }
+
         //Unpack is one of the utility methods that we will use the most when working with our engine. 
         //Unpack gives us a pretty interface to get a bunch of components from an entity. For example, lets say we have a system that wants the Transform, Motion, and Health component for Entity 3. 
         //Instead of needing references to all 3 of those component managers, we simply do the following:
 
+        //Handles to non-const components count as write access and mark the component as changed (see View.h). Unpack into ComponentHandle<const T> to only read it.
+
         template <typename ComponentType, typename... Args>
         void Unpack(Entity e, ComponentHandle<ComponentType>& handle, ComponentHandle<Args>&... args) {
-            typedef ComponentManager<ComponentType> ComponentManagerType;
-            auto mgr = GetComponentManager<ComponentType>();
-            handle = ComponentHandle<ComponentType>(e, mgr->LookupComponent(e), mgr);
+            Unpack(e, handle);
 
             // Recurse
             Unpack<Args...>(e, args...);
@@ -94,33 +183,432 @@ namespace EntitySystem
         // Base case
         template <typename ComponentType>
         void Unpack(Entity e, ComponentHandle<ComponentType>& handle) {
-            typedef ComponentManager<ComponentType> ComponentManagerType;
-            auto mgr = GetComponentManager<ComponentType>();
-            handle = ComponentHandle<ComponentType>(e, mgr->LookupComponent(e), mgr);
+            if constexpr (std::is_const_v<ComponentType>)
+            {
+                handle = ComponentHandle<ComponentType>(e, LookupComponent<std::remove_const_t<ComponentType>>(e), this);
+            }
+            else
+            {
+                handle = ComponentHandle<ComponentType>(e, LookupComponentForWrite<ComponentType>(e), this);
+            }
+        }
+
+        //Stamps the component of the entity with the current tick, for code that modifies components without going through a view or a handle.
+        template <typename ComponentType>
+        void MarkChanged(Entity entity)
+        {
+            LookupComponentForWrite<ComponentType>(entity);
+        }
+
+        //Returns a view over every entity that has all of the given components. See View.h.
+        //The component managers are resolved once here, so the view should be created once per Update() rather than per entity.
+        //Changed<> and Added<> filters let through the components stamped after sinceTick.
+        template <typename... ComponentTypes>
+        EntityView<ComponentTypes...> View(uint32_t sinceTick = 0)
+        {
+            if (storageMode == StorageMode::Archetypes)
+            {
+                return EntityView<ComponentTypes...>(GetChangeTick(), sinceTick, archetypes.get());
+            }
+            return EntityView<ComponentTypes...>(GetChangeTick(), sinceTick, &entityMasks, GetViewManager<typename ViewTerm<ComponentTypes>::StoredType>()...);
+        }
+
+        //Returns the owning group of the given components (see ComponentGroup.h), creating it and sorting their pools the first time.
+        //Every call for a group has to list the same components, and a component can only belong to one group. Only available with StorageMode::ComponentPools.
+        template <typename... ComponentTypes>
+        GroupView<ComponentTypes...> Group()
+        {
+            assert(storageMode == StorageMode::ComponentPools && "Groups are only available with StorageMode::ComponentPools.");
+            static_assert(!(IsTagComponent<ComponentTypes> || ...), "Tags have no pool to group (see Component.h).");
+            std::vector<BaseComponentManager*> managers = { GetComponentManager<std::remove_const_t<ComponentTypes>>()... };
+
+            ComponentGroup* group = managers[0]->GetGroup();
+            if (!group)
+            {
+                groups.push_back(std::make_unique<ComponentGroup>(managers));
+                group = groups.back().get();
+            }
+            assert(group->GetPoolCount() == managers.size() && std::all_of(managers.begin(), managers.end(), [group](BaseComponentManager* manager) { return manager->GetGroup() == group; })
+                && "The components are already grouped differently.");
+
+            return GroupView<ComponentTypes...>(GetChangeTick(), group, GetComponentManager<std::remove_const_t<ComponentTypes>>()...);
+        }
+
+        //The tick component writes are currently stamped with. It advances every time a system finishes updating.
+        uint32_t GetChangeTick() const { return changeTick.load(std::memory_order_relaxed); }
+
+        //Walks every archetype chunk holding all of the given components, calling function(count, entities, components...) with one pointer per column.
+        //This is the fastest way to iterate several components at once, but is only available when the world uses StorageMode::Archetypes.
+        //Components reached this way are not stamped as changed, use MarkChanged() for the ones that are written to.
+        template <typename... ComponentTypes, typename Function>
+        void ForEachChunk(Function&& function)
+        {
+            ComponentMask signature;
+            (signature.AddComponent<ComponentTypes>(), ...);
+
+            archetypes->ForEachMatchingChunk(signature, [&function](Archetype& archetype, ArchetypeChunk& chunk)
+            {
+                function(chunk.count, archetype.GetEntities(chunk), static_cast<ComponentTypes*>(archetype.GetColumnData(chunk, archetype.GetColumn(GetComponentFamily<ComponentTypes>())))...);
+            });
         }
+
+        StorageMode GetStorageMode() const { return storageMode; }
+
+        void SetSchedulerMode(SchedulerMode mode) { schedulerMode = mode; }
+        SchedulerMode GetSchedulerMode() const { return schedulerMode; }
+
+        //Returns the command buffer of the calling thread (see CommandBuffer.h). Systems should record their structural changes there instead of changing the world while it is being updated.
+        CommandBuffer& GetCommandBuffer();
+
+        //Plays back the command buffers of every thread. Update() does this before and after updating the systems, so this only needs to be called for additional sync points.
+        //No thread may record commands while the buffers are played back.
+        void FlushCommands();
+
+        //==== Snapshots ====
+        //Component types are identified in snapshots by the name they are registered under, as families are only assigned at runtime. Unregistered types are not saved.
+        //A component type has to be trivially copyable, or have a ComponentSerializer specialization (see Snapshot.h).
+        template <typename ComponentType>
+        void RegisterSnapshotComponent(const std::string& name)
+        {
+            static_assert(HasComponentSerializer<ComponentType>::value || std::is_trivially_copyable_v<ComponentType>, "Components that are not trivially copyable need a ComponentSerializer to be saved.");
+            assert(name.size() < sizeof(SnapshotBlock::name) && "Snapshot component names are limited to 63 characters.");
+
+            snapshotComponents.push_back({ name, GetComponentFamily<ComponentType>(),
+                [](World& world, SnapshotWriter& writer, SnapshotBlock& block) { world.GetComponentManager<ComponentType>()->SaveSnapshot(writer, block); },
+                [](World& world, const std::shared_ptr<MemoryMappedFile>& file, const SnapshotBlock& block) { return world.GetComponentManager<ComponentType>()->LoadSnapshot(file, block); },
+                [](World& world, SnapshotWriter& writer, ComponentDeltaBaseline& baseline, uint32_t sinceTick, DeltaStats& stats)
+                {
+                    world.GetComponentManager<ComponentType>()->EncodeDelta(writer, baseline, sinceTick, world.entityManager->GetGenerations(), stats);
+                },
+                [](World& world, SnapshotReader& reader, std::vector<Entity>& added, std::vector<Entity>& removed, DeltaStats& stats)
+                {
+                    return world.GetComponentManager<ComponentType>()->ApplyDelta(reader, world.entityManager->GetGenerations(), added, removed, stats);
+                } });
+        }
+
+        //Writes every entity and every registered component to a file. Commands still waiting in command buffers are not part of the snapshot.
+        //Only available with StorageMode::ComponentPools. Returns false (and reports why on std::cerr) on failure.
+        bool SaveSnapshot(const std::string& path);
+
+        //Restores a snapshot into a world without any live entity (a new world, or one that has just been Reset()), registering the loaded entities with the systems.
+        //The file is mapped into memory, and stays mapped for as long as the component managers use pages from it. A load that fails leaves the world empty, as after Reset().
+        bool LoadSnapshot(const std::string& path);
+
+        //Appends everything that changed since the previous call with the same encoder to "stream", which is cleared first (see DeltaSnapshot.h).
+        //The first delta of an encoder holds the whole world. Only registered component types are part of a delta, and commands still waiting in command buffers are not.
+        //Only available with StorageMode::ComponentPools.
+        bool EncodeDelta(DeltaEncoder& encoder, std::vector<unsigned char>& stream);
+
+        //Applies a delta to this world, which has to have received every previous delta of the stream through the same decoder (or, for the first one, not to have any live entity).
+        //Changes count as writes at the current tick, so Changed<> and Added<> filters pick them up. If applying fails halfway, the world is left out of sync with the stream and has to be rebuilt.
+        bool ApplyDelta(DeltaDecoder& decoder, const unsigned char* data, size_t size);
+
+        //The job pool used for parallel system updates, created on first use.
+        JobSystem& GetJobSystem();
+
+        //Replaces the job pool with one of the given size. By default, one worker is created per hardware thread minus one.
+        void SetWorkerCount(unsigned int workerCount) { jobSystem = std::make_unique<JobSystem>(workerCount); }
+
+        //==== Profiling ====
+        //Statistics over the frames still held by the profiler (see Profiler.h): the whole frame, the command buffer flushes, then every system in the order it was added.
+        //Call these between updates. Without ECS_ENABLE_PROFILER, there are no statistics and WriteChromeTrace() fails.
+        std::vector<ProfileStats> GetProfileStats() const;
+        bool WriteChromeTrace(const std::string& path) const;
+        void ClearProfile() { profiler.Clear(); }
+
+        //==== Memory ====
+        //Component pages and archetype chunks are allocated from the world's arena (see PageAllocator.h), in large blocks backed by huge pages where possible.
+
+        //Aborts with a message once the components of the given type would take more than "bytes" of pages. 0 removes the budget.
+        template <typename ComponentType>
+        void SetComponentBudget(size_t bytes) { arena.SetBudget(GetComponentFamily<ComponentType>(), bytes); }
+
+        //Bytes of pages currently allocated for components of the given type, in component pool storage.
+        template <typename ComponentType>
+        size_t GetComponentMemory() const { return arena.GetUsage(GetComponentFamily<ComponentType>()); }
+
+        const ComponentArena& GetArena() const { return arena; }
+
+        //Destroys every entity, component and pending command at once, and gives the arena's blocks back to the OS, typically when unloading a level.
+        //Component destructors still run, but nothing is moved or unregistered one entity at a time. Systems, budgets, snapshot registrations and the profile are kept.
+        //Every existing entity becomes stale, and delta streams (see DeltaSnapshot.h) have to start over. Not to be called during Update().
+        void Reset();
+
+        //==== Prefabs ====
+        //Captures a copy of every component of the entity (see Prefab.h). Only available with StorageMode::ComponentPools.
+        //Aborts if one of the components cannot be copied, as instances would otherwise claim components they never got.
+        Prefab CreatePrefab(Entity entity);
+
+        //Creates "count" entities with a copy of every component of the prefab, and registers them with the systems, all in bulk. Not to be called during Update().
+        std::vector<Entity> Instantiate(const Prefab& prefab, unsigned int count);
+
+        //==== Streaming ====
+        //Moves every entity of the staging world into this one in a single bulk operation, and returns the entities they became (see WorldStreaming.h).
+        //The staging world is Reset() afterwards. WorldMerge spreads the same work over several frames.
+        std::vector<Entity> Merge(World& staging);
+
+        //Moves the entities, along with their descendants, into the staging world, and returns the entities they became there. They are destroyed in this world.
+        std::vector<Entity> Extract(const std::vector<Entity>& entities, World& staging);
         
     private:
+        friend class CommandBuffer;
+        friend class WorldMerge;
+
+        template <typename... ComponentTypes>
+        friend class StaticWorld;
+
+        //The order systems are updated in, and which systems have to wait for which. Systems may change their declarations at runtime,
+        //so the declarations it was built from are kept, and it is only rebuilt when a system is added or one of them changes.
+        struct SystemSchedule
+        {
+            std::vector<size_t> order;
+            std::vector<std::vector<size_t>> dependents;
+            std::vector<unsigned int> dependencyCount;
+
+            //Indexed like the systems.
+            std::vector<ComponentMask> readMasks;
+            std::vector<ComponentMask> writeMasks;
+            std::vector<std::vector<System*>> runAfter;
+        };
+
+        struct SnapshotComponentType
+        {
+            std::string name;
+            int family;
+            void (*save)(World& world, SnapshotWriter& writer, SnapshotBlock& block);
+            bool (*load)(World& world, const std::shared_ptr<MemoryMappedFile>& file, const SnapshotBlock& block);
+            void (*encodeDelta)(World& world, SnapshotWriter& writer, ComponentDeltaBaseline& baseline, uint32_t sinceTick, DeltaStats& stats);
+            bool (*applyDelta)(World& world, SnapshotReader& reader, std::vector<Entity>& added, std::vector<Entity>& removed, DeltaStats& stats);
+        };
+
+        bool IsScheduleCurrent();
+        void BuildSchedule();
+        void RunScheduleInParallel(int deltaTime);
+
+        //Updates the system, and then advances the change tick so that whatever happens next counts as a change to it.
+        void UpdateSystem(size_t index, int deltaTime);
+
+        //FlushCommands() without the profiling. Returns the number of commands played back.
+        size_t PlayBackCommands();
+
+        std::vector<std::string> GetSystemNames() const;
+
+        StorageMode storageMode;
+        SchedulerMode schedulerMode = SchedulerMode::SingleThreaded;
+        std::unique_ptr<JobSystem> jobSystem;
+        SystemSchedule schedule;
+        ComponentArena arena;  //Declared before the storage allocating from it, so that it outlives it.
+        std::unique_ptr<ArchetypeStorage> archetypes;
         std::unique_ptr<EntityManager> entityManager;
         std::vector<std::unique_ptr<System>> systems;
-        std::vector<std::unique_ptr<BaseComponentManager>> componentManagers;
-        std::map<Entity, ComponentMask> entityMasks;
+        std::vector<BaseComponentManager*> componentManagers;  //Indexed by family. Most are owned by the world, the others by a StaticWorld (see StaticWorld.h).
+        std::vector<std::unique_ptr<BaseComponentManager>> ownedComponentManagers;
+        std::vector<std::unique_ptr<ComponentGroup>> groups;
+        std::vector<ComponentMask> entityMasks;  //Indexed by entity index.
+        std::atomic<uint32_t> changeTick{ 1 };
+        uint32_t hierarchyVersion = 0;
+        Profiler profiler;
+
+        uint64_t worldID;  //Unique for the lifetime of the program, so that threads can cache their command buffer without mixing up worlds.
+        std::mutex commandBufferMutex;
+        std::vector<std::pair<std::thread::id, std::unique_ptr<CommandBuffer>>> commandBuffers;
+        std::vector<EntityCommand> pendingCommands;
+        std::vector<unsigned int> touchedSlots;  //Indexed by entity index. Position + 1 of the entity in the list of entities touched by the current flush, or 0.
+        std::vector<SnapshotComponentType> snapshotComponents;
+
+        ComponentMask& GetEntityMask(Entity entity)
+        {
+            if (entity.Index() >= entityMasks.size())
+            {
+                entityMasks.resize(entity.Index() + 1);
+            }
+            return entityMasks[entity.Index()];
+        }
 
-        void UpdateEntityMask(Entity const& entity, ComponentMask oldMask);
+        void UpdateEntityMask(Entity const& entity, const ComponentMask& oldMask);
+
+        //Batch version of UpdateEntityMask(), for when many entities changed at once. Each system signature is tested against all of the masks in one pass.
+        void UpdateEntityMasks(const std::vector<Entity>& entities, const std::vector<ComponentMask>& oldMasks);
+
+        //Makes room in every system for the entities of the given masks it is about to register, so that registering them later does not have to grow its set.
+        void ReserveRegistrations(const std::vector<ComponentMask>& masks);
+
+        //Below this many entities, UpdateEntityMasks() just calls UpdateEntityMask() for each of them.
+        static constexpr size_t BatchMaskUpdateThreshold = 32;
+
+        //Destroys every component of the entity and clears its mask, returning the mask it had. Systems are not notified.
+        ComponentMask ClearComponents(Entity entity);
+
+        bool HasHierarchy(Entity entity);
+
+        //Detaches the entity the node belongs to from its parent and siblings, leaving its own subtree alone.
+        void Unlink(Hierarchy& node);
+
+        //Appends the descendants of the listed entities that are not listed yet, and detaches the roots of the subtrees (entities whose parent is not listed) from their parents,
+        //before destroying or extracting all of them.
+        void AddDescendants(std::vector<Entity>& entities);
+
+        template <typename ComponentType>
+        ComponentType* LookupComponent(Entity entity)
+        {
+            if constexpr (IsTagComponent<ComponentType>)
+            {
+                return HasComponent<ComponentType>(entity) ? &GetTagInstance<ComponentType>() : nullptr;
+            }
+            else if (storageMode == StorageMode::Archetypes)
+            {
+                return static_cast<ComponentType*>(archetypes->GetComponent(entity, GetComponentFamily<ComponentType>()));
+            }
+            else
+            {
+                return GetComponentManager<ComponentType>()->LookupComponent(entity);
+            }
+        }
+
+        //Same as LookupComponent(), but also marks the component as changed.
+        template <typename ComponentType>
+        ComponentType* LookupComponentForWrite(Entity entity)
+        {
+            if constexpr (IsTagComponent<ComponentType>)
+            {
+                return HasComponent<ComponentType>(entity) ? &GetTagInstance<ComponentType>() : nullptr;
+            }
+            else if (storageMode == StorageMode::Archetypes)
+            {
+                return static_cast<ComponentType*>(archetypes->GetComponentForWrite(entity, GetComponentFamily<ComponentType>()));
+            }
+            else
+            {
+                return GetComponentManager<ComponentType>()->LookupComponentForWrite(entity);
+            }
+        }
+
+        //False for tags, which only live in the entity masks.
+        bool HasComponentManager(int family) const { return family < static_cast<int>(componentManagers.size()) && componentManagers[family]; }
+
+        //The manager of the family, created like the given manager of another world if there is none yet.
+        BaseComponentManager* GetComponentManagerLike(int family, const BaseComponentManager& other);
 
         template <typename ComponentType>
         ComponentManager<ComponentType>* GetComponentManager() 
         {
+            static_assert(!IsTagComponent<ComponentType>, "Tags have no component manager (see Component.h).");
             int family = GetComponentFamily<ComponentType>();
 
-            if (family >= componentManagers.size()) {
+            if (family >= static_cast<int>(componentManagers.size())) {
                 componentManagers.resize(family + 1);
             }
 
             if (!componentManagers[family]) {
-                componentManagers[family] = std::make_unique<ComponentManager<ComponentType>>();
+                ownedComponentManagers.push_back(std::make_unique<ComponentManager<ComponentType>>(arena));
+                componentManagers[family] = ownedComponentManagers.back().get();
+                componentManagers[family]->SetChangeTickSource(&changeTick);
             }
 
-            return static_cast<ComponentManager<ComponentType>*>(componentManagers[family].get());
+            return static_cast<ComponentManager<ComponentType>*>(componentManagers[family]);
+        }
+
+        //The manager a view reads the component from: none for tags, which views test against the entity masks instead.
+        template <typename ComponentType>
+        ComponentManager<ComponentType>* GetViewManager()
+        {
+            if constexpr (IsTagComponent<ComponentType>)
+            {
+                return nullptr;
+            }
+            else
+            {
+                return GetComponentManager<ComponentType>();
+            }
         }
     };
+
+    template <typename ComponentType>
+    void ComponentHandle<ComponentType>::Destroy()
+    {
+        world->RemoveComponent<std::remove_const_t<ComponentType>>(owner);
+    }
+
+    template <typename ComponentType>
+    void CommandBuffer::PlayBack(World& world, EntityCommand* commands, size_t count)
+    {
+        int family = GetComponentFamily<ComponentType>();
+        bool pools = world.storageMode == StorageMode::ComponentPools;
+        ComponentManager<ComponentType>* manager = nullptr;
+        if constexpr (!IsTagComponent<ComponentType>)
+        {
+            manager = pools ? world.GetComponentManager<ComponentType>() : nullptr;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            EntityCommand& command = commands[i];
+            ComponentType* component = static_cast<ComponentType*>(command.component);
+
+            if (world.IsAlive(command.entity))
+            {
+                ComponentMask& mask = world.GetEntityMask(command.entity);
+                bool present = mask.HasFamily(family);
+
+                if (command.type == EntityCommandType::AddComponent)
+                {
+                    if (!pools)
+                    {
+                        world.archetypes->AddComponent(command.entity, command.typeInfo, component);
+                    }
+                    else if (manager)
+                    {
+                        if (present)
+                        {
+                            manager->DestroyComponent(command.entity);
+                        }
+                        manager->AddComponent(command.entity, std::move(*component));
+                    }
+                    mask.AddComponent<ComponentType>();
+                }
+                else if (present)
+                {
+                    if (!pools)
+                    {
+                        world.archetypes->RemoveComponent(command.entity, family);
+                    }
+                    else if (manager)
+                    {
+                        manager->DestroyComponent(command.entity);
+                    }
+                    mask.RemoveComponent<ComponentType>();
+                }
+            }
+
+            //The component has been moved into the world (or the entity is gone), either way the buffer's copy is done with.
+            if (component)
+            {
+                component->~ComponentType();
+            }
+        }
+    }
+
+    template <typename... ComponentTypes, typename Function>
+    void System::Each(Function&& function)
+    {
+        parentWorld->View<ComponentTypes...>(lastChangeTick).Each(std::forward<Function>(function));
+    }
+
+    template <typename... ComponentTypes, typename Function>
+    void System::ParallelEach(Function&& function, unsigned int minimumBatchSize)
+    {
+        parentWorld->View<ComponentTypes...>(lastChangeTick).ParallelEach(parentWorld->GetJobSystem(), std::forward<Function>(function), minimumBatchSize);
+    }
+
+    template <typename... ComponentTypes, typename Function>
+    void System::EachSpan(Function&& function)
+    {
+        parentWorld->View<ComponentTypes...>(lastChangeTick).EachSpan(std::forward<Function>(function));
+    }
+
+    template <typename... ComponentTypes, typename Function>
+    void System::EachSlice(Function&& function)
+    {
+        parentWorld->View<ComponentTypes...>(lastChangeTick).EachSlice(std::forward<Function>(function), currentSlice, timeSlices);
+    }
 }
\ No newline at end of file
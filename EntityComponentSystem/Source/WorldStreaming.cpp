@@ -0,0 +1,116 @@
+#include "ECSPrecompiledHeader.h"
+#include "WorldStreaming.h"
+#include "World.h"
+#include <chrono>
+
+namespace EntitySystem
+{
+	WorldMerge::WorldMerge(World& target, World& staging) : target(target), staging(staging)
+	{
+		assert(&target != &staging);
+		assert(target.GetStorageMode() == StorageMode::ComponentPools && staging.GetStorageMode() == StorageMode::ComponentPools && "Merging worlds is only supported with StorageMode::ComponentPools.");
+
+		//Indices that are neither free nor reserved belong to live entities.
+		const std::vector<unsigned int>& generations = staging.entityManager->GetGenerations();
+		std::vector<bool> free(generations.size(), false);
+		for (unsigned int index : staging.entityManager->GetFreeIndices())
+		{
+			free[index] = true;
+		}
+		for (unsigned int index = 1; index < generations.size(); index++)
+		{
+			if (!free[index])
+			{
+				stagingEntities.push_back(Entity::Make(index, generations[index]));
+			}
+		}
+
+		entities = target.CreateEntities(static_cast<unsigned int>(stagingEntities.size()));
+		for (size_t i = 0; i < entities.size(); i++)
+		{
+			remap.Add(stagingEntities[i], entities[i]);
+		}
+
+		for (size_t family = 0; family < staging.componentManagers.size(); family++)
+		{
+			BaseComponentManager* source = staging.componentManagers[family];
+			if (source && source->GetComponentCount() > 0)
+			{
+				pools.push_back({ source, target.GetComponentManagerLike(static_cast<int>(family), *source), 1 });
+				pools.back().target->Reserve(pools.back().target->GetComponentCount() + source->GetComponentCount());
+			}
+		}
+
+		//Everything that grows with the number of entities or components is grown here, once: a step growing a large vector of the live world would blow its budget.
+		std::vector<ComponentMask> masks(stagingEntities.size());
+		size_t last = 0;
+		for (size_t i = 0; i < stagingEntities.size(); i++)
+		{
+			masks[i] = staging.GetEntityMask(stagingEntities[i]);
+			last = entities[i].Index() > entities[last].Index() ? i : last;
+		}
+		if (!entities.empty())
+		{
+			target.GetEntityMask(entities[last]);
+		}
+		target.ReserveRegistrations(masks);
+	}
+
+	bool WorldMerge::Step(double budgetMilliseconds)
+	{
+		if (done)
+		{
+			return true;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		auto overBudget = [budgetMilliseconds, start]()
+		{
+			return budgetMilliseconds > 0.0 && std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= budgetMilliseconds;
+		};
+
+		while (nextPool < pools.size())
+		{
+			Pool& pool = pools[nextPool];
+			unsigned int end = pool.source->GetComponentCount() + 1;
+			unsigned int count = std::min(BatchSize, end - pool.next);
+			pool.target->AppendFrom(*pool.source, pool.source->GetEntities() + pool.next, count, remap);
+			pool.next += count;
+			if (pool.next == end)
+			{
+				nextPool++;
+			}
+
+			if (overBudget())
+			{
+				return false;
+			}
+		}
+
+		//Families are the same in every world, so the masks carry over as they are. Systems register the entities in batches.
+		std::vector<Entity> batch;
+		std::vector<ComponentMask> oldMasks;
+		while (nextMask < entities.size())
+		{
+			size_t end = std::min<size_t>(nextMask + BatchSize, entities.size());
+			batch.assign(entities.begin() + nextMask, entities.begin() + end);
+			oldMasks.assign(batch.size(), ComponentMask());
+			for (size_t i = nextMask; i < end; i++)
+			{
+				target.GetEntityMask(entities[i]) = staging.GetEntityMask(stagingEntities[i]);
+			}
+			target.UpdateEntityMasks(batch, oldMasks);
+			nextMask = end;
+
+			if (nextMask < entities.size() && overBudget())
+			{
+				return false;
+			}
+		}
+
+		target.hierarchyVersion++;
+		staging.Reset();
+		done = true;
+		return true;
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "ECSPrecompiledHeader.h"
+#include "Entity.h"
+#include "ComponentManager.h"
+
+///==== World Streaming ====
+
+///Loading a region of a large map one CreateEntity() and AddComponent() at a time would have to happen on the game thread, and costs a lookup per component.
+///Instead, a region is built in a staging World of its own, which nothing else touches, so it can be populated on a background thread: procedurally, or with LoadSnapshot().
+///The staging world is then merged into the live one: its entities are created in bulk under new IDs, and its component pools are appended to the live ones,
+///in runs copied with memcpy for trivially copyable components, with the entities they reference remapped (see ComponentEntityRemapper in ComponentManager.h).
+
+///A WorldMerge can be spread over several frames, by giving Step() a time budget. The entities exist in the live world from the start, but systems only
+///get to see them (through their masks) once all of their components are in. Views iterating the pools directly may meet components of entities not complete yet.
+///Growing the arrays of the live world for the region is left to the constructor, so that no step has to copy them: reserving components ahead (see World::ReserveComponents())
+///keeps the constructor cheap as well.
+///The reverse, World::Extract(), moves a region out of the live world into a staging world, which can then be saved or thrown away off the game thread.
+
+///Both worlds need StorageMode::ComponentPools. Component families are shared by every world of the program, so staging worlds need no registration.
+
+namespace EntitySystem
+{
+    class World;
+
+    class WorldMerge
+    {
+    public:
+        //Creates the entities of "staging" in "target" right away, and makes room for everything else, so that the steps do not have to. The components follow with Step().
+        //Neither world may be modified in other ways before the merge is done, apart from "target" being updated.
+        WorldMerge(World& target, World& staging);
+        WorldMerge(const WorldMerge&) = delete;
+        WorldMerge& operator=(const WorldMerge&) = delete;
+
+        //Merges for about "budgetMilliseconds" (everything that is left with 0), returning true once the merge is done. The staging world is then Reset(), ready for the next region.
+        //Work is done a page worth of components at a time, so a step can overrun its budget by that much.
+        bool Step(double budgetMilliseconds = 0.0);
+        bool IsDone() const { return done; }
+
+        //The entities the staging ones became in the target world, in the order of their staging indices.
+        const std::vector<Entity>& GetEntities() const { return entities; }
+        Entity Remap(Entity stagingEntity) const { return remap(stagingEntity); }
+
+        //How many components or entities are merged between two looks at the clock.
+        static constexpr unsigned int BatchSize = 1024;
+
+    private:
+        struct Pool
+        {
+            BaseComponentManager* source;
+            BaseComponentManager* target;
+            unsigned int next;  //The next instance of the source to append.
+        };
+
+        World& target;
+        World& staging;
+        std::vector<Entity> stagingEntities;
+        std::vector<Entity> entities;
+        EntityRemap remap;
+        std::vector<Pool> pools;
+        size_t nextPool = 0;
+        size_t nextMask = 0;  //The next entity to give its mask, once every pool is merged.
+        bool done = false;
+    };
+}